@@ -0,0 +1,7 @@
+function bench()
+    var sum=0
+    for i=0,i<100000,++i
+        sum+=i*2-i/2+i%7
+    end
+    return sum
+end
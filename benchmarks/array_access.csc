@@ -0,0 +1,14 @@
+function bench()
+    var arr={}
+    for i=0,i<20000,++i
+        arr.push_back(i)
+    end
+    var sum=0
+    for i=0,i<arr.size(),++i
+        sum+=arr[i]
+    end
+    foreach it in arr
+        sum+=it
+    end
+    return sum
+end
@@ -0,0 +1,7 @@
+function bench()
+    var sum=0
+    for i=0,i<50000,++i
+        sum+=math.abs(-i)
+    end
+    return sum
+end
@@ -0,0 +1,17 @@
+math.seed(3)
+var keys=math.randint_array(20000,0,1000000)
+
+function bench()
+    var queue=new priority_queue
+    var map=new ordered_map
+    foreach it in keys
+        queue.push(it)
+        map.insert(it,it)
+    end
+    var sum=0
+    while !queue.empty()
+        sum+=queue.top()
+        queue.pop()
+    end
+    return sum+map.range(250000,750000).size()
+end
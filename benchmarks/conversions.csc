@@ -0,0 +1,21 @@
+var words=new array
+foreach i in range(20000)
+    words.push_back(to_string(i)+" word")
+end
+
+function bench()
+    var pairs=new array
+    foreach it in words
+        pairs.push_back(it:it)
+    end
+    var map=move(pairs).to_hash_map()
+    var lst=words.to_list()
+    var count=0
+    foreach it in map.keys()
+        ++count
+    end
+    foreach it in lst.view(100,1000)
+        ++count
+    end
+    return count+move(lst).to_array().size()
+end
@@ -0,0 +1,10 @@
+function add(a,b)
+    return a+b
+end
+function bench()
+    var sum=0
+    for i=0,i<50000,++i
+        sum=add(sum,i)
+    end
+    return sum
+end
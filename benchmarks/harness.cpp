@@ -0,0 +1,399 @@
+/*
+* Covariant Script Benchmark Harness
+*
+* Licensed under the Covariant Innovation General Public License,
+* Version 1.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* https://covariant.cn/licenses/LICENSE-1.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* Copyright (C) 2019 Michael Lee(李登淳)
+* Email: mikecovlee@163.com
+* Github: https://github.com/mikecovlee
+* Website: http://covscript.org
+*
+* Usage: bench-covscript [options...] <FILES...>
+* Every script must define a function called "bench" which runs one repetition of the workload.
+* Results are printed as JSON, so that the outputs of different builds can be compared.
+*/
+#include <covscript_impl/text/text.hpp>
+#include <covscript/covscript.hpp>
+#include <iostream>
+#include <atomic>
+#include <chrono>
+#include <new>
+
+// Allocation Counter
+static std::atomic<std::size_t> allocation_count(0);
+
+void *operator new(std::size_t size)
+{
+	++allocation_count;
+	void *ptr = std::malloc(size == 0 ? 1 : size);
+	if (ptr == nullptr)
+		throw std::bad_alloc();
+	return ptr;
+}
+
+void *operator new[](std::size_t size)
+{
+	return operator new(size);
+}
+
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept
+{
+	++allocation_count;
+	return std::malloc(size == 0 ? 1 : size);
+}
+
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept
+{
+	return operator new(size, std::nothrow);
+}
+
+void operator delete(void *ptr) noexcept
+{
+	std::free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept
+{
+	std::free(ptr);
+}
+
+void operator delete(void *ptr, std::size_t) noexcept
+{
+	std::free(ptr);
+}
+
+void operator delete[](void *ptr, std::size_t) noexcept
+{
+	std::free(ptr);
+}
+
+namespace cs_bench {
+	struct options_type final {
+		std::size_t warmup = 2;
+		std::size_t repeat = 10;
+		std::string filter;
+		std::string output;
+		std::vector<std::string> files;
+	} options;
+
+	struct result_type final {
+		std::string name;
+		std::vector<double> samples;
+		std::vector<std::size_t> allocations;
+	};
+
+	struct native_case final {
+		std::string name;
+		std::function<void()> func;
+	};
+
+	std::vector<result_type> results;
+
+	std::vector<native_case> native_cases;
+
+	template<typename T>
+	T percentile(std::vector<T> data, double p)
+	{
+		if (data.empty())
+			return T();
+		std::sort(data.begin(), data.end());
+		std::size_t rank = static_cast<std::size_t>(std::ceil(p * data.size()));
+		return data[rank == 0 ? 0 : rank - 1];
+	}
+
+	bool match_filter(const std::string &name)
+	{
+		return options.filter.empty() || name.find(options.filter) != std::string::npos;
+	}
+
+	void run_case(const std::string &name, const std::function<void()> &func)
+	{
+		if (!match_filter(name))
+			return;
+		for (std::size_t i = 0; i < options.warmup; ++i)
+			func();
+		result_type result;
+		result.name = name;
+		for (std::size_t i = 0; i < options.repeat; ++i) {
+			std::size_t alloc_begin = allocation_count;
+			auto time_begin = std::chrono::steady_clock::now();
+			func();
+			auto time_end = std::chrono::steady_clock::now();
+			result.allocations.push_back(allocation_count - alloc_begin);
+			result.samples.push_back(std::chrono::duration<double, std::milli>(time_end - time_begin).count());
+		}
+		std::cerr << name << ": " << percentile(result.samples, 0.5) << "ms" << std::endl;
+		results.push_back(std::move(result));
+	}
+
+	std::string case_name(const std::string &path)
+	{
+		std::string name = path;
+		std::size_t pos = name.find_last_of("/\\");
+		if (pos != std::string::npos)
+			name = name.substr(pos + 1);
+		pos = name.rfind('.');
+		if (pos != std::string::npos)
+			name = name.substr(0, pos);
+		return name;
+	}
+
+	std::string parent_path(const std::string &path)
+	{
+		std::size_t pos = path.find_last_of("/\\");
+		if (pos != std::string::npos)
+			return path.substr(0, pos);
+		else
+			return ".";
+	}
+
+	void run_script(const std::string &path)
+	{
+		std::string name = case_name(path);
+		cs::current_process->import_path = parent_path(path) + cs::path_delimiter + cs::get_import_path();
+		// Compile time of the whole script, including the imports at compile time
+		run_case(name + ".compile", [&path]() {
+			cs::context_t context = cs::create_context(cs::parse_cmd_args(0, nullptr));
+			context->instance->compile(path);
+			cs::collect_garbage(context);
+		});
+		cs::context_t context = cs::create_context(cs::parse_cmd_args(0, nullptr));
+		try {
+			context->instance->compile(path);
+			context->instance->interpret();
+			cs::function_invoker<void()> bench(cs::eval(context, "bench"));
+			run_case(name, [&bench]() {
+				bench();
+			});
+		}
+		catch (...) {
+			cs::collect_garbage(context);
+			throw;
+		}
+		cs::collect_garbage(context);
+	}
+
+	// Implementations before the dedicated formatter and parser, kept as the baseline
+	std::string format_number_stream(cs::number val, int precision)
+	{
+		std::stringstream ss;
+		std::string str;
+		ss << std::setprecision(precision) << val;
+		ss >> str;
+		return str;
+	}
+
+	cs::number parse_number_stold(const std::string &str)
+	{
+		int point_count = 0;
+		for (auto &ch:str) {
+			if (!std::isdigit(ch)) {
+				if (ch != '.' || ++point_count > 1)
+					throw cs::runtime_error("Wrong literal format.");
+			}
+		}
+		return std::stold(str);
+	}
+
+	std::vector<cs::number> number_samples()
+	{
+		std::vector<cs::number> samples;
+		for (std::size_t i = 0; i < 100000; ++i)
+			samples.push_back(i % 2 == 0 ? cs::number(i) : cs::number(i) / 7);
+		return samples;
+	}
+
+	void register_native_cases(const cs::context_t &context)
+	{
+		// Number formatting and parsing
+		auto samples = std::make_shared<std::vector<cs::number>>(number_samples());
+		auto strings = std::make_shared<std::vector<std::string>>();
+		for (auto &it:*samples)
+			strings->push_back(cs::format_number(it, 8));
+		native_cases.push_back({"native.number_format", [samples]() {
+				for (auto &it:*samples)
+					cs::format_number(it, 8);
+			}
+		});
+		native_cases.push_back({"native.number_format_stream", [samples]() {
+				for (auto &it:*samples)
+					format_number_stream(it, 8);
+			}
+		});
+		native_cases.push_back({"native.number_parse", [strings]() {
+				for (auto &it:*strings)
+					cs::parse_number(it);
+			}
+		});
+		native_cases.push_back({"native.number_parse_stold", [strings]() {
+				for (auto &it:*strings)
+					parse_number_stold(it);
+			}
+		});
+		// Text scanning over 8MB, the vectorized implementations against the scalar ones
+		auto text = std::make_shared<std::string>();
+		while (text->size() < 8 * 1024 * 1024)
+			text->append("2019-01-01 00:00:00,INFO,request served,path=/index.html;status=200\n");
+		auto delims = std::make_shared<cs_impl::text::char_set>();
+		delims->add(',');
+		delims->add(';');
+		delims->add('\n');
+		// Results are accumulated, so that the scanning is not optimized out
+		auto sink = std::make_shared<std::size_t>(0);
+		native_cases.push_back({"native.text_split", [text, delims, sink]() {
+				cs_impl::text::for_each_of(text->data(), text->size(), *delims, [sink](std::size_t pos) {
+					*sink += pos;
+				});
+			}
+		});
+		native_cases.push_back({"native.text_split_scalar", [text, delims, sink]() {
+				cs_impl::text::for_each_of_scalar(text->data(), text->size(), *delims, [sink](std::size_t pos) {
+					*sink += pos;
+				});
+			}
+		});
+		native_cases.push_back({"native.text_find", [text, sink]() {
+				*sink += cs_impl::text::find(text->data(), text->size(), "status=404", 10);
+			}
+		});
+		native_cases.push_back({"native.text_find_scalar", [text, sink]() {
+				*sink += cs_impl::text::find_scalar(text->data(), text->size(), "status=404", 10);
+			}
+		});
+		native_cases.push_back({"native.text_case", [text]() {
+				cs_impl::text::to_upper(&(*text)[0], text->size());
+				cs_impl::text::to_lower(&(*text)[0], text->size());
+			}
+		});
+		native_cases.push_back({"native.text_case_scalar", [text]() {
+				cs_impl::text::flip_case_scalar(&(*text)[0], text->size(), 'a', 'z');
+				cs_impl::text::flip_case_scalar(&(*text)[0], text->size(), 'A', 'Z');
+			}
+		});
+		// Overhead of calling a CNI function from native code
+		cs::var func = cs::eval(context, "to_integer");
+		native_cases.push_back({"native.cni_invoke", [func]() {
+				for (std::size_t i = 0; i < 100000; ++i)
+					cs::invoke(func, cs::var::make<cs::number>(i));
+			}
+		});
+	}
+
+	void run_native()
+	{
+		cs::context_t context = cs::create_context(cs::parse_cmd_args(0, nullptr));
+		try {
+			register_native_cases(context);
+			for (auto &it:native_cases)
+				run_case(it.name, it.func);
+		}
+		catch (...) {
+			native_cases.clear();
+			cs::collect_garbage(context);
+			throw;
+		}
+		native_cases.clear();
+		cs::collect_garbage(context);
+	}
+
+	void print_json(std::ostream &out)
+	{
+		out << "{\n\t\"version\": \"" << cs::current_process->version << "\",\n";
+		out << "\t\"warmup\": " << options.warmup << ",\n";
+		out << "\t\"repeat\": " << options.repeat << ",\n";
+		out << "\t\"cases\": [";
+		for (std::size_t i = 0; i < results.size(); ++i) {
+			const result_type &result = results[i];
+			double sum = 0;
+			for (auto &it:result.samples)
+				sum += it;
+			out << (i == 0 ? "\n" : ",\n");
+			out << "\t\t{\n";
+			out << "\t\t\t\"name\": \"" << result.name << "\",\n";
+			out << "\t\t\t\"median_ms\": " << percentile(result.samples, 0.5) << ",\n";
+			out << "\t\t\t\"p95_ms\": " << percentile(result.samples, 0.95) << ",\n";
+			out << "\t\t\t\"mean_ms\": " << sum / result.samples.size() << ",\n";
+			out << "\t\t\t\"min_ms\": " << percentile(result.samples, 0) << ",\n";
+			out << "\t\t\t\"allocations\": " << percentile(result.allocations, 0.5) << "\n";
+			out << "\t\t}";
+		}
+		cs::allocator_stats pool = cs::allocator_registry::get().total();
+		out << "\n\t],\n";
+		out << "\t\"pool\": {\n";
+		out << "\t\t\"slabs\": " << pool.slab_count << ",\n";
+		out << "\t\t\"capacity\": " << pool.capacity << ",\n";
+		out << "\t\t\"in_use\": " << pool.in_use << ",\n";
+		out << "\t\t\"acquired\": " << pool.acquired << ",\n";
+		out << "\t\t\"released\": " << pool.released << "\n";
+		out << "\t}\n}" << std::endl;
+	}
+
+	void parse_args(int args_size, const char *args[])
+	{
+		for (int index = 1; index < args_size; ++index) {
+			std::string arg = args[index];
+			if ((arg == "--warmup" || arg == "-w") && index + 1 < args_size)
+				options.warmup = std::stoul(args[++index]);
+			else if ((arg == "--repeat" || arg == "-r") && index + 1 < args_size)
+				options.repeat = std::stoul(args[++index]);
+			else if ((arg == "--filter" || arg == "-f") && index + 1 < args_size)
+				options.filter = args[++index];
+			else if ((arg == "--output" || arg == "-o") && index + 1 < args_size)
+				options.output = args[++index];
+			else if (arg == "--help" || arg == "-h") {
+				std::cout << "Usage: bench-covscript [options...] <FILES...>\n" << "Options:\n";
+				std::cout << "    Option            Mnemonic   Function\n";
+				std::cout << "  --warmup <N>       -w <N>     Warmup repetitions before measuring(Default 2)\n";
+				std::cout << "  --repeat <N>       -r <N>     Measured repetitions(Default 10)\n";
+				std::cout << "  --filter <STR>     -f <STR>   Only run the cases whose name contains STR\n";
+				std::cout << "  --output <PATH>    -o <PATH>  Write the JSON results to PATH\n";
+				std::cout << "  --help             -h         Show help infomation\n";
+				std::cout << std::endl;
+				std::exit(0);
+			}
+			else if (arg[0] == '-')
+				throw cs::fatal_error("argument syntax error.");
+			else
+				options.files.push_back(arg);
+		}
+		if (options.repeat == 0)
+			throw cs::fatal_error("repeat must be greater than zero.");
+	}
+}
+
+int main(int args_size, const char *args[])
+{
+	using namespace cs_bench;
+	try {
+		parse_args(args_size, args);
+		run_native();
+		for (auto &path:options.files)
+			run_script(path);
+	}
+	catch (const std::exception &e) {
+		std::cerr << e.what() << std::endl;
+		return -1;
+	}
+	if (!options.output.empty()) {
+		std::ofstream out(options.output);
+		if (!out) {
+			std::cerr << "Write results failed." << std::endl;
+			return -1;
+		}
+		print_json(out);
+	}
+	else
+		print_json(std::cout);
+	return 0;
+}
@@ -0,0 +1,15 @@
+function bench()
+    var map=new hash_map
+    for i=0,i<20000,++i
+        map[i%1000]+=1
+    end
+    var words={"alpha","beta","gamma","delta","epsilon"}
+    for i=0,i<20000,++i
+        ++map[words[i%5]]
+    end
+    var sum=0
+    foreach it in map
+        sum+=it.second()
+    end
+    return sum
+end
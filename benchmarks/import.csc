@@ -0,0 +1,5 @@
+function bench()
+    var path=runtime.get_import_path()
+    var pkg=context.import(path,"bench_package")
+    return pkg.answer()
+end
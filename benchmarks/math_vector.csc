@@ -0,0 +1,7 @@
+math.seed(1)
+var data=math.rand_array(1000000,-1,1)
+
+function bench()
+    var waves=math.vector.sin(data)
+    return math.vector.sum(waves)+math.vector.variance(data)+math.vector.dot(data,waves)
+end
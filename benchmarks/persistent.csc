@@ -0,0 +1,13 @@
+function bench()
+    var history=new array
+    var vec=new persistent_vector
+    var map=new persistent_map
+    foreach i in range(5000)
+        vec=vec.push_back(i)
+        map=map.insert(i%500,i)
+        history.push_back(vec)
+    end
+    foreach i in range(5000)
+        vec=vec.set(i,0)
+    end
+end
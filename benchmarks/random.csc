@@ -0,0 +1,16 @@
+function bench()
+    var inside=0
+    for i=0,i<20000,++i
+        var x=math.rand(0,1)
+        var y=math.rand(0,1)
+        if x*x+y*y<=1
+            ++inside
+        end
+    end
+    var xs=math.rand_array(20000,0,1)
+    var sum=0
+    foreach it in xs
+        sum+=it
+    end
+    return inside+sum
+end
@@ -0,0 +1,14 @@
+var path="./read_lines.tmp"
+var out=iostream.fstream(path,iostream.openmode.out)
+for i=0,i<100000,++i
+    out.println("2019-01-01 00:00:00 [info] request " + to_string(i) + " served")
+end
+out.flush()
+
+function bench()
+    var total=0
+    foreach line in iostream.lines(path)
+        total+=line.size()
+    end
+    return total
+end
@@ -0,0 +1,9 @@
+function fib(n)
+    if n<2
+        return n
+    end
+    return fib(n-1)+fib(n-2)
+end
+function bench()
+    return fib(20)
+end
@@ -0,0 +1,9 @@
+function bench()
+    var map=hash_map.with_capacity(100000)
+    var str=string.with_capacity(100000)
+    foreach i in range(100000)
+        map.insert(i,i)
+        str.append('x')
+    end
+    return map.size()+str.size()
+end
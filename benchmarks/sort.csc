@@ -0,0 +1,12 @@
+var data={}
+for i=0,i<20000,++i
+    data.push_back(math.randint(0,1000000))
+end
+
+function bench()
+    var a=data
+    a.sort()
+    var b=data
+    b.sort_by([](x)->-x)
+    return a.lower_bound(500000)+b.size()
+end
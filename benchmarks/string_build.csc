@@ -0,0 +1,9 @@
+function bench()
+    var str=new string
+    for i=0,i<10000,++i
+        str.append(i)
+        str+=","
+    end
+    var parts=str.split({','})
+    return parts.size()
+end
@@ -0,0 +1,15 @@
+var line="2019-01-01 00:00:00,INFO,request served,path=/index.html;status=200\n"
+var text=new string
+for i=0,i<65536,++i
+    text+=line
+end
+
+function bench()
+    var fields=text.split({',', ';', '\n'})
+    var upper=text.toupper()
+    var lower=upper.tolower()
+    var pos=text.find("status=404",0)
+    var copy=lower
+    copy.replace_all("index","main")
+    return fields.size()+pos+copy.size()
+end
@@ -0,0 +1,17 @@
+struct counter
+    var value=0
+    function increase(n)
+        value+=n
+    end
+end
+function bench()
+    var c=new counter
+    for i=0,i<50000,++i
+        c.increase(i)
+    end
+    var records={}
+    for i=0,i<5000,++i
+        records.push_back(new counter)
+    end
+    return c.value
+end
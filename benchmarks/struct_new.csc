@@ -0,0 +1,16 @@
+struct point
+    var x=0
+    var y=0
+    var z=0
+end
+struct colored_point extends point
+    var color="red"
+end
+function bench()
+    var p=new colored_point
+    foreach i in range(20000)
+        var q=new colored_point
+        var r=p
+        q.x=r.y+i
+    end
+end
@@ -0,0 +1,19 @@
+var words={}
+math.seed(5)
+foreach it in math.randint_array(50000,0,5000)
+    words.push_back("word"+to_string(it))
+end
+
+function bench()
+    var table=new hash_map
+    foreach it in words
+        ++table[it]
+    end
+    var hits=0
+    foreach it in words
+        if table.exist(it)
+            ++hits
+        end
+    end
+    return hits+table.size()
+end
@@ -309,45 +309,379 @@ namespace cs {
 	};
 
 // Buffer Pool
+	struct allocator_stats final {
+		// Slabs currently held by the pool
+		std::size_t slab_count = 0;
+		// Objects which can be held by all of the slabs
+		std::size_t capacity = 0;
+		// Objects currently in use
+		std::size_t in_use = 0;
+		// Highest number of objects in use
+		std::size_t peak = 0;
+		// Slabs acquired from and released to the underlying allocator
+		std::size_t acquired = 0;
+		std::size_t released = 0;
+
+		allocator_stats &operator+=(const allocator_stats &stats) noexcept
+		{
+			slab_count += stats.slab_count;
+			capacity += stats.capacity;
+			in_use += stats.in_use;
+			peak += stats.peak;
+			acquired += stats.acquired;
+			released += stats.released;
+			return *this;
+		}
+	};
+
+	// Written by the owning pool only, read by any thread through allocator_registry
+	struct allocator_counters final {
+		std::atomic<std::size_t> slab_count{0}, capacity{0}, in_use{0}, peak{0}, acquired{0}, released{0};
+
+		// A plain load and store, there is only one writer
+		static void add(std::atomic<std::size_t> &counter, std::size_t count) noexcept
+		{
+			counter.store(counter.load(std::memory_order_relaxed) + count, std::memory_order_relaxed);
+		}
+
+		static void sub(std::atomic<std::size_t> &counter, std::size_t count) noexcept
+		{
+			counter.store(counter.load(std::memory_order_relaxed) - count, std::memory_order_relaxed);
+		}
+
+		allocator_stats snapshot() const noexcept
+		{
+			allocator_stats stats;
+			stats.slab_count = slab_count.load(std::memory_order_relaxed);
+			stats.capacity = capacity.load(std::memory_order_relaxed);
+			stats.in_use = in_use.load(std::memory_order_relaxed);
+			stats.peak = peak.load(std::memory_order_relaxed);
+			stats.acquired = acquired.load(std::memory_order_relaxed);
+			stats.released = released.load(std::memory_order_relaxed);
+			return stats;
+		}
+	};
+
+	class allocator_registry final {
+		std::mutex m_lock;
+		std::vector<const allocator_counters *> m_stats;
+
+		allocator_registry() = default;
+
+	public:
+		allocator_registry(const allocator_registry &) = delete;
+
+		static allocator_registry &get()
+		{
+			static allocator_registry registry;
+			return registry;
+		}
+
+		void add(const allocator_counters *stats)
+		{
+			std::lock_guard<std::mutex> guard(m_lock);
+			m_stats.push_back(stats);
+		}
+
+		void remove(const allocator_counters *stats)
+		{
+			std::lock_guard<std::mutex> guard(m_lock);
+			m_stats.erase(std::remove(m_stats.begin(), m_stats.end(), stats), m_stats.end());
+		}
+
+		// Summary of all living pools, the pools of other threads may be changing meanwhile
+		allocator_stats total()
+		{
+			std::lock_guard<std::mutex> guard(m_lock);
+			allocator_stats stats;
+			for (auto &it:m_stats)
+				stats += it->snapshot();
+			return stats;
+		}
+	};
+
+	/*
+	* Slab based object pool
+	* Objects are allocated from slabs, every slab holds a batch of objects and grows with the demand:
+	* the first slab holds blck_size objects, a new slab is as large as all of the slabs held by the pool,
+	* which is limited by slab_limit(). A slab is released when it is empty and the free objects of the
+	* pool still reach the watermark without it.
+	* With CS_THREAD_LOCAL_POOL defined, an object may be released in another thread than the one which
+	* allocated it: the object is handed to the owning pool through a locked remote list, and the owner
+	* returns it to its slab on the next allocation. Slabs still in use when the pool is destroyed are
+	* released with their last object.
+	* The pool is constant initialized and set up on its first allocation, so it can be used during the
+	* dynamic initialization of other translation units, e.g. by the CNI declarations of an extension.
+	*/
 	template<typename T, std::size_t blck_size, template<typename> class allocator_t=std::allocator>
 	class allocator_type final {
-		T *mPool[blck_size];
-		allocator_t<T> mAlloc;
-		std::size_t mOffset = 0;
-	public:
-		allocator_type()
+		struct slab_type;
+
+		struct node_type {
+			union {
+				typename std::aligned_storage<sizeof(T), alignof(T)>::type data;
+				node_type *next;
+			};
+			slab_type *owner;
+		};
+
+		// Shared by a pool and its slabs, it lives until both the pool and the last slab are released
+		struct remote_type {
+			std::mutex lock;
+			// Null if the pool has been destroyed
+			allocator_type *pool = nullptr;
+			// Objects released by other threads, not yet returned to their slabs
+			node_type *nodes = nullptr;
+			std::atomic<bool> pending{false};
+			// The pool and every slab hold a reference
+			std::size_t refs = 1;
+		};
+
+		struct slab_type {
+			remote_type *remote = nullptr;
+			slab_type *prev = nullptr;
+			slab_type *next = nullptr;
+			node_type *nodes = nullptr;
+			node_type *free_list = nullptr;
+			std::size_t capacity = 0;
+			std::size_t used = 0;
+			// Nodes after the offset have never been used
+			std::size_t offset = 0;
+		};
+
+		// Slabs which have free nodes are placed in front of the full slabs
+		slab_type *m_partial = nullptr;
+		slab_type *m_full = nullptr;
+		remote_type *m_remote = nullptr;
+		allocator_counters m_stats;
+
+		static std::size_t slab_limit() noexcept
+		{
+			return (std::max)(blck_size, std::size_t(65536 / sizeof(node_type)));
+		}
+
+		std::size_t watermark() const noexcept
 		{
-			while (mOffset < 0.5 * blck_size)
-				mPool[mOffset++] = mAlloc.allocate(1);
+			return (std::max)(blck_size, m_stats.in_use.load(std::memory_order_relaxed) / 2);
 		}
 
+		static void link(slab_type *&list, slab_type *slab) noexcept
+		{
+			slab->prev = nullptr;
+			slab->next = list;
+			if (list != nullptr)
+				list->prev = slab;
+			list = slab;
+		}
+
+		static void unlink(slab_type *&list, slab_type *slab) noexcept
+		{
+			if (slab->prev != nullptr)
+				slab->prev->next = slab->next;
+			else
+				list = slab->next;
+			if (slab->next != nullptr)
+				slab->next->prev = slab->prev;
+			slab->prev = slab->next = nullptr;
+		}
+
+		static void destroy_slab(slab_type *slab)
+		{
+			allocator_t<node_type>().deallocate(slab->nodes, slab->capacity);
+			slab->~slab_type();
+			allocator_t<slab_type>().deallocate(slab, 1);
+		}
+
+		// Returns true if the last reference has been dropped, the lock of remote must be held
+		static bool unref(remote_type *remote) noexcept
+		{
+			return --remote->refs == 0;
+		}
+
+		slab_type *acquire_slab()
+		{
+			if (m_remote == nullptr) {
+				m_remote = new remote_type;
+				m_remote->pool = this;
+				allocator_registry::get().add(&m_stats);
+			}
+			std::size_t current = m_stats.capacity.load(std::memory_order_relaxed);
+			std::size_t capacity = current < blck_size ? blck_size : current;
+			if (capacity > slab_limit())
+				capacity = slab_limit();
+			slab_type *slab = allocator_t<slab_type>().allocate(1);
+			::new(slab) slab_type;
+			try {
+				slab->nodes = allocator_t<node_type>().allocate(capacity);
+			}
+			catch (...) {
+				slab->~slab_type();
+				allocator_t<slab_type>().deallocate(slab, 1);
+				throw;
+			}
+			slab->remote = m_remote;
+			slab->capacity = capacity;
+			link(m_partial, slab);
+			{
+				std::lock_guard<std::mutex> guard(m_remote->lock);
+				++m_remote->refs;
+			}
+			allocator_counters::add(m_stats.slab_count, 1);
+			allocator_counters::add(m_stats.acquired, 1);
+			allocator_counters::add(m_stats.capacity, capacity);
+			return slab;
+		}
+
+		void release_slab(slab_type *slab)
+		{
+			unlink(m_partial, slab);
+			allocator_counters::sub(m_stats.slab_count, 1);
+			allocator_counters::add(m_stats.released, 1);
+			allocator_counters::sub(m_stats.capacity, slab->capacity);
+			destroy_slab(slab);
+			std::lock_guard<std::mutex> guard(m_remote->lock);
+			unref(m_remote);
+		}
+
+		// Only called by the owner of the slab
+		void release_local(node_type *node)
+		{
+			slab_type *slab = node->owner;
+			node->next = slab->free_list;
+			slab->free_list = node;
+			if (slab->used-- == slab->capacity) {
+				unlink(m_full, slab);
+				link(m_partial, slab);
+			}
+			allocator_counters::sub(m_stats.in_use, 1);
+			if (slab->used == 0 && m_stats.capacity.load(std::memory_order_relaxed) -
+			        m_stats.in_use.load(std::memory_order_relaxed) - slab->capacity >= watermark())
+				release_slab(slab);
+		}
+
+		// Objects released by another thread or after the owning pool has been destroyed
+		static void release_remote(node_type *node)
+		{
+			slab_type *slab = node->owner;
+			remote_type *remote = slab->remote;
+			std::unique_lock<std::mutex> guard(remote->lock);
+			if (remote->pool != nullptr) {
+				node->next = remote->nodes;
+				remote->nodes = node;
+				remote->pending.store(true, std::memory_order_release);
+				return;
+			}
+			if (--slab->used == 0) {
+				destroy_slab(slab);
+				if (unref(remote)) {
+					guard.unlock();
+					delete remote;
+				}
+			}
+		}
+
+		void collect_remote()
+		{
+			node_type *nodes = nullptr;
+			{
+				std::lock_guard<std::mutex> guard(m_remote->lock);
+				nodes = m_remote->nodes;
+				m_remote->nodes = nullptr;
+				m_remote->pending.store(false, std::memory_order_relaxed);
+			}
+			while (nodes != nullptr) {
+				node_type *node = nodes;
+				nodes = nodes->next;
+				release_local(node);
+			}
+		}
+
+		void release(node_type *node)
+		{
+			if (node->owner->remote == m_remote)
+				release_local(node);
+			else
+				release_remote(node);
+		}
+
+	public:
+		constexpr allocator_type() noexcept = default;
+
 		allocator_type(const allocator_type &) = delete;
 
 		~allocator_type()
 		{
-			while (mOffset > 0)
-				mAlloc.deallocate(mPool[--mOffset], 1);
+			if (m_remote == nullptr)
+				return;
+			allocator_registry::get().remove(&m_stats);
+			remote_type *remote = m_remote;
+			// Objects released afterwards take the remote path, even in this thread
+			m_remote = nullptr;
+			std::unique_lock<std::mutex> guard(remote->lock);
+			remote->pool = nullptr;
+			for (node_type *node = remote->nodes; node != nullptr; node = node->next)
+				--node->owner->used;
+			remote->nodes = nullptr;
+			// Objects still in use keep their slabs alive, which will be released with the last object
+			for (slab_type *list:{m_partial, m_full}) {
+				while (list != nullptr) {
+					slab_type *slab = list;
+					list = list->next;
+					if (slab->used == 0) {
+						destroy_slab(slab);
+						unref(remote);
+					}
+				}
+			}
+			if (unref(remote)) {
+				guard.unlock();
+				delete remote;
+			}
 		}
 
 		template<typename...ArgsT>
 		inline T *alloc(ArgsT &&...args)
 		{
-			T *ptr = nullptr;
-			if (mOffset > 0)
-				ptr = mPool[--mOffset];
+			if (m_remote != nullptr && m_remote->pending.load(std::memory_order_acquire))
+				collect_remote();
+			slab_type *slab = m_partial != nullptr ? m_partial : acquire_slab();
+			node_type *node = nullptr;
+			if (slab->free_list != nullptr) {
+				node = slab->free_list;
+				slab->free_list = node->next;
+			}
 			else
-				ptr = mAlloc.allocate(1);
-			mAlloc.construct(ptr, std::forward<ArgsT>(args)...);
+				node = slab->nodes + slab->offset++;
+			node->owner = slab;
+			// The constructor may allocate from this pool again, so the slab must be updated before it
+			if (++slab->used == slab->capacity) {
+				unlink(m_partial, slab);
+				link(m_full, slab);
+			}
+			allocator_counters::add(m_stats.in_use, 1);
+			std::size_t in_use = m_stats.in_use.load(std::memory_order_relaxed);
+			if (in_use > m_stats.peak.load(std::memory_order_relaxed))
+				m_stats.peak.store(in_use, std::memory_order_relaxed);
+			T *ptr = reinterpret_cast<T *>(&node->data);
+			try {
+				::new(ptr) T(std::forward<ArgsT>(args)...);
+			}
+			catch (...) {
+				release_local(node);
+				throw;
+			}
 			return ptr;
 		}
 
 		inline void free(T *ptr)
 		{
-			mAlloc.destroy(ptr);
-			if (mOffset < blck_size)
-				mPool[mOffset++] = ptr;
-			else
-				mAlloc.deallocate(ptr, 1);
+			ptr->~T();
+			release(reinterpret_cast<node_type *>(ptr));
+		}
+
+		allocator_stats stats() const noexcept
+		{
+			return m_stats.snapshot();
 		}
 	};
 
@@ -31,11 +31,10 @@
 
 #include <covscript/import/parallel_hashmap/phmap.h>
 
-#else
-#include <unordered_map>
-#include <unordered_set>
 #endif
 // STL
+#include <unordered_set>
+#include <unordered_map>
 #include <forward_list>
 #include <type_traits>
 #include <functional>
@@ -46,13 +45,18 @@
 #include <fstream>
 #include <sstream>
 #include <iomanip>
+#include <cstdint>
+#include <limits>
 #include <istream>
 #include <ostream>
 #include <utility>
 #include <cctype>
+#include <cstdio>
 #include <string>
 #include <vector>
 #include <memory>
+#include <atomic>
+#include <mutex>
 #include <cmath>
 #include <deque>
 #include <list>
@@ -171,6 +175,7 @@ namespace cs {
 #endif
 		bool mIsMemFn = false;
 		bool mIsVargs = false;
+		bool mIsGenerator = false;
 		std::vector<std::string> mArgs;
 		std::deque<statement_base *> mBody;
 	public:
@@ -224,6 +229,17 @@ namespace cs {
 #endif
 		}
 
+		// Calling a generator function returns an iterator instead of running the body
+		void set_generator()
+		{
+			mIsGenerator = true;
+		}
+
+		bool is_generator() const noexcept
+		{
+			return mIsGenerator;
+		}
+
 		std::size_t argument_count() const noexcept
 		{
 			return mArgs.size();
@@ -334,6 +350,83 @@ namespace cs {
 		}
 	};
 
+	/*
+	* Interned strings
+	* Every distinct name is stored once in a global pool, a symbol refers to the pooled text and
+	* carries its hash, so copying, hashing and comparing it never touch the text.
+	* Symbols interned by another copy of the pool (e.g. an extension built on a platform
+	* without unique statics) still compare equal by their text.
+	* Lookups by std::string use probes, which refer to the text without interning it,
+	* so names which are only looked up never take the lock or grow the pool.
+	*/
+	class symbol final {
+		const std::string *m_str;
+		std::size_t m_hash;
+
+		symbol(const std::string *str, std::size_t hash) noexcept : m_str(str), m_hash(hash) {}
+
+		static const std::string *intern(const std::string &str)
+		{
+			static std::mutex lock;
+			// Nodes of unordered_set never move, so the texts can be referred by address
+			static std::unordered_set<std::string> pool;
+			std::lock_guard<std::mutex> guard(lock);
+			return &*pool.insert(str).first;
+		}
+
+	public:
+		symbol() = delete;
+
+		explicit symbol(const std::string &str) : m_str(intern(str)), m_hash(std::hash<std::string>()(str)) {}
+
+		symbol(const symbol &) = default;
+
+		symbol &operator=(const symbol &) = default;
+
+		// Only for lookups, the probe must not be stored or outlive the text
+		static symbol probe(const std::string &str) noexcept
+		{
+			return symbol(&str, std::hash<std::string>()(str));
+		}
+
+		const std::string &str() const noexcept
+		{
+			return *m_str;
+		}
+
+		std::size_t hash() const noexcept
+		{
+			return m_hash;
+		}
+
+		bool operator==(const symbol &sym) const noexcept
+		{
+			return m_str == sym.m_str || (m_hash == sym.m_hash && *m_str == *sym.m_str);
+		}
+
+		bool operator!=(const symbol &sym) const noexcept
+		{
+			return !(*this == sym);
+		}
+
+		operator const std::string &() const noexcept
+		{
+			return *m_str;
+		}
+	};
+}
+
+namespace std {
+	template<>
+	struct hash<cs::symbol> {
+		std::size_t operator()(const cs::symbol &sym) const noexcept
+		{
+			return sym.hash();
+		}
+	};
+}
+
+namespace cs {
 	struct domain_ref final {
 		domain_type *domain = nullptr;
 
@@ -345,13 +438,17 @@ namespace cs {
 
 		friend class domain_manager;
 
+		friend class struct_layout;
+
 		mutable std::size_t m_domain_id = 0, m_slot_id = 0;
 		mutable std::shared_ptr<domain_ref> m_ref;
-		std::string m_id;
+		symbol m_id;
 	public:
 		var_id() = delete;
 
-		var_id(std::string name) : m_id(std::move(name)) {}
+		var_id(const std::string &name) : m_id(name) {}
+
+		explicit var_id(const symbol &name) : m_id(name) {}
 
 		var_id(const var_id &) = default;
 
@@ -363,36 +460,37 @@ namespace cs {
 
 		inline void set_id(const std::string &id)
 		{
-			m_id = id;
+			m_id = symbol(id);
 		}
 
 		inline const std::string &get_id() const noexcept
 		{
-			return m_id;
+			return m_id.str();
 		}
 
-		inline operator std::string &() noexcept
+		inline const symbol &get_symbol() const noexcept
 		{
 			return m_id;
 		}
 
 		inline operator const std::string &() const noexcept
 		{
-			return m_id;
+			return m_id.str();
 		}
 	};
 
 	class domain_type final {
-		map_t<std::string, std::size_t> m_reflect;
+		map_t<symbol, std::size_t> m_reflect;
 		std::shared_ptr<domain_ref> m_ref;
 		std::vector<var> m_slot;
 
-		inline std::size_t get_slot_id(const std::string &name) const
+		inline std::size_t get_slot_id(const symbol &name) const
 		{
-			if (m_reflect.count(name) > 0)
-				return m_reflect.at(name);
+			auto it = m_reflect.find(name);
+			if (it != m_reflect.end())
+				return it->second;
 			else
-				throw runtime_error("Use of undefined variable \"" + name + "\".");
+				throw runtime_error("Use of undefined variable \"" + name.str() + "\".");
 		}
 
 	public:
@@ -418,16 +516,36 @@ namespace cs {
 			m_slot.clear();
 		}
 
+		// The reference travels with the variables, so the cached ids stay valid
+		void swap(domain_type &domain) noexcept
+		{
+			std::swap(m_reflect, domain.m_reflect);
+			std::swap(m_ref, domain.m_ref);
+			std::swap(m_slot, domain.m_slot);
+			m_ref->domain = this;
+			domain.m_ref->domain = &domain;
+		}
+
+		std::size_t size() const noexcept
+		{
+			return m_slot.size();
+		}
+
 		bool consistence(const var_id &id) const noexcept
 		{
 			return id.m_ref == m_ref;
 		}
 
-		bool exist(const std::string &name) const noexcept
+		bool exist(const symbol &name) const noexcept
 		{
 			return m_reflect.count(name) > 0;
 		}
 
+		bool exist(const std::string &name) const noexcept
+		{
+			return exist(symbol::probe(name));
+		}
+
 		bool exist(const var_id &id) const noexcept
 		{
 			if (id.m_ref != m_ref)
@@ -436,17 +554,23 @@ namespace cs {
 				return true;
 		}
 
-		domain_type &add_var(const std::string &name, const var &val)
+		domain_type &add_var(const symbol &name, const var &val)
 		{
-			if (m_reflect.count(name) == 0) {
+			auto it = m_reflect.find(name);
+			if (it == m_reflect.end()) {
 				m_slot.push_back(val);
 				m_reflect.emplace(name, m_slot.size() - 1);
 			}
 			else
-				m_slot[m_reflect[name]] = val;
+				m_slot[it->second] = val;
 			return *this;
 		}
 
+		domain_type &add_var(const std::string &name, const var &val)
+		{
+			return add_var(symbol(name), val);
+		}
+
 		domain_type &add_var(const var_id &id, const var &val)
 		{
 			if (m_reflect.count(id.m_id) == 0) {
@@ -483,20 +607,24 @@ namespace cs {
 			return m_slot[id.m_slot_id];
 		}
 
+		var &get_var(const symbol &name)
+		{
+			return m_slot[get_slot_id(name)];
+		}
+
+		const var &get_var(const symbol &name) const
+		{
+			return m_slot[get_slot_id(name)];
+		}
+
 		var &get_var(const std::string &name)
 		{
-			if (m_reflect.count(name) > 0)
-				return m_slot[m_reflect.at(name)];
-			else
-				throw runtime_error("Use of undefined variable \"" + name + "\".");
+			return m_slot[get_slot_id(symbol::probe(name))];
 		}
 
 		const var &get_var(const std::string &name) const
 		{
-			if (m_reflect.count(name) > 0)
-				return m_slot[m_reflect.at(name)];
-			else
-				throw runtime_error("Use of undefined variable \"" + name + "\".");
+			return m_slot[get_slot_id(symbol::probe(name))];
 		}
 
 		var &get_var_no_check(const var_id &id) noexcept
@@ -527,16 +655,26 @@ namespace cs {
 			return m_slot[id.m_slot_id];
 		}
 
-		var &get_var_no_check(const std::string &name) noexcept
+		var &get_var_no_check(const symbol &name) noexcept
 		{
 			return m_slot[m_reflect.at(name)];
 		}
 
-		const var &get_var_no_check(const std::string &name) const noexcept
+		const var &get_var_no_check(const symbol &name) const noexcept
 		{
 			return m_slot[m_reflect.at(name)];
 		}
 
+		var &get_var_no_check(const std::string &name) noexcept
+		{
+			return m_slot[m_reflect.at(symbol::probe(name))];
+		}
+
+		const var &get_var_no_check(const std::string &name) const noexcept
+		{
+			return m_slot[m_reflect.at(symbol::probe(name))];
+		}
+
 		auto begin() const
 		{
 			return m_reflect.cbegin();
@@ -634,243 +772,2182 @@ namespace cs {
 		}
 	};
 
-	class structure final {
-		bool m_shadow = false;
-		std::string m_name;
-		domain_t m_data;
-		type_id m_id;
-	public:
-		structure() = delete;
-
-		structure(const type_id &id, const std::string &name, const domain_type &data) : m_id(id),
-			m_name(typeid(structure).name() +
-			       name),
-			m_data(std::make_shared<domain_type>(
-			           data))
+	/*
+	* Lazy iterator protocol
+	* Every call of next() yields the next element into val, and returns false at the end.
+	* The consumer passes the same var again, so the element can be stored in place
+	* when nobody else refers to it.
+	*/
+	class iterator_base {
+	protected:
+		template<typename T>
+		static bool reusable(const var &val)
 		{
-			if (m_data->exist("initialize"))
-				invoke(m_data->get_var("initialize"), var::make<structure>(this));
+			return val.use_count() == 1 && val.type() == typeid(T) && !val.is_protect();
 		}
 
-		structure(const structure &s) : m_id(s.m_id), m_name(s.m_name),
-			m_data(std::make_shared<domain_type>())
+		template<typename T>
+		static void store(var &val, const T &dat)
 		{
-			if (s.m_data->exist("parent")) {
-				var &_p = s.m_data->get_var("parent");
-				auto &_parent = _p.val<structure>();
-				var p = copy(_p);
-				auto &parent = p.val<structure>();
-				m_data->add_var("parent", p);
-				for (auto &it:*parent.m_data) {
-					// Handle overriding
-					const var &v = s.m_data->get_var(it.first);
-					if (!_parent.m_data->get_var(it.first).is_same(v))
-						m_data->add_var(it.first, copy(v));
-					else
-						m_data->add_var(it.first, parent.m_data->get_var_by_id(it.second));
-				}
-			}
-			for (auto &it:*s.m_data)
-				if (!m_data->exist(it.first))
-					m_data->add_var(it.first, copy(s.m_data->get_var_by_id(it.second)));
-			if (m_data->exist("duplicate"))
-				invoke(m_data->get_var("duplicate"), var::make<structure>(this), var::make<structure>(&s));
+			if (reusable<T>(val))
+				val.val<T>() = dat;
+			else
+				val = var::make<T>(dat);
 		}
 
-		explicit structure(const structure *s) : m_shadow(true), m_id(s->m_id), m_name(s->m_name),
-			m_data(s->m_data) {}
+	public:
+		iterator_base() = default;
 
-		~structure()
-		{
-			if (!m_shadow && m_data->exist("finalize"))
-				invoke(m_data->get_var("finalize"), var::make<structure>(this));
-		}
+		iterator_base(const iterator_base &) = delete;
 
-		bool operator==(const structure &s) const
-		{
-			if (s.m_id != m_id)
-				return false;
-			if (!m_shadow && m_data->exist("equal"))
-				return invoke(m_data->get_var("equal"), var::make<structure>(this),
-				              var::make<structure>(&s)).const_val<bool>();
-			else {
-				for (auto &it:*m_data)
-					if (it.first != "parent" && s.m_data->get_var(it.first) != m_data->get_var_by_id(it.second))
-						return false;
-				return true;
-			}
-		}
+		virtual ~iterator_base() = default;
 
-		const domain_type &get_domain() const
-		{
-			return *m_data;
-		}
+		virtual bool next(var &) = 0;
+	};
 
-		const type_id &get_id() const
-		{
-			return m_id;
-		}
+	class range_generator final : public iterator_base {
+		range_iterator m_it, m_end;
+	public:
+		range_generator() = delete;
 
-		template<typename T>
-		var &get_var(T &&name) const
+		explicit range_generator(const range_type &range) : m_it(range.begin()), m_end(range.end()) {}
+
+		bool next(var &val) override
 		{
-			if (m_data->exist(name))
-				return m_data->get_var_no_check(name);
-			else
-				throw runtime_error("Struct \"" + m_name + "\" have no member called \"" + std::string(name) + "\".");
+			if (!(m_it != m_end))
+				return false;
+			store<number>(val, *m_it);
+			++m_it;
+			return true;
 		}
 	};
 
-	class struct_builder final {
-		static std::size_t mCount;
-		context_t mContext;
-		type_id mTypeId;
-		std::string mName;
-		tree_type<token_base *> mParent;
-		std::deque<statement_base *> mMethod;
+	/*
+	* List of the scripts
+	* Every modification changes the version, so that iterations holding iterators of the list can detect
+	* the removal of their nodes instead of reading them.
+	*/
+	class list final : public std::list<var> {
+		using base_type = std::list<var>;
+
+		std::size_t m_version = 0;
 	public:
-		struct_builder() = delete;
+		using base_type::base_type;
 
-		struct_builder(context_t c, std::string name, tree_type<token_base *> parent,
-		               std::deque<statement_base *> method) : mContext(std::move(std::move(c))),
-			mTypeId(typeid(structure), ++mCount),
-			mName(std::move(name)),
-			mParent(std::move(parent)),
-			mMethod(std::move(method)) {}
+		list() = default;
 
-		struct_builder(const struct_builder &) = default;
+		list(const list &) = default;
 
-		~struct_builder() = default;
+		list(list &&) noexcept = default;
 
-		static void reset_counter()
+		list &operator=(const list &lst)
 		{
-			mCount = 0;
+			++m_version;
+			base_type::operator=(lst);
+			return *this;
 		}
 
-		const type_id &get_id() const
+		list &operator=(list &&lst) noexcept
 		{
-			return mTypeId;
+			++m_version;
+			base_type::operator=(std::move(lst));
+			return *this;
 		}
 
-		var operator()();
-	};
-
-// Namespace and extensions
-	class name_space {
-		domain_type m_data;
-	public:
-		name_space() = default;
+		std::size_t version() const noexcept
+		{
+			return m_version;
+		}
 
-		name_space(const name_space &) = delete;
+		void swap(list &lst) noexcept
+		{
+			++m_version;
+			++lst.m_version;
+			base_type::swap(lst);
+		}
 
-		explicit name_space(domain_type dat) : m_data(std::move(dat)) {}
+		void clear() noexcept
+		{
+			++m_version;
+			base_type::clear();
+		}
 
-		virtual ~name_space() = default;
+		template<typename...ArgsT>
+		iterator insert(ArgsT &&...args)
+		{
+			++m_version;
+			return base_type::insert(std::forward<ArgsT>(args)...);
+		}
 
-		name_space &add_var(const std::string &name, const var &var)
+		template<typename...ArgsT>
+		iterator erase(ArgsT &&...args)
 		{
-			m_data.add_var(name, var);
-			return *this;
+			++m_version;
+			return base_type::erase(std::forward<ArgsT>(args)...);
 		}
 
-		name_space &add_var(const var_id &id, const var &var)
+		template<typename...ArgsT>
+		void assign(ArgsT &&...args)
 		{
-			m_data.add_var(id, var);
-			return *this;
+			++m_version;
+			base_type::assign(std::forward<ArgsT>(args)...);
 		}
 
-		var &get_var(const std::string &name)
+		template<typename...ArgsT>
+		void resize(ArgsT &&...args)
 		{
-			return m_data.get_var(name);
+			++m_version;
+			base_type::resize(std::forward<ArgsT>(args)...);
 		}
 
-		const var &get_var(const std::string &name) const
+		template<typename T>
+		void push_front(T &&val)
 		{
-			return m_data.get_var(name);
+			++m_version;
+			base_type::push_front(std::forward<T>(val));
 		}
 
-		var &get_var(const var_id &id)
+		template<typename T>
+		void push_back(T &&val)
 		{
-			return m_data.get_var(id);
+			++m_version;
+			base_type::push_back(std::forward<T>(val));
 		}
 
-		const var &get_var(const var_id &id) const
+		template<typename...ArgsT>
+		void emplace_front(ArgsT &&...args)
 		{
-			return m_data.get_var(id);
+			++m_version;
+			base_type::emplace_front(std::forward<ArgsT>(args)...);
 		}
 
-		const domain_type &get_domain() const
+		template<typename...ArgsT>
+		void emplace_back(ArgsT &&...args)
 		{
-			return m_data;
+			++m_version;
+			base_type::emplace_back(std::forward<ArgsT>(args)...);
 		}
 
-		void copy_namespace(const name_space &ns)
+		void pop_front()
 		{
-			for (auto &it:ns.m_data)
-				m_data.add_var(it.first, ns.m_data.get_var_by_id(it.second));
+			++m_version;
+			base_type::pop_front();
 		}
-	};
 
-	template<typename T>
-	var &type_t::get_var(T &&name) const
-	{
-		if (extensions.get() != nullptr)
-			return extensions->get_var(name);
-		else
-			throw runtime_error("Type does not support the extension");
-	}
+		void pop_back()
+		{
+			++m_version;
+			base_type::pop_back();
+		}
 
-// Internal Garbage Collection
-	template<typename T>
-	class garbage_collector final {
-		set_t<T *> table;
-	public:
-		garbage_collector() = default;
+		template<typename...ArgsT>
+		void splice(ArgsT &&...args)
+		{
+			++m_version;
+			base_type::splice(std::forward<ArgsT>(args)...);
+		}
 
-		garbage_collector(const garbage_collector &) = delete;
+		void remove(const var &val)
+		{
+			++m_version;
+			base_type::remove(val);
+		}
 
-		~garbage_collector()
+		template<typename T>
+		void remove_if(T &&pred)
 		{
-			collect();
+			++m_version;
+			base_type::remove_if(std::forward<T>(pred));
 		}
 
-		void collect()
+		template<typename...ArgsT>
+		void unique(ArgsT &&...args)
 		{
-			for (auto &ptr:table)
-				delete ptr;
-			table.clear();
+			++m_version;
+			base_type::unique(std::forward<ArgsT>(args)...);
 		}
 
-		void add(void *ptr)
+		template<typename...ArgsT>
+		void sort(ArgsT &&...args)
 		{
-			table.emplace(static_cast<T *>(ptr));
+			++m_version;
+			base_type::sort(std::forward<ArgsT>(args)...);
 		}
 
-		void remove(void *ptr)
+		void reverse() noexcept
 		{
-			table.erase(static_cast<T *>(ptr));
+			++m_version;
+			base_type::reverse();
 		}
 	};
 
-	namespace dll_resources {
-		constexpr char dll_compatible_check[] = "__CS_ABI_COMPATIBLE__";
-		constexpr char dll_main_entrance[] = "__CS_EXTENSION_MAIN__";
+	/*
+	* Hash map of the scripts
+	* While all keys are strings or all keys are numbers, the keys are stored unboxed, so that a probe hashes
+	* and compares them directly instead of calling the virtual functions of the holders. The map is converted
+	* to the generic representation when a key of another type is inserted, and the representation is chosen
+	* again when the map becomes empty. Every entry keeps its boxed key, so the iteration yields the same pairs
+	* in all representations.
+	*/
+	class hash_map final {
+		enum class kind {
+			string, number, generic
+		};
 
-		typedef int(*dll_compatible_check_t)();
+		using string_map = map_t<string, pair>;
+		using number_map = map_t<number, pair>;
+		using generic_map = map_t<var, pair>;
+
+		kind m_kind = kind::generic;
+		string_map m_strings;
+		number_map m_numbers;
+		generic_map m_generic;
+		// Reserved size, applied again when the representation changes
+		std::size_t m_reserved = 0;
+		// Changed by every insertion, removal and rehash, so that iterations can detect them
+		std::size_t m_version = 0;
+
+		static kind kind_of(const var &key)
+		{
+			if (key.type() == typeid(string))
+				return kind::string;
+			else if (key.type() == typeid(number))
+				return kind::number;
+			else
+				return kind::generic;
+		}
 
-		typedef void(*dll_main_entrance_t)(name_space *, process_context *);
-	}
+		template<typename MapT>
+		void move_to_generic(MapT &map)
+		{
+			m_generic.reserve((std::max)(map.size(), m_reserved));
+			for (auto &it:map)
+				m_generic.emplace(it.second.first, std::move(it.second));
+			map.clear();
+		}
 
-	class extension final : public name_space {
-	public:
-		static garbage_collector<cov::dll> gc;
+		template<typename MapT, typename KeyT, typename FuncT>
+		static std::pair<typename MapT::iterator, bool>
+		find_or_emplace(MapT &map, const KeyT &key, const var &boxed, FuncT &&func)
+		{
+#ifndef CS_COMPATIBILITY_MODE
+			bool inserted = false;
+			auto it = map.lazy_emplace(key, [&](const typename MapT::constructor &ctor) {
+				inserted = true;
+				ctor(key, pair(copy(boxed), func()));
+			});
+			return {it, inserted};
+#else
+			auto it = map.find(key);
+			if (it != map.end())
+				return {it, false};
+			return map.emplace(key, pair(copy(boxed), func()));
+#endif
+		}
 
-		extension() = delete;
+		// Chooses the representation for the key before inserting it
+		void prepare(const var &key)
+		{
+			kind target = kind_of(key);
+			if (target == m_kind || (m_kind == kind::generic && !empty()))
+				return;
+			if (empty()) {
+				m_kind = target;
+				reserve(m_reserved);
+				return;
+			}
+			if (m_kind == kind::string)
+				move_to_generic(m_strings);
+			else
+				move_to_generic(m_numbers);
+			m_kind = kind::generic;
+			++m_version;
+		}
 
-		extension(const extension &) = delete;
+	public:
+		using value_type = pair;
+
+		template<bool is_const>
+		class basic_iterator final {
+			friend class hash_map;
+
+			template<typename MapT>
+			using iterator_of = typename std::conditional<is_const, typename MapT::const_iterator, typename MapT::iterator>::type;
+			using reference = typename std::conditional<is_const, const pair &, pair &>::type;
+			using pointer = typename std::conditional<is_const, const pair *, pair *>::type;
+
+			kind m_kind;
+			iterator_of<string_map> m_string;
+			iterator_of<number_map> m_number;
+			iterator_of<generic_map> m_generic;
+
+			explicit basic_iterator(iterator_of<string_map> it) : m_kind(kind::string), m_string(it) {}
+
+			explicit basic_iterator(iterator_of<number_map> it) : m_kind(kind::number), m_number(it) {}
+
+			explicit basic_iterator(iterator_of<generic_map> it) : m_kind(kind::generic), m_generic(it) {}
+
+		public:
+			reference operator*() const
+			{
+				switch (m_kind) {
+				case kind::string:
+					return m_string->second;
+				case kind::number:
+					return m_number->second;
+				default:
+					return m_generic->second;
+				}
+			}
 
-		explicit extension(const std::string &path)
-		{
+			pointer operator->() const
+			{
+				return &**this;
+			}
+
+			basic_iterator &operator++()
+			{
+				switch (m_kind) {
+				case kind::string:
+					++m_string;
+					break;
+				case kind::number:
+					++m_number;
+					break;
+				default:
+					++m_generic;
+				}
+				return *this;
+			}
+
+			bool operator==(const basic_iterator &it) const
+			{
+				switch (m_kind) {
+				case kind::string:
+					return m_string == it.m_string;
+				case kind::number:
+					return m_number == it.m_number;
+				default:
+					return m_generic == it.m_generic;
+				}
+			}
+
+			bool operator!=(const basic_iterator &it) const
+			{
+				return !(*this == it);
+			}
+		};
+
+		using iterator = basic_iterator<false>;
+		using const_iterator = basic_iterator<true>;
+
+	private:
+		template<typename IteratorT>
+		std::pair<iterator, bool> make_result(IteratorT it, bool inserted)
+		{
+			if (inserted)
+				++m_version;
+			return {iterator(it), inserted};
+		}
+
+	public:
+		std::size_t version() const noexcept
+		{
+			return m_version;
+		}
+
+		bool empty() const
+		{
+			return size() == 0;
+		}
+
+		std::size_t size() const
+		{
+			switch (m_kind) {
+			case kind::string:
+				return m_strings.size();
+			case kind::number:
+				return m_numbers.size();
+			default:
+				return m_generic.size();
+			}
+		}
+
+		void clear()
+		{
+			++m_version;
+			m_strings.clear();
+			m_numbers.clear();
+			m_generic.clear();
+		}
+
+		// Room for at least count entries without rehashing
+		void reserve(std::size_t count)
+		{
+			++m_version;
+			m_reserved = count;
+			switch (m_kind) {
+			case kind::string:
+				m_strings.reserve(count);
+				break;
+			case kind::number:
+				m_numbers.reserve(count);
+				break;
+			default:
+				m_generic.reserve(count);
+				break;
+			}
+		}
+
+		std::size_t bucket_count() const
+		{
+			switch (m_kind) {
+			case kind::string:
+				return m_strings.bucket_count();
+			case kind::number:
+				return m_numbers.bucket_count();
+			default:
+				return m_generic.bucket_count();
+			}
+		}
+
+		// Rehashes to the smallest table that holds the entries, and drops the reservation
+		void shrink_to_fit()
+		{
+			++m_version;
+			m_reserved = 0;
+			m_strings.rehash(0);
+			m_numbers.rehash(0);
+			m_generic.rehash(0);
+		}
+
+		iterator begin()
+		{
+			switch (m_kind) {
+			case kind::string:
+				return iterator(m_strings.begin());
+			case kind::number:
+				return iterator(m_numbers.begin());
+			default:
+				return iterator(m_generic.begin());
+			}
+		}
+
+		iterator end()
+		{
+			switch (m_kind) {
+			case kind::string:
+				return iterator(m_strings.end());
+			case kind::number:
+				return iterator(m_numbers.end());
+			default:
+				return iterator(m_generic.end());
+			}
+		}
+
+		const_iterator begin() const
+		{
+			switch (m_kind) {
+			case kind::string:
+				return const_iterator(m_strings.begin());
+			case kind::number:
+				return const_iterator(m_numbers.begin());
+			default:
+				return const_iterator(m_generic.begin());
+			}
+		}
+
+		const_iterator end() const
+		{
+			switch (m_kind) {
+			case kind::string:
+				return const_iterator(m_strings.end());
+			case kind::number:
+				return const_iterator(m_numbers.end());
+			default:
+				return const_iterator(m_generic.end());
+			}
+		}
+
+		// Keys of other types can not exist in the unboxed representations
+		iterator find(const var &key)
+		{
+			switch (m_kind) {
+			case kind::string:
+				return key.type() == typeid(string) ? iterator(m_strings.find(key.const_val<string>())) : end();
+			case kind::number:
+				return key.type() == typeid(number) ? iterator(m_numbers.find(key.const_val<number>())) : end();
+			default:
+				return iterator(m_generic.find(key));
+			}
+		}
+
+		const_iterator find(const var &key) const
+		{
+			switch (m_kind) {
+			case kind::string:
+				return key.type() == typeid(string) ? const_iterator(m_strings.find(key.const_val<string>())) : end();
+			case kind::number:
+				return key.type() == typeid(number) ? const_iterator(m_numbers.find(key.const_val<number>())) : end();
+			default:
+				return const_iterator(m_generic.find(key));
+			}
+		}
+
+		// Looks up a string key without boxing it, unless the map is in the generic representation
+		iterator find(const string &key)
+		{
+			switch (m_kind) {
+			case kind::string:
+				return iterator(m_strings.find(key));
+			case kind::number:
+				return end();
+			default:
+				return iterator(m_generic.find(var::make<string>(key)));
+			}
+		}
+
+		const_iterator find(const string &key) const
+		{
+			switch (m_kind) {
+			case kind::string:
+				return const_iterator(m_strings.find(key));
+			case kind::number:
+				return end();
+			default:
+				return const_iterator(m_generic.find(var::make<string>(key)));
+			}
+		}
+
+		std::size_t count(const var &key) const
+		{
+			return find(key) != end() ? 1 : 0;
+		}
+
+		std::size_t count(const string &key) const
+		{
+			return find(key) != end() ? 1 : 0;
+		}
+
+		var &at(const var &key)
+		{
+			auto it = find(key);
+			if (it == end())
+				throw std::out_of_range("Key does not exist.");
+			return it->second;
+		}
+
+		const var &at(const var &key) const
+		{
+			auto it = find(key);
+			if (it == end())
+				throw std::out_of_range("Key does not exist.");
+			return it->second;
+		}
+
+		// The key is stored as it is, so it should be copied by the caller
+		std::pair<iterator, bool> emplace(const var &key, const var &val)
+		{
+			prepare(key);
+			switch (m_kind) {
+			case kind::string: {
+				auto result = m_strings.emplace(key.const_val<string>(), pair(key, val));
+				return make_result(result.first, result.second);
+			}
+			case kind::number: {
+				auto result = m_numbers.emplace(key.const_val<number>(), pair(key, val));
+				return make_result(result.first, result.second);
+			}
+			default: {
+				auto result = m_generic.emplace(key, pair(key, val));
+				return make_result(result.first, result.second);
+			}
+			}
+		}
+
+		/*
+		* Finds the key, or inserts a copy of it with the value made by func, with one probe.
+		* The value is only made when the key is inserted, and func must not throw.
+		*/
+		template<typename FuncT>
+		std::pair<iterator, bool> find_or_emplace(const var &key, FuncT &&func)
+		{
+			prepare(key);
+			switch (m_kind) {
+			case kind::string: {
+				auto result = find_or_emplace(m_strings, key.const_val<string>(), key, func);
+				return make_result(result.first, result.second);
+			}
+			case kind::number: {
+				auto result = find_or_emplace(m_numbers, key.const_val<number>(), key, func);
+				return make_result(result.first, result.second);
+			}
+			default: {
+				auto result = find_or_emplace(m_generic, key, key, func);
+				return make_result(result.first, result.second);
+			}
+			}
+		}
+
+		var &operator[](const var &key)
+		{
+			return find_or_emplace(key, [] {
+				return var();
+			}).first->second;
+		}
+
+		std::size_t erase(const var &key)
+		{
+			std::size_t count = 0;
+			switch (m_kind) {
+			case kind::string:
+				count = key.type() == typeid(string) ? m_strings.erase(key.const_val<string>()) : 0;
+				break;
+			case kind::number:
+				count = key.type() == typeid(number) ? m_numbers.erase(key.const_val<number>()) : 0;
+				break;
+			default:
+				count = m_generic.erase(key);
+			}
+			if (count > 0)
+				++m_version;
+			return count;
+		}
+
+		void erase(iterator it)
+		{
+			++m_version;
+			switch (m_kind) {
+			case kind::string:
+				m_strings.erase(it.m_string);
+				break;
+			case kind::number:
+				m_numbers.erase(it.m_number);
+				break;
+			default:
+				m_generic.erase(it.m_generic);
+			}
+		}
+
+		bool operator==(const hash_map &map) const
+		{
+			if (size() != map.size())
+				return false;
+			for (auto &it:*this) {
+				auto pos = map.find(it.first);
+				if (pos == map.end() || pos->second != it.second)
+					return false;
+			}
+			return true;
+		}
+	};
+
+	/*
+	* Hash map which can be shared by multiple threads
+	* Entries are distributed into shards by hash and every shard is guarded by its own mutex,
+	* which is the layout of phmap::parallel_flat_hash_map.
+	* Callbacks are invoked without the lock and the result is only stored if the shard was not changed meanwhile,
+	* otherwise the callback is invoked again, so callbacks may access the same map.
+	*/
+	class concurrent_hash_map final {
+		static constexpr std::size_t shard_bits = 4;
+		static constexpr std::size_t shard_count = 1 << shard_bits;
+
+		struct shard_type final {
+			mutable std::mutex lock;
+			hash_map data;
+			// Increased by every modification of the shard
+			std::size_t version = 0;
+		};
+
+		shard_type m_shards[shard_count];
+
+		shard_type &get_shard(const var &key)
+		{
+			std::size_t hash = key.hash();
+			return m_shards[(hash ^ (hash >> shard_bits)) & (shard_count - 1)];
+		}
+
+		const shard_type &get_shard(const var &key) const
+		{
+			std::size_t hash = key.hash();
+			return m_shards[(hash ^ (hash >> shard_bits)) & (shard_count - 1)];
+		}
+
+	public:
+		concurrent_hash_map() = default;
+
+		concurrent_hash_map(const concurrent_hash_map &map)
+		{
+			for (std::size_t i = 0; i < shard_count; ++i) {
+				std::lock_guard<std::mutex> guard(map.m_shards[i].lock);
+				for (auto &it:map.m_shards[i].data)
+					m_shards[i].data.emplace(copy(it.first), copy(it.second));
+			}
+		}
+
+		concurrent_hash_map &operator=(const concurrent_hash_map &) = delete;
+
+		bool empty() const
+		{
+			for (auto &shard:m_shards) {
+				std::lock_guard<std::mutex> guard(shard.lock);
+				if (!shard.data.empty())
+					return false;
+			}
+			return true;
+		}
+
+		std::size_t size() const
+		{
+			std::size_t count = 0;
+			for (auto &shard:m_shards) {
+				std::lock_guard<std::mutex> guard(shard.lock);
+				count += shard.data.size();
+			}
+			return count;
+		}
+
+		void clear()
+		{
+			for (auto &shard:m_shards) {
+				std::lock_guard<std::mutex> guard(shard.lock);
+				shard.data.clear();
+				++shard.version;
+			}
+		}
+
+		void insert(const var &key, const var &val)
+		{
+			shard_type &shard = get_shard(key);
+			std::lock_guard<std::mutex> guard(shard.lock);
+			auto result = shard.data.find_or_emplace(key, [&val] {
+				return copy(val);
+			});
+			if (!result.second)
+				result.first->second.swap(copy(val), true);
+			++shard.version;
+		}
+
+		bool erase(const var &key)
+		{
+			shard_type &shard = get_shard(key);
+			std::lock_guard<std::mutex> guard(shard.lock);
+			if (shard.data.erase(key) == 0)
+				return false;
+			++shard.version;
+			return true;
+		}
+
+		bool exist(const var &key) const
+		{
+			const shard_type &shard = get_shard(key);
+			std::lock_guard<std::mutex> guard(shard.lock);
+			return shard.data.count(key) > 0;
+		}
+
+		/*
+		* Reference counts of var are not atomic, so the stored values never leave the locked shard:
+		* lookups return copies and the functions of updates see copies.
+		*/
+		var get_or_default(const var &key, const var &val) const
+		{
+			const shard_type &shard = get_shard(key);
+			std::lock_guard<std::mutex> guard(shard.lock);
+			auto it = shard.data.find(key);
+			if (it != shard.data.end())
+				return copy(it->second);
+			else
+				return val;
+		}
+
+		// Inserts val if the key does not exist, otherwise replaces the value with func(value)
+		template<typename T>
+		void insert_or_update(const var &key, const var &val, T &&func)
+		{
+			shard_type &shard = get_shard(key);
+			while (true) {
+				var current;
+				std::size_t version = 0;
+				{
+					std::lock_guard<std::mutex> guard(shard.lock);
+					auto result = shard.data.find_or_emplace(key, [&val] {
+						return copy(val);
+					});
+					if (result.second) {
+						++shard.version;
+						return;
+					}
+					current = copy(result.first->second);
+					version = shard.version;
+				}
+				var updated = copy(func(current));
+				std::lock_guard<std::mutex> guard(shard.lock);
+				if (shard.version != version)
+					continue;
+				auto it = shard.data.find(key);
+				it->second.swap(updated, true);
+				++shard.version;
+				return;
+			}
+		}
+
+		// Erases the entry if pred(value) returns true
+		template<typename T>
+		bool erase_if(const var &key, T &&pred)
+		{
+			shard_type &shard = get_shard(key);
+			while (true) {
+				var current;
+				std::size_t version = 0;
+				{
+					std::lock_guard<std::mutex> guard(shard.lock);
+					auto it = shard.data.find(key);
+					if (it == shard.data.end())
+						return false;
+					current = copy(it->second);
+					version = shard.version;
+				}
+				if (!pred(current))
+					return false;
+				std::lock_guard<std::mutex> guard(shard.lock);
+				if (shard.version != version)
+					continue;
+				shard.data.erase(key);
+				++shard.version;
+				return true;
+			}
+		}
+
+		hash_map snapshot() const
+		{
+			hash_map map;
+			map.reserve(size());
+			for (auto &shard:m_shards) {
+				std::lock_guard<std::mutex> guard(shard.lock);
+				for (auto &it:shard.data)
+					map.emplace(copy(it.first), copy(it.second));
+			}
+			return std::move(map);
+		}
+	};
+
+	// Default ordering of numbers, strings and chars, values of different types can not be ordered
+	struct var_less final {
+		static void check(const var &val)
+		{
+			if (val.type() != typeid(number) && val.type() != typeid(string) && val.type() != typeid(char))
+				throw lang_error("Only numbers, strings and chars can be ordered by default.");
+		}
+
+		bool operator()(const var &a, const var &b) const
+		{
+			if (a.type() != b.type())
+				throw lang_error("Values of different types can not be ordered by default.");
+			if (a.type() == typeid(number))
+				return a.const_val<number>() < b.const_val<number>();
+			else if (a.type() == typeid(string))
+				return a.const_val<string>() < b.const_val<string>();
+			else if (a.type() == typeid(char))
+				return a.const_val<char>() < b.const_val<char>();
+			else
+				throw lang_error("Only numbers, strings and chars can be ordered by default.");
+		}
+	};
+
+	/*
+	* Binary min-heap, the smallest element is on the top
+	* Pairs are ordered by their first element, so that a value can be queued with its priority.
+	* Keys are checked when pushed, so the comparisons of the heap operations never throw.
+	*/
+	class priority_queue final {
+		std::vector<var> m_heap;
+
+		static const var &key_of(const var &val)
+		{
+			return val.type() == typeid(pair) ? val.const_val<pair>().first : val;
+		}
+
+		static bool greater(const var &a, const var &b)
+		{
+			return var_less()(key_of(b), key_of(a));
+		}
+
+	public:
+		bool empty() const
+		{
+			return m_heap.empty();
+		}
+
+		std::size_t size() const
+		{
+			return m_heap.size();
+		}
+
+		void clear()
+		{
+			m_heap.clear();
+		}
+
+		void push(const var &val)
+		{
+			var_less::check(key_of(val));
+			if (!m_heap.empty())
+				var_less()(key_of(val), key_of(m_heap.front()));
+			m_heap.push_back(copy(val));
+			std::push_heap(m_heap.begin(), m_heap.end(), greater);
+		}
+
+		const var &top() const
+		{
+			if (m_heap.empty())
+				throw lang_error("Priority queue is empty.");
+			return m_heap.front();
+		}
+
+		void pop()
+		{
+			if (m_heap.empty())
+				throw lang_error("Priority queue is empty.");
+			std::pop_heap(m_heap.begin(), m_heap.end(), greater);
+			m_heap.pop_back();
+		}
+
+		// Elements from the smallest to the largest
+		std::vector<var> sorted() const
+		{
+			std::vector<var> data(m_heap);
+			std::sort_heap(data.begin(), data.end(), greater);
+			std::reverse(data.begin(), data.end());
+			return std::move(data);
+		}
+
+		void detach()
+		{
+			for (auto &it:m_heap)
+				copy_no_return(it);
+		}
+	};
+
+	/*
+	* Ordered container with a two-level B-tree layout
+	* Elements are kept sorted in contiguous blocks of bounded size, and the blocks are found by
+	* binary searching their last keys. A lookup touches few cache lines and iteration is sequential,
+	* insertion and erasure move at most one block.
+	*/
+	template<typename T, typename KeyOfT>
+	class ordered_tree final {
+		static constexpr std::size_t block_limit = 512;
+		std::vector<std::vector<T>> m_blocks;
+		std::size_t m_size = 0;
+
+		static bool less(const var &a, const var &b)
+		{
+			return var_less()(a, b);
+		}
+
+		// Position of the first element not less than the key
+		std::pair<std::size_t, std::size_t> lower_position(const var &key) const
+		{
+			auto block = std::partition_point(m_blocks.begin(), m_blocks.end(), [&key](const std::vector<T> &it) {
+				return less(KeyOfT()(it.back()), key);
+			});
+			if (block == m_blocks.end())
+				return {m_blocks.size(), 0};
+			auto pos = std::partition_point(block->begin(), block->end(), [&key](const T &it) {
+				return less(KeyOfT()(it), key);
+			});
+			return {block - m_blocks.begin(), pos - block->begin()};
+		}
+
+		// Position of the first element greater than the key
+		std::pair<std::size_t, std::size_t> upper_position(const var &key) const
+		{
+			auto block = std::partition_point(m_blocks.begin(), m_blocks.end(), [&key](const std::vector<T> &it) {
+				return !less(key, KeyOfT()(it.back()));
+			});
+			if (block == m_blocks.end())
+				return {m_blocks.size(), 0};
+			auto pos = std::partition_point(block->begin(), block->end(), [&key](const T &it) {
+				return !less(key, KeyOfT()(it));
+			});
+			return {block - m_blocks.begin(), pos - block->begin()};
+		}
+
+	public:
+		bool empty() const
+		{
+			return m_size == 0;
+		}
+
+		std::size_t size() const
+		{
+			return m_size;
+		}
+
+		void clear()
+		{
+			m_blocks.clear();
+			m_size = 0;
+		}
+
+		T *find(const var &key)
+		{
+			auto pos = lower_position(key);
+			if (pos.first == m_blocks.size())
+				return nullptr;
+			T &val = m_blocks[pos.first][pos.second];
+			return less(key, KeyOfT()(val)) ? nullptr : &val;
+		}
+
+		const T *find(const var &key) const
+		{
+			return const_cast<ordered_tree *>(this)->find(key);
+		}
+
+		// Returns false if the key exists, the container is unchanged if the key can not be ordered
+		bool insert(T &&val)
+		{
+			const var &key = KeyOfT()(val);
+			var_less::check(key);
+			if (m_blocks.empty()) {
+				m_blocks.emplace_back();
+				m_blocks.back().push_back(std::move(val));
+				m_size = 1;
+				return true;
+			}
+			auto pos = lower_position(key);
+			if (pos.first == m_blocks.size()) {
+				pos.first = m_blocks.size() - 1;
+				pos.second = m_blocks.back().size();
+			}
+			else if (!less(key, KeyOfT()(m_blocks[pos.first][pos.second])))
+				return false;
+			std::vector<T> &block = m_blocks[pos.first];
+			block.insert(block.begin() + pos.second, std::move(val));
+			++m_size;
+			if (block.size() > 2 * block_limit) {
+				std::vector<T> half(std::make_move_iterator(block.begin() + block_limit),
+				                    std::make_move_iterator(block.end()));
+				block.resize(block_limit);
+				m_blocks.insert(m_blocks.begin() + pos.first + 1, std::move(half));
+			}
+			return true;
+		}
+
+		bool erase(const var &key)
+		{
+			auto pos = lower_position(key);
+			if (pos.first == m_blocks.size() || less(key, KeyOfT()(m_blocks[pos.first][pos.second])))
+				return false;
+			std::vector<T> &block = m_blocks[pos.first];
+			block.erase(block.begin() + pos.second);
+			--m_size;
+			if (block.empty())
+				m_blocks.erase(m_blocks.begin() + pos.first);
+			else if (block.size() < block_limit / 4 && m_blocks.size() > 1) {
+				// Small blocks are merged into a neighbor, so that the blocks stay dense
+				std::size_t first = pos.first + 1 < m_blocks.size() ? pos.first : pos.first - 1;
+				std::vector<T> &low = m_blocks[first], &high = m_blocks[first + 1];
+				if (low.size() + high.size() <= 2 * block_limit) {
+					low.insert(low.end(), std::make_move_iterator(high.begin()), std::make_move_iterator(high.end()));
+					m_blocks.erase(m_blocks.begin() + first + 1);
+				}
+			}
+			return true;
+		}
+
+		const T *front() const
+		{
+			return m_blocks.empty() ? nullptr : &m_blocks.front().front();
+		}
+
+		const T *back() const
+		{
+			return m_blocks.empty() ? nullptr : &m_blocks.back().back();
+		}
+
+		// The first element whose key is not less than the key
+		const T *lower_bound(const var &key) const
+		{
+			auto pos = lower_position(key);
+			return pos.first == m_blocks.size() ? nullptr : &m_blocks[pos.first][pos.second];
+		}
+
+		// The first element whose key is greater than the key
+		const T *upper_bound(const var &key) const
+		{
+			auto pos = upper_position(key);
+			return pos.first == m_blocks.size() ? nullptr : &m_blocks[pos.first][pos.second];
+		}
+
+		// Calls func with the elements whose keys are in [low, high), in ascending order
+		template<typename FuncT>
+		void for_each_range(const var &low, const var &high, FuncT &&func) const
+		{
+			for (auto pos = lower_position(low); pos.first < m_blocks.size(); ++pos.first, pos.second = 0) {
+				const std::vector<T> &block = m_blocks[pos.first];
+				for (; pos.second < block.size(); ++pos.second) {
+					if (!less(KeyOfT()(block[pos.second]), high))
+						return;
+					func(block[pos.second]);
+				}
+			}
+		}
+
+		template<typename FuncT>
+		void for_each(FuncT &&func) const
+		{
+			for (auto &block:m_blocks)
+				for (auto &it:block)
+					func(it);
+		}
+
+		template<typename FuncT>
+		void for_each(FuncT &&func)
+		{
+			for (auto &block:m_blocks)
+				for (auto &it:block)
+					func(it);
+		}
+	};
+
+	struct set_key final {
+		const var &operator()(const var &val) const
+		{
+			return val;
+		}
+	};
+
+	struct map_key final {
+		const var &operator()(const pair &val) const
+		{
+			return val.first;
+		}
+	};
+
+	using ordered_set = ordered_tree<var, set_key>;
+	using ordered_map = ordered_tree<pair, map_key>;
+
+	// Bitset of variable size
+	class bitset final {
+		static constexpr std::size_t word_bits = 64;
+		std::vector<std::uint64_t> m_words;
+		std::size_t m_size = 0;
+
+		void check(std::size_t pos) const
+		{
+			if (pos >= m_size)
+				throw lang_error("Out of range.");
+		}
+
+		void check(const bitset &other) const
+		{
+			if (other.m_size != m_size)
+				throw lang_error("Bitsets must have the same size.");
+		}
+
+		// Bits out of the size are always zero
+		void trim()
+		{
+			if (m_size % word_bits != 0)
+				m_words.back() &= (std::uint64_t(1) << (m_size % word_bits)) - 1;
+		}
+
+		static std::size_t count_trailing_zeros(std::uint64_t word)
+		{
+			std::size_t count = 0;
+			for (; (word & 0xff) == 0; word >>= 8)
+				count += 8;
+			for (; (word & 1) == 0; word >>= 1)
+				++count;
+			return count;
+		}
+
+	public:
+		static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+		std::size_t size() const
+		{
+			return m_size;
+		}
+
+		void resize(std::size_t size)
+		{
+			m_size = size;
+			m_words.resize((size + word_bits - 1) / word_bits, 0);
+			trim();
+		}
+
+		bool test(std::size_t pos) const
+		{
+			check(pos);
+			return (m_words[pos / word_bits] >> (pos % word_bits)) & 1;
+		}
+
+		void set(std::size_t pos)
+		{
+			check(pos);
+			m_words[pos / word_bits] |= std::uint64_t(1) << (pos % word_bits);
+		}
+
+		void reset(std::size_t pos)
+		{
+			check(pos);
+			m_words[pos / word_bits] &= ~(std::uint64_t(1) << (pos % word_bits));
+		}
+
+		void flip(std::size_t pos)
+		{
+			check(pos);
+			m_words[pos / word_bits] ^= std::uint64_t(1) << (pos % word_bits);
+		}
+
+		void set_all()
+		{
+			std::fill(m_words.begin(), m_words.end(), ~std::uint64_t(0));
+			trim();
+		}
+
+		void reset_all()
+		{
+			std::fill(m_words.begin(), m_words.end(), 0);
+		}
+
+		std::size_t count() const
+		{
+			std::size_t count = 0;
+			for (auto word:m_words) {
+				// Clears the lowest set bit in each step
+				for (; word != 0; word &= word - 1)
+					++count;
+			}
+			return count;
+		}
+
+		bool any() const
+		{
+			for (auto word:m_words)
+				if (word != 0)
+					return true;
+			return false;
+		}
+
+		// Position of the first set bit not before pos, or npos if there is none
+		std::size_t find_next(std::size_t pos) const
+		{
+			if (pos >= m_size)
+				return npos;
+			std::size_t idx = pos / word_bits;
+			std::uint64_t word = m_words[idx] & (~std::uint64_t(0) << (pos % word_bits));
+			while (word == 0) {
+				if (++idx == m_words.size())
+					return npos;
+				word = m_words[idx];
+			}
+			return idx * word_bits + count_trailing_zeros(word);
+		}
+
+		void and_with(const bitset &other)
+		{
+			check(other);
+			for (std::size_t i = 0; i < m_words.size(); ++i)
+				m_words[i] &= other.m_words[i];
+		}
+
+		void or_with(const bitset &other)
+		{
+			check(other);
+			for (std::size_t i = 0; i < m_words.size(); ++i)
+				m_words[i] |= other.m_words[i];
+		}
+
+		void xor_with(const bitset &other)
+		{
+			check(other);
+			for (std::size_t i = 0; i < m_words.size(); ++i)
+				m_words[i] ^= other.m_words[i];
+		}
+
+		bool operator==(const bitset &other) const
+		{
+			return m_size == other.m_size && m_words == other.m_words;
+		}
+	};
+
+	/*
+	* Persistent vector, a 32-way trie whose last leaf is kept aside as the tail
+	* The nodes are never modified once built. An update copies the nodes on the path to the
+	* changed element and shares all of the others with the previous version, so both stay valid.
+	*/
+	class persistent_vector final {
+		static constexpr std::size_t bits = 5, width = std::size_t(1) << bits, mask = width - 1;
+
+		struct node final {
+			std::vector<std::shared_ptr<const node>> children;
+			std::vector<var> values;
+		};
+
+		using node_ptr = std::shared_ptr<const node>;
+
+		node_ptr m_root = std::make_shared<node>();
+		node_ptr m_tail = std::make_shared<node>();
+		std::size_t m_size = 0, m_shift = bits;
+
+		std::size_t tail_offset() const
+		{
+			return m_size < width ? 0 : ((m_size - 1) >> bits) << bits;
+		}
+
+		const node *leaf_of(std::size_t pos) const
+		{
+			if (pos >= tail_offset())
+				return m_tail.get();
+			const node *n = m_root.get();
+			for (std::size_t level = m_shift; level > 0; level -= bits)
+				n = n->children[(pos >> level) & mask].get();
+			return n;
+		}
+
+		static node_ptr new_path(std::size_t level, const node_ptr &leaf)
+		{
+			if (level == 0)
+				return leaf;
+			auto n = std::make_shared<node>();
+			n->children.push_back(new_path(level - bits, leaf));
+			return n;
+		}
+
+		static node_ptr assign(const node_ptr &parent, std::size_t level, std::size_t pos, const var &val)
+		{
+			auto n = std::make_shared<node>(*parent);
+			if (level == 0)
+				n->values[pos & mask] = val;
+			else {
+				std::size_t idx = (pos >> level) & mask;
+				n->children[idx] = assign(parent->children[idx], level - bits, pos, val);
+			}
+			return n;
+		}
+
+		// The tail is full and moves into the trie, m_size is the size before the push
+		node_ptr push_tail(const node_ptr &parent, std::size_t level) const
+		{
+			auto n = std::make_shared<node>(*parent);
+			std::size_t idx = ((m_size - 1) >> level) & mask;
+			node_ptr child;
+			if (level == bits)
+				child = m_tail;
+			else if (idx < parent->children.size())
+				child = push_tail(parent->children[idx], level - bits);
+			else
+				child = new_path(level - bits, m_tail);
+			if (idx < n->children.size())
+				n->children[idx] = child;
+			else
+				n->children.push_back(child);
+			return n;
+		}
+
+		// The last leaf leaves the trie, returns null if the node becomes empty
+		node_ptr pop_tail(const node_ptr &parent, std::size_t level) const
+		{
+			std::size_t idx = ((m_size - 2) >> level) & mask;
+			if (level > bits) {
+				node_ptr child = pop_tail(parent->children[idx], level - bits);
+				if (child == nullptr && idx == 0)
+					return nullptr;
+				auto n = std::make_shared<node>(*parent);
+				if (child == nullptr)
+					n->children.pop_back();
+				else
+					n->children[idx] = child;
+				return n;
+			}
+			else if (idx == 0)
+				return nullptr;
+			auto n = std::make_shared<node>(*parent);
+			n->children.pop_back();
+			return n;
+		}
+
+		template<typename FuncT>
+		static void for_each_in(const node *n, FuncT &&func)
+		{
+			for (auto &it:n->children)
+				for_each_in(it.get(), func);
+			for (auto &it:n->values)
+				func(it);
+		}
+
+		void check(std::size_t pos) const
+		{
+			if (pos >= m_size)
+				throw lang_error("Out of range.");
+		}
+
+	public:
+		persistent_vector() = default;
+
+		// Builds the trie level by level, which is much cheaper than pushing the elements one by one
+		template<typename IteratorT>
+		persistent_vector(IteratorT begin, IteratorT end)
+		{
+			std::vector<node_ptr> level;
+			std::shared_ptr<node> leaf = std::make_shared<node>();
+			for (; begin != end; ++begin) {
+				if (leaf->values.size() == width) {
+					level.push_back(leaf);
+					leaf = std::make_shared<node>();
+				}
+				leaf->values.push_back(*begin);
+				++m_size;
+			}
+			m_tail = leaf;
+			if (level.empty())
+				return;
+			for (;;) {
+				std::vector<node_ptr> parents;
+				for (std::size_t i = 0; i < level.size(); i += width) {
+					auto n = std::make_shared<node>();
+					n->children.assign(level.begin() + i, level.begin() + std::min(i + width, level.size()));
+					parents.push_back(n);
+				}
+				level.swap(parents);
+				if (level.size() == 1)
+					break;
+				m_shift += bits;
+			}
+			m_root = level.front();
+		}
+
+		bool empty() const
+		{
+			return m_size == 0;
+		}
+
+		std::size_t size() const
+		{
+			return m_size;
+		}
+
+		const var &at(std::size_t pos) const
+		{
+			check(pos);
+			return leaf_of(pos)->values[pos & mask];
+		}
+
+		persistent_vector set(std::size_t pos, const var &val) const
+		{
+			check(pos);
+			persistent_vector vec(*this);
+			if (pos >= tail_offset()) {
+				auto tail = std::make_shared<node>(*m_tail);
+				tail->values[pos & mask] = val;
+				vec.m_tail = tail;
+			}
+			else
+				vec.m_root = assign(m_root, m_shift, pos, val);
+			return vec;
+		}
+
+		persistent_vector push_back(const var &val) const
+		{
+			persistent_vector vec(*this);
+			++vec.m_size;
+			if (m_size - tail_offset() < width) {
+				auto tail = std::make_shared<node>(*m_tail);
+				tail->values.push_back(val);
+				vec.m_tail = tail;
+				return vec;
+			}
+			// The root overflows if the trie is full
+			if ((m_size >> bits) > (std::size_t(1) << m_shift)) {
+				auto root = std::make_shared<node>();
+				root->children.push_back(m_root);
+				root->children.push_back(new_path(m_shift, m_tail));
+				vec.m_root = root;
+				vec.m_shift += bits;
+			}
+			else
+				vec.m_root = push_tail(m_root, m_shift);
+			auto tail = std::make_shared<node>();
+			tail->values.push_back(val);
+			vec.m_tail = tail;
+			return vec;
+		}
+
+		persistent_vector pop_back() const
+		{
+			if (m_size == 0)
+				throw lang_error("Pop back from empty vector.");
+			if (m_size == 1)
+				return persistent_vector();
+			persistent_vector vec(*this);
+			--vec.m_size;
+			if (m_size - tail_offset() > 1) {
+				auto tail = std::make_shared<node>(*m_tail);
+				tail->values.pop_back();
+				vec.m_tail = tail;
+				return vec;
+			}
+			// The tail is used up, the last leaf of the trie becomes the new tail
+			node_ptr leaf = m_root;
+			for (std::size_t level = m_shift; level > 0; level -= bits)
+				leaf = leaf->children[((m_size - 2) >> level) & mask];
+			vec.m_tail = leaf;
+			node_ptr root = pop_tail(m_root, m_shift);
+			if (root == nullptr)
+				root = std::make_shared<node>();
+			if (m_shift > bits && root->children.size() == 1) {
+				root = root->children.front();
+				vec.m_shift -= bits;
+			}
+			vec.m_root = root;
+			return vec;
+		}
+
+		template<typename FuncT>
+		void for_each(FuncT &&func) const
+		{
+			for_each_in(m_root.get(), func);
+			for_each_in(m_tail.get(), func);
+		}
+
+		bool operator==(const persistent_vector &vec) const
+		{
+			if (m_size != vec.m_size)
+				return false;
+			if (m_root == vec.m_root && m_tail == vec.m_tail)
+				return true;
+			for (std::size_t i = 0; i < m_size; ++i)
+				if (at(i) != vec.at(i))
+					return false;
+			return true;
+		}
+	};
+
+	/*
+	* Persistent map, a hash array mapped trie
+	* Each level consumes 5 bits of the hash of the key, and a node only stores the slots whose
+	* bits are set in its bitmap. Keys whose hashes are totally equal end in a collision node,
+	* which is searched linearly. Like persistent_vector, an update only copies one path.
+	*/
+	class persistent_map final {
+		static constexpr std::size_t bits = 5, mask = (std::size_t(1) << bits) - 1;
+		static constexpr std::size_t hash_bits = std::numeric_limits<std::size_t>::digits;
+
+		struct node;
+
+		using node_ptr = std::shared_ptr<const node>;
+
+		// Either an entry of the map or a sub-tree
+		struct slot final {
+			std::size_t hash = 0;
+			pair data;
+			node_ptr child;
+		};
+
+		// Nodes below all of the hash bits are collision nodes, their bitmap is unused
+		struct node final {
+			std::uint32_t bitmap = 0;
+			std::vector<slot> slots;
+		};
+
+		node_ptr m_root;
+		std::size_t m_size = 0;
+
+		static std::size_t popcount(std::uint32_t word)
+		{
+			word = word - ((word >> 1) & 0x55555555);
+			word = (word & 0x33333333) + ((word >> 2) & 0x33333333);
+			return (((word + (word >> 4)) & 0x0f0f0f0f) * 0x01010101) >> 24;
+		}
+
+		static std::uint32_t bit_of(std::size_t hash, std::size_t shift)
+		{
+			return std::uint32_t(1) << ((hash >> shift) & mask);
+		}
+
+		static node_ptr merge(const slot &a, const slot &b, std::size_t shift)
+		{
+			auto n = std::make_shared<node>();
+			if (shift >= hash_bits) {
+				n->slots = {a, b};
+				return n;
+			}
+			std::uint32_t bit_a = bit_of(a.hash, shift), bit_b = bit_of(b.hash, shift);
+			if (bit_a == bit_b) {
+				n->bitmap = bit_a;
+				n->slots.resize(1);
+				n->slots.front().child = merge(a, b, shift + bits);
+			}
+			else {
+				n->bitmap = bit_a | bit_b;
+				n->slots = bit_a < bit_b ? std::vector<slot> {a, b} : std::vector<slot> {b, a};
+			}
+			return n;
+		}
+
+		static node_ptr insert(const node_ptr &parent, std::size_t shift, const slot &entry, bool &added)
+		{
+			if (shift >= hash_bits) {
+				auto n = std::make_shared<node>(*parent);
+				for (auto &it:n->slots) {
+					if (it.data.first == entry.data.first) {
+						it.data.second = entry.data.second;
+						return n;
+					}
+				}
+				n->slots.push_back(entry);
+				added = true;
+				return n;
+			}
+			std::uint32_t bit = bit_of(entry.hash, shift);
+			std::size_t idx = popcount(parent->bitmap & (bit - 1));
+			auto n = std::make_shared<node>(*parent);
+			if ((parent->bitmap & bit) == 0) {
+				n->bitmap |= bit;
+				n->slots.insert(n->slots.begin() + idx, entry);
+				added = true;
+				return n;
+			}
+			slot &it = n->slots[idx];
+			if (it.child != nullptr)
+				it.child = insert(it.child, shift + bits, entry, added);
+			else if (it.hash == entry.hash && it.data.first == entry.data.first)
+				it.data.second = entry.data.second;
+			else {
+				it.child = merge(it, entry, shift + bits);
+				it.data = pair();
+				added = true;
+			}
+			return n;
+		}
+
+		// Returns null if the node becomes empty
+		static node_ptr erase(const node_ptr &parent, std::size_t shift, std::size_t hash, const var &key, bool &removed)
+		{
+			if (shift >= hash_bits) {
+				for (std::size_t i = 0; i < parent->slots.size(); ++i) {
+					if (parent->slots[i].data.first == key) {
+						removed = true;
+						if (parent->slots.size() == 1)
+							return nullptr;
+						auto n = std::make_shared<node>(*parent);
+						n->slots.erase(n->slots.begin() + i);
+						return n;
+					}
+				}
+				return parent;
+			}
+			std::uint32_t bit = bit_of(hash, shift);
+			if ((parent->bitmap & bit) == 0)
+				return parent;
+			std::size_t idx = popcount(parent->bitmap & (bit - 1));
+			const slot &it = parent->slots[idx];
+			node_ptr child;
+			if (it.child != nullptr) {
+				child = erase(it.child, shift + bits, hash, key, removed);
+				if (child == it.child)
+					return parent;
+			}
+			else if (it.hash != hash || it.data.first != key)
+				return parent;
+			else
+				removed = true;
+			auto n = std::make_shared<node>(*parent);
+			// A sub-tree left with a single entry is pulled up into this node
+			if (child != nullptr && child->slots.size() == 1 && child->slots.front().child == nullptr)
+				n->slots[idx] = child->slots.front();
+			else if (child != nullptr)
+				n->slots[idx].child = child;
+			else {
+				n->bitmap &= ~bit;
+				n->slots.erase(n->slots.begin() + idx);
+				if (n->slots.empty())
+					return nullptr;
+			}
+			return n;
+		}
+
+		template<typename FuncT>
+		static void for_each_in(const node *n, FuncT &&func)
+		{
+			for (auto &it:n->slots) {
+				if (it.child != nullptr)
+					for_each_in(it.child.get(), func);
+				else
+					func(it.data);
+			}
+		}
+
+	public:
+		/*
+		* Depth-first cursor
+		* The map being walked has to outlive the cursor, it never changes so nothing is invalidated.
+		*/
+		class cursor final {
+			std::vector<std::pair<const node *, std::size_t>> m_stack;
+		public:
+			explicit cursor(const persistent_map &map)
+			{
+				if (map.m_root != nullptr)
+					m_stack.emplace_back(map.m_root.get(), 0);
+			}
+
+			// Returns null at the end
+			const pair *next()
+			{
+				while (!m_stack.empty()) {
+					auto &top = m_stack.back();
+					if (top.second == top.first->slots.size()) {
+						m_stack.pop_back();
+						continue;
+					}
+					const slot &it = top.first->slots[top.second++];
+					if (it.child != nullptr)
+						m_stack.emplace_back(it.child.get(), 0);
+					else
+						return &it.data;
+				}
+				return nullptr;
+			}
+		};
+
+		bool empty() const
+		{
+			return m_size == 0;
+		}
+
+		std::size_t size() const
+		{
+			return m_size;
+		}
+
+		const pair *find(const var &key) const
+		{
+			std::size_t hash = key.hash();
+			const node *n = m_root.get();
+			for (std::size_t shift = 0; n != nullptr; shift += bits) {
+				if (shift >= hash_bits) {
+					for (auto &it:n->slots)
+						if (it.data.first == key)
+							return &it.data;
+					return nullptr;
+				}
+				std::uint32_t bit = bit_of(hash, shift);
+				if ((n->bitmap & bit) == 0)
+					return nullptr;
+				const slot &it = n->slots[popcount(n->bitmap & (bit - 1))];
+				if (it.child == nullptr)
+					return it.hash == hash && it.data.first == key ? &it.data : nullptr;
+				n = it.child.get();
+			}
+			return nullptr;
+		}
+
+		persistent_map insert(const var &key, const var &val) const
+		{
+			slot entry;
+			entry.hash = key.hash();
+			entry.data = pair(key, val);
+			persistent_map map;
+			map.m_size = m_size;
+			if (m_root == nullptr) {
+				auto n = std::make_shared<node>();
+				n->bitmap = bit_of(entry.hash, 0);
+				n->slots.push_back(entry);
+				map.m_root = n;
+				map.m_size = 1;
+				return map;
+			}
+			bool added = false;
+			map.m_root = insert(m_root, 0, entry, added);
+			if (added)
+				++map.m_size;
+			return map;
+		}
+
+		persistent_map erase(const var &key) const
+		{
+			if (m_root == nullptr)
+				return *this;
+			bool removed = false;
+			persistent_map map;
+			map.m_root = erase(m_root, 0, key.hash(), key, removed);
+			map.m_size = removed ? m_size - 1 : m_size;
+			return map;
+		}
+
+		template<typename FuncT>
+		void for_each(FuncT &&func) const
+		{
+			if (m_root != nullptr)
+				for_each_in(m_root.get(), func);
+		}
+
+		bool operator==(const persistent_map &map) const
+		{
+			if (m_size != map.m_size)
+				return false;
+			if (m_root == map.m_root)
+				return true;
+			bool equal = true;
+			for_each([&map, &equal](const pair &it) {
+				if (equal) {
+					const pair *other = map.find(it.first);
+					equal = other != nullptr && other->second == it.second;
+				}
+			});
+			return equal;
+		}
+	};
+
+	/*
+	* Layout of struct instances
+	* Instances built by the same struct_builder share one immutable layout, which maps the
+	* member names to the offsets of the fields. Members inherited from the parent struct
+	* have the same offsets as in the layout of the parent.
+	*/
+	class structure;
+
+	class struct_layout final {
+		friend class structure;
+
+		static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+		map_t<symbol, std::size_t> m_reflect;
+		// Points into the symbol pool, which is never released
+		std::vector<const std::string *> m_names;
+		// Cache key of var_id, shared by all of the instances
+		std::shared_ptr<domain_ref> m_ref;
+		std::string m_name;
+		type_id m_id;
+		std::size_t m_parent = npos, m_parent_size = 0;
+		std::size_t m_initialize = npos, m_duplicate = npos, m_finalize = npos, m_equal = npos;
+
+		std::size_t find(const std::string &name) const
+		{
+			auto it = m_reflect.find(symbol::probe(name));
+			return it != m_reflect.end() ? it->second : npos;
+		}
+
+	public:
+		struct_layout() = delete;
+
+		struct_layout(const type_id &id, std::string name, const domain_type &data, std::size_t parent_size) :
+			m_ref(std::make_shared<domain_ref>(nullptr)), m_name(std::move(name)), m_id(id),
+			m_parent_size(parent_size)
+		{
+			m_names.resize(data.size());
+			for (auto &it:data) {
+				m_reflect.emplace(it.first, it.second);
+				m_names[it.second] = &it.first.str();
+			}
+			m_parent = find("parent");
+			m_initialize = find("initialize");
+			m_duplicate = find("duplicate");
+			m_finalize = find("finalize");
+			m_equal = find("equal");
+		}
+
+		struct_layout(const struct_layout &) = delete;
+
+		std::size_t size() const noexcept
+		{
+			return m_names.size();
+		}
+
+		const std::string &get_name(std::size_t offset) const
+		{
+			return *m_names[offset];
+		}
+
+		bool exist(const std::string &name) const
+		{
+			return m_reflect.count(symbol::probe(name)) > 0;
+		}
+
+		std::size_t get_offset(const var_id &id) const
+		{
+			if (id.m_ref != m_ref) {
+				auto it = m_reflect.find(id.m_id);
+				if (it == m_reflect.end())
+					return npos;
+				id.m_slot_id = it->second;
+				id.m_ref = m_ref;
+			}
+			return id.m_slot_id;
+		}
+
+		std::size_t get_offset(const std::string &name) const
+		{
+			return find(name);
+		}
+	};
+
+	class structure final {
+		bool m_shadow = false;
+		std::shared_ptr<struct_layout> m_layout;
+		std::shared_ptr<std::vector<var>> m_data;
+	public:
+		structure() = delete;
+
+		structure(std::shared_ptr<struct_layout> layout, std::vector<var> data) : m_layout(std::move(layout)),
+			m_data(std::make_shared<std::vector<var>>(std::move(data)))
+		{
+			if (m_layout->m_initialize != struct_layout::npos)
+				invoke((*m_data)[m_layout->m_initialize], var::make<structure>(this));
+		}
+
+		structure(const structure &s) : m_layout(s.m_layout),
+			m_data(std::make_shared<std::vector<var>>(s.m_layout->size()))
+		{
+			const std::vector<var> &src = *s.m_data;
+			std::vector<var> &dst = *m_data;
+			std::size_t parent_offset = m_layout->m_parent;
+			std::size_t parent_size = 0;
+			if (parent_offset != struct_layout::npos) {
+				const var &_p = src[parent_offset];
+				const std::vector<var> &_parent = *_p.const_val<structure>().m_data;
+				var p = copy(_p);
+				const std::vector<var> &parent = *p.const_val<structure>().m_data;
+				dst[parent_offset] = p;
+				parent_size = m_layout->m_parent_size;
+				for (std::size_t i = 0; i < parent_size; ++i) {
+					if (i == parent_offset)
+						continue;
+					// Handle overriding
+					if (!_parent[i].is_same(src[i]))
+						dst[i] = copy(src[i]);
+					else
+						dst[i] = parent[i];
+				}
+			}
+			for (std::size_t i = parent_size; i < dst.size(); ++i)
+				if (i != parent_offset)
+					dst[i] = copy(src[i]);
+			if (m_layout->m_duplicate != struct_layout::npos)
+				invoke(dst[m_layout->m_duplicate], var::make<structure>(this), var::make<structure>(&s));
+		}
+
+		explicit structure(const structure *s) : m_shadow(true), m_layout(s->m_layout), m_data(s->m_data) {}
+
+		~structure()
+		{
+			if (!m_shadow && m_layout->m_finalize != struct_layout::npos)
+				invoke((*m_data)[m_layout->m_finalize], var::make<structure>(this));
+		}
+
+		bool operator==(const structure &s) const
+		{
+			if (s.get_id() != get_id())
+				return false;
+			if (!m_shadow && m_layout->m_equal != struct_layout::npos)
+				return invoke((*m_data)[m_layout->m_equal], var::make<structure>(this),
+				              var::make<structure>(&s)).const_val<bool>();
+			else {
+				for (std::size_t i = 0; i < m_data->size(); ++i) {
+					if (i == m_layout->m_parent)
+						continue;
+					if (s.m_layout == m_layout) {
+						if ((*s.m_data)[i] != (*m_data)[i])
+							return false;
+					}
+					else if (s.get_var(m_layout->get_name(i)) != (*m_data)[i])
+						return false;
+				}
+				return true;
+			}
+		}
+
+		const struct_layout &get_layout() const
+		{
+			return *m_layout;
+		}
+
+		const std::shared_ptr<struct_layout> &get_shared_layout() const
+		{
+			return m_layout;
+		}
+
+		const type_id &get_id() const
+		{
+			return m_layout->m_id;
+		}
+
+		// Caution! Only use for traverse!
+		var &get_var_by_offset(std::size_t offset) const
+		{
+			return (*m_data)[offset];
+		}
+
+		template<typename T>
+		var &get_var(T &&name) const
+		{
+			std::size_t offset = m_layout->get_offset(name);
+			if (offset != struct_layout::npos)
+				return (*m_data)[offset];
+			else
+				throw runtime_error("Struct \"" + m_layout->m_name + "\" have no member called \"" + std::string(name) +
+				                    "\".");
+		}
+	};
+
+	class struct_builder final {
+		static std::size_t mCount;
+		context_t mContext;
+		type_id mTypeId;
+		std::string mName;
+		tree_type<token_base *> mParent;
+		std::deque<statement_base *> mMethod;
+		std::shared_ptr<struct_layout> mLayout;
+		// The parent is evaluated on every construction, the layout is only reused with the same parent layout
+		std::shared_ptr<struct_layout> mParentLayout;
+	public:
+		struct_builder() = delete;
+
+		struct_builder(context_t c, std::string name, tree_type<token_base *> parent,
+		               std::deque<statement_base *> method) : mContext(std::move(std::move(c))),
+			mTypeId(typeid(structure), ++mCount),
+			mName(std::move(name)),
+			mParent(std::move(parent)),
+			mMethod(std::move(method)) {}
+
+		struct_builder(const struct_builder &) = default;
+
+		~struct_builder() = default;
+
+		static void reset_counter()
+		{
+			mCount = 0;
+		}
+
+		const type_id &get_id() const
+		{
+			return mTypeId;
+		}
+
+		var operator()();
+	};
+
+// Namespace and extensions
+	class name_space {
+		domain_type m_data;
+	public:
+		name_space() = default;
+
+		name_space(const name_space &) = delete;
+
+		explicit name_space(domain_type dat) : m_data(std::move(dat)) {}
+
+		virtual ~name_space() = default;
+
+		name_space &add_var(const std::string &name, const var &var)
+		{
+			m_data.add_var(name, var);
+			return *this;
+		}
+
+		name_space &add_var(const var_id &id, const var &var)
+		{
+			m_data.add_var(id, var);
+			return *this;
+		}
+
+		var &get_var(const std::string &name)
+		{
+			return m_data.get_var(name);
+		}
+
+		const var &get_var(const std::string &name) const
+		{
+			return m_data.get_var(name);
+		}
+
+		var &get_var(const var_id &id)
+		{
+			return m_data.get_var(id);
+		}
+
+		const var &get_var(const var_id &id) const
+		{
+			return m_data.get_var(id);
+		}
+
+		const domain_type &get_domain() const
+		{
+			return m_data;
+		}
+
+		void copy_namespace(const name_space &ns)
+		{
+			for (auto &it:ns.m_data)
+				m_data.add_var(it.first, ns.m_data.get_var_by_id(it.second));
+		}
+	};
+
+	template<typename T>
+	var &type_t::get_var(T &&name) const
+	{
+		if (extensions.get() != nullptr)
+			return extensions->get_var(name);
+		else
+			throw runtime_error("Type does not support the extension");
+	}
+
+// Internal Garbage Collection
+	template<typename T>
+	class garbage_collector final {
+		set_t<T *> table;
+	public:
+		garbage_collector() = default;
+
+		garbage_collector(const garbage_collector &) = delete;
+
+		~garbage_collector()
+		{
+			collect();
+		}
+
+		void collect()
+		{
+			for (auto &ptr:table)
+				delete ptr;
+			table.clear();
+		}
+
+		void add(void *ptr)
+		{
+			table.emplace(static_cast<T *>(ptr));
+		}
+
+		void remove(void *ptr)
+		{
+			table.erase(static_cast<T *>(ptr));
+		}
+	};
+
+	namespace dll_resources {
+		constexpr char dll_compatible_check[] = "__CS_ABI_COMPATIBLE__";
+		constexpr char dll_main_entrance[] = "__CS_EXTENSION_MAIN__";
+
+		typedef int(*dll_compatible_check_t)();
+
+		typedef void(*dll_main_entrance_t)(name_space *, process_context *);
+	}
+
+	class extension final : public name_space {
+	public:
+		static garbage_collector<cov::dll> gc;
+
+		extension() = delete;
+
+		extension(const extension &) = delete;
+
+		explicit extension(const std::string &path)
+		{
 			using namespace dll_resources;
 			cov::dll *dll = new cov::dll(path);
 			gc.add(dll);
@@ -898,6 +2975,10 @@ namespace cs {
 
 // Literal format
 	number parse_number(const std::string &);
+
+	bool try_parse_number(const std::string &, number &) noexcept;
+
+	std::string format_number(number, int);
 }
 namespace cs_impl {
 	template<>
@@ -50,6 +50,12 @@ namespace cs {
 
 	class name_space;
 
+	class iterator_base;
+
+	class hash_map;
+
+	class list;
+
 #ifndef CS_COMPATIBILITY_MODE
 	template<typename _kT, typename _vT> using map_t=phmap::flat_hash_map<_kT, _vT>;
 	template<typename _Tp> using set_t=phmap::flat_hash_set<_Tp>;
@@ -61,10 +67,9 @@ namespace cs {
 	using number=long double;
 	using boolean=bool;
 	using string=std::string;
-	using list=std::list<var>;
 	using array=std::deque<var>;
 	using pair=std::pair<var, var>;
-	using hash_map=map_t<var, var>;
+	using byte_buffer=std::vector<std::uint8_t>;
 	using vector=std::vector<var>;
 	using expression_t=tree_type<token_base *>;
 	using compiler_t=std::shared_ptr<compiler_type>;
@@ -72,6 +77,7 @@ namespace cs {
 	using context_t=std::shared_ptr<context_type>;
 	using domain_t=std::shared_ptr<domain_type>;
 	using namespace_t=std::shared_ptr<name_space>;
+	using iterator_t=std::shared_ptr<iterator_base>;
 	using istream=std::shared_ptr<std::istream>;
 	using ostream=std::shared_ptr<std::ostream>;
 
@@ -292,6 +292,13 @@ namespace cs_impl {
 	template<typename T> using default_allocator_provider=std::allocator<T>;
 	template<typename T> using default_allocator=cs::allocator_type<T, default_allocate_buffer_size, default_allocator_provider>;
 
+// Every thread owns its pools when multiple interpreters run concurrently.
+#ifdef CS_THREAD_LOCAL_POOL
+#define CS_ALLOCATOR_STORAGE thread_local
+#else
+#define CS_ALLOCATOR_STORAGE
+#endif
+
 	class any final {
 		class baseHolder {
 		public:
@@ -325,7 +332,7 @@ namespace cs_impl {
 		protected:
 			T mDat;
 		public:
-			static default_allocator<holder<T>> allocator;
+			static CS_ALLOCATOR_STORAGE default_allocator<holder<T>> allocator;
 
 			holder() = default;
 
@@ -420,7 +427,7 @@ namespace cs_impl {
 			}
 		};
 
-		static default_allocator<proxy> allocator;
+		static CS_ALLOCATOR_STORAGE default_allocator<proxy> allocator;
 		proxy *mDat = nullptr;
 
 		proxy *duplicate() const noexcept
@@ -607,6 +614,11 @@ namespace cs_impl {
 			return this->mDat != nullptr && this->mDat->protect_level > 2;
 		}
 
+		std::size_t use_count() const noexcept
+		{
+			return this->mDat != nullptr ? this->mDat->refcount : 0;
+		}
+
 		void mark_as_rvalue(bool value) const
 		{
 			if (this->mDat != nullptr)
@@ -768,7 +780,7 @@ namespace cs_impl {
 		using holder<std::type_index>::holder;
 	};
 
-	template<typename T> default_allocator<any::holder<T>> any::holder<T>::allocator;
+	template<typename T> CS_ALLOCATOR_STORAGE default_allocator<any::holder<T>> any::holder<T>::allocator;
 }
 
 std::ostream &operator<<(std::ostream &, const cs_impl::any &);
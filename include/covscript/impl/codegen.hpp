@@ -461,6 +461,23 @@ namespace cs {
 		statement_base *translate(const context_t &, const std::deque<std::deque<token_base *>> &) override;
 	};
 
+	class method_yield final : public method_base {
+	public:
+		using method_base::method_base;
+
+		method_types get_type() const noexcept override
+		{
+			return method_types::single;
+		}
+
+		statement_types get_target_type() const noexcept override
+		{
+			return statement_types::yield_;
+		}
+
+		statement_base *translate(const context_t &, const std::deque<std::deque<token_base *>> &) override;
+	};
+
 	class method_struct : public method_base {
 	public:
 		using method_base::method_base;
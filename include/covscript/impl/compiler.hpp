@@ -159,6 +159,7 @@ namespace cs {
 			{"function",  action_types::function_},
 			{"override",  action_types::override_},
 			{"return",    action_types::return_},
+			{"yield",     action_types::yield_},
 			{"try",       action_types::try_},
 			{"catch",     action_types::catch_},
 			{"throw",     action_types::throw_}
@@ -250,6 +251,8 @@ namespace cs {
 	private:
 		// Constants Pool
 		std::vector<var> constant_pool;
+		// Equal string literals share one constant
+		map_t<std::string, var> string_pool;
 		// Status
 		bool inside_lambda = false;
 		bool no_optimize = false;
@@ -363,6 +366,9 @@ namespace cs {
 		// Settings
 		bool disable_optimizer = false;
 
+		// Set when a yield statement is translated, functions containing yield become generators
+		bool found_yield = false;
+
 		// Context
 		context_t swap_context(context_t cxt)
 		{
@@ -374,6 +380,7 @@ namespace cs {
 		void clear_metadata()
 		{
 			constant_pool.clear();
+			string_pool.clear();
 		}
 
 		void utilize_metadata()
@@ -397,6 +404,16 @@ namespace cs {
 			return new token_value(val);
 		}
 
+		token_value *new_string(const std::string &str)
+		{
+			auto it = string_pool.find(str);
+			if (it == string_pool.end()) {
+				it = string_pool.emplace(str, var::make<string>(str)).first;
+				add_constant(it->second);
+			}
+			return new token_value(it->second);
+		}
+
 		// Wrapped Method
 		void build_expr(const std::deque<char> &buff, tree_type<token_base *> &tree)
 		{
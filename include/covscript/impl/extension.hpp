@@ -54,15 +54,25 @@ namespace cs_impl {
 			cs::copy_no_return(it.second);
 	}
 
+	template<>
+	void detach<cs::priority_queue>(cs::priority_queue &val)
+	{
+		val.detach();
+	}
+
+	template<>
+	void detach<cs::ordered_map>(cs::ordered_map &val)
+	{
+		val.for_each([](cs::pair &it) {
+			cs::copy_no_return(it.second);
+		});
+	}
+
 // To String
 	template<>
 	std::string to_string<cs::number>(const cs::number &val)
 	{
-		std::stringstream ss;
-		std::string str;
-		ss << std::setprecision(cs::current_process->output_precision) << val;
-		ss >> str;
-		return std::move(str);
+		return cs::format_number(val, cs::current_process->output_precision);
 	}
 
 	template<>
@@ -80,6 +90,15 @@ namespace cs_impl {
 			return cxx_demangle(id.type_idx.name());
 	}
 
+	template<>
+	std::string to_string<cs::bitset>(const cs::bitset &bits)
+	{
+		std::string str;
+		for (std::size_t i = 0; i < bits.size(); ++i)
+			str.push_back(bits.test(i) ? '1' : '0');
+		return std::move(str);
+	}
+
 	template<>
 	std::string to_string<cs::range_type>(const cs::range_type &range)
 	{
@@ -171,6 +190,54 @@ namespace cs_impl {
 		return "cs::hash_map";
 	}
 
+	template<>
+	constexpr const char *get_name_of_type<cs::byte_buffer>()
+	{
+		return "cs::byte_buffer";
+	}
+
+	template<>
+	constexpr const char *get_name_of_type<cs::concurrent_hash_map>()
+	{
+		return "cs::concurrent_hash_map";
+	}
+
+	template<>
+	constexpr const char *get_name_of_type<cs::priority_queue>()
+	{
+		return "cs::priority_queue";
+	}
+
+	template<>
+	constexpr const char *get_name_of_type<cs::ordered_map>()
+	{
+		return "cs::ordered_map";
+	}
+
+	template<>
+	constexpr const char *get_name_of_type<cs::ordered_set>()
+	{
+		return "cs::ordered_set";
+	}
+
+	template<>
+	constexpr const char *get_name_of_type<cs::bitset>()
+	{
+		return "cs::bitset";
+	}
+
+	template<>
+	constexpr const char *get_name_of_type<cs::persistent_vector>()
+	{
+		return "cs::persistent_vector";
+	}
+
+	template<>
+	constexpr const char *get_name_of_type<cs::persistent_map>()
+	{
+		return "cs::persistent_map";
+	}
+
 	template<>
 	constexpr const char *get_name_of_type<cs::type_t>()
 	{
@@ -195,6 +262,12 @@ namespace cs_impl {
 		return "cs::range";
 	}
 
+	template<>
+	constexpr const char *get_name_of_type<cs::iterator_t>()
+	{
+		return "cs::iterator";
+	}
+
 	template<>
 	constexpr const char *get_name_of_type<cs::structure>()
 	{
@@ -227,9 +300,20 @@ namespace cs_impl {
 	extern cs::namespace_t char_ext;
 	extern cs::namespace_t math_ext;
 	extern cs::namespace_t math_const_ext;
+	extern cs::namespace_t math_vector_ext;
 	extern cs::namespace_t list_ext;
 	extern cs::namespace_t list_iterator_ext;
 	extern cs::namespace_t hash_map_ext;
+	extern cs::namespace_t byte_buffer_ext;
+	extern cs::namespace_t iterator_ext;
+	extern cs::namespace_t range_ext;
+	extern cs::namespace_t concurrent_hash_map_ext;
+	extern cs::namespace_t priority_queue_ext;
+	extern cs::namespace_t ordered_map_ext;
+	extern cs::namespace_t ordered_set_ext;
+	extern cs::namespace_t bitset_ext;
+	extern cs::namespace_t persistent_vector_ext;
+	extern cs::namespace_t persistent_map_ext;
 	extern cs::namespace_t pair_ext;
 	extern cs::namespace_t context_ext;
 	extern cs::namespace_t runtime_ext;
@@ -237,14 +321,55 @@ namespace cs_impl {
 	extern cs::namespace_t iostream_ext;
 	extern cs::namespace_t seekdir_ext;
 	extern cs::namespace_t openmode_ext;
+	extern cs::namespace_t buffering_ext;
+	extern cs::namespace_t endian_ext;
 	extern cs::namespace_t istream_ext;
 	extern cs::namespace_t ostream_ext;
 	extern cs::namespace_t system_ext;
 	extern cs::namespace_t console_ext;
 	extern cs::namespace_t file_ext;
+	extern cs::namespace_t mapped_file_ext;
 	extern cs::namespace_t path_ext;
 	extern cs::namespace_t path_type_ext;
 	extern cs::namespace_t path_info_ext;
+	extern cs::namespace_t path_entry_ext;
+	extern cs::namespace_t process_ext;
+	extern cs::namespace_t event_ext;
+	extern cs::namespace_t event_loop_ext;
+	extern cs::namespace_t connection_ext;
+
+	class file_mapping;
+
+	namespace subprocess {
+		class child_process;
+	}
+
+	namespace process_cs_ext {
+		using process_t = std::shared_ptr<subprocess::child_process>;
+	}
+
+	namespace event_cs_ext {
+		class event_loop;
+
+		class connection;
+
+		using event_loop_t = std::shared_ptr<event_loop>;
+		using connection_t = std::shared_ptr<connection>;
+	}
+
+	namespace file_cs_ext {
+		// Slice of a memory-mapped file, the mapping is shared between all slices of it
+		struct mapped_file final {
+			std::shared_ptr<file_mapping> mapping;
+			const std::uint8_t *data;
+			std::size_t size;
+
+			mapped_file() = delete;
+
+			mapped_file(std::shared_ptr<file_mapping> m, const std::uint8_t *d, std::size_t s) : mapping(std::move(m)),
+				data(d), size(s) {}
+		};
+	}
 
 	namespace path_cs_ext {
 		struct path_info final {
@@ -255,6 +380,14 @@ namespace cs_impl {
 
 			path_info(const char *n, int t) : name(n), type(t) {}
 		};
+
+		struct path_entry final {
+			std::string path;
+			std::string name;
+			int type = 0;
+			std::uint64_t size = 0;
+			double mtime = 0;
+		};
 	}
 
 	template<>
@@ -293,6 +426,66 @@ namespace cs_impl {
 		return hash_map_ext;
 	}
 
+	template<>
+	cs::namespace_t &get_ext<cs::byte_buffer>()
+	{
+		return byte_buffer_ext;
+	}
+
+	template<>
+	cs::namespace_t &get_ext<cs::concurrent_hash_map>()
+	{
+		return concurrent_hash_map_ext;
+	}
+
+	template<>
+	cs::namespace_t &get_ext<cs::priority_queue>()
+	{
+		return priority_queue_ext;
+	}
+
+	template<>
+	cs::namespace_t &get_ext<cs::ordered_map>()
+	{
+		return ordered_map_ext;
+	}
+
+	template<>
+	cs::namespace_t &get_ext<cs::ordered_set>()
+	{
+		return ordered_set_ext;
+	}
+
+	template<>
+	cs::namespace_t &get_ext<cs::bitset>()
+	{
+		return bitset_ext;
+	}
+
+	template<>
+	cs::namespace_t &get_ext<cs::persistent_vector>()
+	{
+		return persistent_vector_ext;
+	}
+
+	template<>
+	cs::namespace_t &get_ext<cs::persistent_map>()
+	{
+		return persistent_map_ext;
+	}
+
+	template<>
+	cs::namespace_t &get_ext<cs::iterator_t>()
+	{
+		return iterator_ext;
+	}
+
+	template<>
+	cs::namespace_t &get_ext<cs::range_type>()
+	{
+		return range_ext;
+	}
+
 	template<>
 	cs::namespace_t &get_ext<cs::list>()
 	{
@@ -363,6 +556,54 @@ namespace cs_impl {
 		return string_ext;
 	}
 
+	template<>
+	cs::namespace_t &get_ext<file_cs_ext::mapped_file>()
+	{
+		return mapped_file_ext;
+	}
+
+	template<>
+	constexpr const char *get_name_of_type<file_cs_ext::mapped_file>()
+	{
+		return "cs::system::mapped_file";
+	}
+
+	template<>
+	cs::namespace_t &get_ext<process_cs_ext::process_t>()
+	{
+		return process_ext;
+	}
+
+	template<>
+	constexpr const char *get_name_of_type<process_cs_ext::process_t>()
+	{
+		return "cs::system::process";
+	}
+
+	template<>
+	cs::namespace_t &get_ext<event_cs_ext::event_loop_t>()
+	{
+		return event_loop_ext;
+	}
+
+	template<>
+	constexpr const char *get_name_of_type<event_cs_ext::event_loop_t>()
+	{
+		return "cs::runtime::event_loop";
+	}
+
+	template<>
+	cs::namespace_t &get_ext<event_cs_ext::connection_t>()
+	{
+		return connection_ext;
+	}
+
+	template<>
+	constexpr const char *get_name_of_type<event_cs_ext::connection_t>()
+	{
+		return "cs::runtime::connection";
+	}
+
 	template<>
 	cs::namespace_t &get_ext<path_cs_ext::path_info>()
 	{
@@ -375,5 +616,17 @@ namespace cs_impl {
 		return "cs::system::path_info";
 	}
 
+	template<>
+	cs::namespace_t &get_ext<path_cs_ext::path_entry>()
+	{
+		return path_entry_ext;
+	}
+
+	template<>
+	constexpr const char *get_name_of_type<path_cs_ext::path_entry>()
+	{
+		return "cs::system::path_entry";
+	}
+
 	void init_extensions();
 }
\ No newline at end of file
@@ -93,6 +93,18 @@ namespace cs {
 			m_data.top().clear();
 		}
 
+		std::size_t domain_depth() const
+		{
+			return m_data.size();
+		}
+
+		// Exchanges the variables of the current domain with the given one
+		void swap_domain(domain_type &domain)
+		{
+			m_data.top().swap(domain);
+			m_cache_refresh = true;
+		}
+
 		bool exist_record(const string &name)
 		{
 			return m_set.top().count(name) > 0;
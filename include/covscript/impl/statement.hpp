@@ -21,6 +21,12 @@
 */
 #include <covscript/impl/impl.hpp>
 
+namespace cs_impl {
+	namespace coroutine {
+		class fiber;
+	}
+}
+
 namespace cs {
 	class statement_expression final : public statement_base {
 		tree_type<token_base *> mTree;
@@ -552,6 +558,11 @@ namespace cs {
 			mIsMemFn = true;
 		}
 
+		void set_generator()
+		{
+			mFunc.set_generator();
+		}
+
 		void run() override;
 
 		void dump(std::ostream &) const override;
@@ -585,6 +596,64 @@ namespace cs {
 		void dump(std::ostream &) const override;
 	};
 
+	class statement_yield final : public statement_base {
+		tree_type<token_base *> mTree;
+	public:
+		statement_yield() = delete;
+
+		statement_yield(tree_type<token_base *> tree, context_t c, token_base *ptr) : statement_base(std::move(c), ptr),
+			mTree(std::move(tree)) {}
+
+		statement_types get_type() const noexcept override
+		{
+			return statement_types::yield_;
+		}
+
+		void run() override;
+
+		void dump(std::ostream &) const override;
+	};
+
+	/*
+	* Iterator returned by the call of a function which contains yield statements.
+	* The body runs on a coroutine stack of its own and is suspended at every yield,
+	* the domains and the call stack entries of the suspended body are moved out of the
+	* runtime until it is resumed, so the caller never sees them.
+	*/
+	class generator final : public iterator_base {
+		// Thrown at the yield statement to unwind a generator which is destroyed before finishing
+		struct generator_exit final {
+		};
+
+		static generator *current;
+
+		context_t m_context;
+		std::deque<statement_base *> m_body;
+		std::unique_ptr<cs_impl::coroutine::fiber> m_fiber;
+		std::deque<domain_type> m_domains;
+		std::deque<var> m_frames;
+		var m_value;
+		bool m_running = false;
+		bool m_finished = false;
+		bool m_cancel = false;
+
+		void run_body();
+
+		void resume();
+
+	public:
+		generator() = delete;
+
+		generator(context_t c, std::deque<statement_base *> body);
+
+		~generator() override;
+
+		bool next(var &) override;
+
+		// Called by the yield statement, returns after the generator is resumed
+		static void yield(const var &);
+	};
+
 	class statement_try final : public statement_base {
 		std::string mName;
 		std::deque<statement_base *> mTryBody;
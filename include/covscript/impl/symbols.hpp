@@ -53,6 +53,7 @@ namespace cs {
 		function_,
 		override_,
 		return_,
+		yield_,
 		try_,
 		catch_,
 		throw_
@@ -532,6 +533,7 @@ namespace cs {
 		struct_,
 		function_,
 		return_,
+		yield_,
 		end_,
 		try_,
 		catch_,
@@ -61,6 +61,11 @@ namespace cs_impl {
 			return size.ws_row - 1;
 		}
 
+		static bool output_is_terminal()
+		{
+			return isatty(STDOUT_FILENO) != 0;
+		}
+
 		static void gotoxy(int x, int y)
 		{
 			printf("\x1B[%d;%df", y + 1, x + 1);
@@ -23,6 +23,8 @@
 #include <cstring>
 #include <conio.h>
 #include <cstdlib>
+#include <cstdio>
+#include <io.h>
 
 namespace cs_impl {
 	namespace conio {
@@ -42,6 +44,11 @@ namespace cs_impl {
 			return csbi.srWindow.Bottom - csbi.srWindow.Top;
 		}
 
+		static bool output_is_terminal()
+		{
+			return _isatty(_fileno(stdout)) != 0;
+		}
+
 		static void gotoxy(SHORT x, SHORT y)
 		{
 			SetConsoleCursorPosition(StdHandle, {x, y});
@@ -0,0 +1,288 @@
+#pragma once
+/*
+* Covariant Script Coroutine
+*
+* Licensed under the Covariant Innovation General Public License,
+* Version 1.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* https://covariant.cn/licenses/LICENSE-1.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* Copyright (C) 2019 Michael Lee(李登淳)
+* Email: mikecovlee@163.com
+* Github: https://github.com/mikecovlee
+*/
+#include <functional>
+#include <exception>
+#include <stdexcept>
+#include <cstdint>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#ifndef MAP_ANONYMOUS
+#define MAP_ANONYMOUS MAP_ANON
+#endif
+
+#ifndef MAP_STACK
+#define MAP_STACK 0
+#endif
+
+// swapcontext saves the signal mask with a system call, so x86-64 switches the registers directly
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__)) && !defined(CS_COROUTINE_UCONTEXT)
+#define CS_COROUTINE_X86_64
+#else
+
+#include <ucontext.h>
+
+#endif
+
+#if defined(__SANITIZE_ADDRESS__)
+#define CS_COROUTINE_ASAN
+#elif defined(__has_feature)
+#if __has_feature(address_sanitizer)
+#define CS_COROUTINE_ASAN
+#endif
+#endif
+
+#ifdef CS_COROUTINE_ASAN
+
+#include <sanitizer/common_interface_defs.h>
+#include <sanitizer/asan_interface.h>
+
+#endif
+
+namespace cs_impl {
+	namespace coroutine {
+		// Pages are only committed when touched, so a large reservation is cheap
+		constexpr std::size_t default_stack_size = 1024 * 1024;
+
+#ifdef CS_COROUTINE_X86_64
+
+		// Pushes the callee-saved registers and the floating point control words, saves the stack pointer into *from,
+		// then pops them from the stack of to and returns to where that stack was switched away
+		__attribute__((naked, noinline)) static void switch_stack(void **from, void *to)
+		{
+			__asm__ volatile(
+			    "pushq %rbp\n\t"
+			    "pushq %rbx\n\t"
+			    "pushq %r12\n\t"
+			    "pushq %r13\n\t"
+			    "pushq %r14\n\t"
+			    "pushq %r15\n\t"
+			    "subq $16, %rsp\n\t"
+			    "stmxcsr 8(%rsp)\n\t"
+			    "fnstcw (%rsp)\n\t"
+			    "movq %rsp, (%rdi)\n\t"
+			    "movq %rsi, %rsp\n\t"
+			    "fldcw (%rsp)\n\t"
+			    "ldmxcsr 8(%rsp)\n\t"
+			    "addq $16, %rsp\n\t"
+			    "popq %r15\n\t"
+			    "popq %r14\n\t"
+			    "popq %r13\n\t"
+			    "popq %r12\n\t"
+			    "popq %rbx\n\t"
+			    "popq %rbp\n\t"
+			    "ret\n\t"
+			);
+		}
+
+		// First return address of a new stack, calls r13 with r12 as the argument
+		__attribute__((naked, noinline)) static void start_stack()
+		{
+			__asm__ volatile(
+			    "movq %r12, %rdi\n\t"
+			    "callq *%r13\n\t"
+			    "ud2\n\t"
+			);
+		}
+
+#endif
+
+		/*
+		* Stackful coroutine running on its own stack in the current thread.
+		* resume() switches into the coroutine until it calls suspend() or returns,
+		* exceptions escaping the entry function are rethrown by resume().
+		*/
+		class fiber final {
+			std::function<void()> m_entry;
+			std::exception_ptr m_error;
+#ifdef CS_COROUTINE_X86_64
+			void *m_callee = nullptr, *m_caller = nullptr;
+#else
+			ucontext_t m_callee, m_caller;
+#endif
+			char *m_stack = nullptr;
+			std::size_t m_stack_size = 0;
+			std::size_t m_guard_size = 0;
+			bool m_finished = false;
+			// Stack of the resumer, reported to the address sanitizer
+			void *m_fake_stack = nullptr;
+			const void *m_caller_stack = nullptr;
+			std::size_t m_caller_stack_size = 0;
+
+			// The address sanitizer must be told about every switch of stacks
+			static void start_switch(void **fake_stack, const void *bottom, std::size_t size)
+			{
+#ifdef CS_COROUTINE_ASAN
+				__sanitizer_start_switch_fiber(fake_stack, bottom, size);
+#endif
+			}
+
+			static void finish_switch(void *fake_stack, const void **bottom, std::size_t *size)
+			{
+#ifdef CS_COROUTINE_ASAN
+				__sanitizer_finish_switch_fiber(fake_stack, bottom, size);
+#endif
+			}
+
+			void switch_in()
+			{
+#ifdef CS_COROUTINE_X86_64
+				switch_stack(&m_caller, m_callee);
+#else
+				::swapcontext(&m_caller, &m_callee);
+#endif
+			}
+
+			void switch_out()
+			{
+#ifdef CS_COROUTINE_X86_64
+				switch_stack(&m_callee, m_caller);
+#else
+				::swapcontext(&m_callee, &m_caller);
+#endif
+			}
+
+			static void run(fiber *self)
+			{
+				finish_switch(nullptr, &self->m_caller_stack, &self->m_caller_stack_size);
+				try {
+					self->m_entry();
+				}
+				catch (...) {
+					self->m_error = std::current_exception();
+				}
+				self->m_finished = true;
+				start_switch(nullptr, self->m_caller_stack, self->m_caller_stack_size);
+				self->switch_out();
+			}
+
+#ifndef CS_COROUTINE_X86_64
+
+			// makecontext only passes int arguments, so the pointer is split into two halves
+			static void entry(unsigned int high, unsigned int low)
+			{
+				run(reinterpret_cast<fiber *>((static_cast<std::uintptr_t>(high) << 16 << 16) |
+				                              static_cast<std::uintptr_t>(low)));
+			}
+
+#endif
+
+			void prepare(char *bottom, std::size_t size)
+			{
+#ifdef CS_COROUTINE_ASAN
+				// The pages may be mapped at the place of a previous stack, which is still poisoned
+				__asan_unpoison_memory_region(bottom, size);
+#endif
+#ifdef CS_COROUTINE_X86_64
+				// The layout popped by switch_stack, the new stack starts at start_stack which calls run(this)
+				std::uintptr_t top = (reinterpret_cast<std::uintptr_t>(bottom) + size) & ~static_cast<std::uintptr_t>(15);
+				void **sp = reinterpret_cast<void **>(top) - 11;
+				// Default x87 control word and MXCSR
+				std::uint32_t fpu_control = 0x037F, sse_control = 0x1F80;
+				sp[0] = nullptr;
+				sp[1] = nullptr;
+				__builtin_memcpy(sp, &fpu_control, sizeof(fpu_control));
+				__builtin_memcpy(sp + 1, &sse_control, sizeof(sse_control));
+				sp[2] = nullptr;
+				sp[3] = nullptr;
+				sp[4] = reinterpret_cast<void *>(&run);
+				sp[5] = this;
+				sp[6] = nullptr;
+				sp[7] = nullptr;
+				sp[8] = reinterpret_cast<void *>(&start_stack);
+				sp[9] = nullptr;
+				sp[10] = nullptr;
+				m_callee = sp;
+#else
+				if (::getcontext(&m_callee) != 0)
+					throw std::runtime_error("Create coroutine failed.");
+				m_callee.uc_stack.ss_sp = bottom;
+				m_callee.uc_stack.ss_size = size;
+				m_callee.uc_link = nullptr;
+				std::uintptr_t self = reinterpret_cast<std::uintptr_t>(this);
+				::makecontext(&m_callee, reinterpret_cast<void (*)()>(&entry), 2,
+				              static_cast<unsigned int>(self >> 16 >> 16), static_cast<unsigned int>(self & 0xffffffff));
+#endif
+			}
+
+		public:
+			fiber() = delete;
+
+			explicit fiber(std::function<void()> func, std::size_t stack_size = default_stack_size) : m_entry(
+				    std::move(func))
+			{
+				std::size_t page_size = ::sysconf(_SC_PAGESIZE);
+				m_guard_size = page_size;
+				m_stack_size = (stack_size + page_size - 1) / page_size * page_size + m_guard_size;
+				void *stack = ::mmap(nullptr, m_stack_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_STACK,
+				                     -1, 0);
+				if (stack == MAP_FAILED)
+					throw std::runtime_error("Allocate coroutine stack failed.");
+				m_stack = static_cast<char *>(stack);
+				// The lowest page is the guard of stack overflow
+				::mprotect(m_stack, m_guard_size, PROT_NONE);
+				try {
+					prepare(m_stack + m_guard_size, m_stack_size - m_guard_size);
+				}
+				catch (...) {
+					::munmap(m_stack, m_stack_size);
+					throw;
+				}
+			}
+
+			fiber(const fiber &) = delete;
+
+			~fiber()
+			{
+				::munmap(m_stack, m_stack_size);
+			}
+
+			bool finished() const
+			{
+				return m_finished;
+			}
+
+			void resume()
+			{
+				if (m_finished)
+					throw std::logic_error("Resume a finished coroutine.");
+				void *fake_stack = nullptr;
+				start_switch(&fake_stack, m_stack + m_guard_size, m_stack_size - m_guard_size);
+				switch_in();
+				finish_switch(fake_stack, nullptr, nullptr);
+				if (m_error) {
+					std::exception_ptr error = m_error;
+					m_error = nullptr;
+					std::rethrow_exception(error);
+				}
+			}
+
+			// Must be called inside of the coroutine
+			void suspend()
+			{
+				start_switch(&m_fake_stack, m_caller_stack, m_caller_stack_size);
+				switch_out();
+				finish_switch(m_fake_stack, &m_caller_stack, &m_caller_stack_size);
+			}
+		};
+	}
+}
@@ -0,0 +1,101 @@
+#pragma once
+/*
+* Covariant Script Coroutine
+*
+* Licensed under the Covariant Innovation General Public License,
+* Version 1.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* https://covariant.cn/licenses/LICENSE-1.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* Copyright (C) 2019 Michael Lee(李登淳)
+* Email: mikecovlee@163.com
+* Github: https://github.com/mikecovlee
+*/
+#include <functional>
+#include <exception>
+#include <stdexcept>
+#include <windows.h>
+
+namespace cs_impl {
+	namespace coroutine {
+		constexpr std::size_t default_stack_size = 1024 * 1024;
+
+		/*
+		* Stackful coroutine running on its own stack in the current thread.
+		* resume() switches into the coroutine until it calls suspend() or returns,
+		* exceptions escaping the entry function are rethrown by resume().
+		*/
+		class fiber final {
+			std::function<void()> m_entry;
+			std::exception_ptr m_error;
+			LPVOID m_callee = nullptr, m_caller = nullptr;
+			bool m_finished = false;
+
+			static VOID CALLBACK entry(LPVOID param)
+			{
+				fiber *self = static_cast<fiber *>(param);
+				try {
+					self->m_entry();
+				}
+				catch (...) {
+					self->m_error = std::current_exception();
+				}
+				self->m_finished = true;
+				::SwitchToFiber(self->m_caller);
+			}
+
+		public:
+			fiber() = delete;
+
+			explicit fiber(std::function<void()> func, std::size_t stack_size = default_stack_size) : m_entry(
+				    std::move(func))
+			{
+				m_callee = ::CreateFiberEx(0, stack_size, FIBER_FLAG_FLOAT_SWITCH, &entry, this);
+				if (m_callee == nullptr)
+					throw std::runtime_error("Create coroutine failed.");
+			}
+
+			fiber(const fiber &) = delete;
+
+			~fiber()
+			{
+				::DeleteFiber(m_callee);
+			}
+
+			bool finished() const
+			{
+				return m_finished;
+			}
+
+			void resume()
+			{
+				if (m_finished)
+					throw std::logic_error("Resume a finished coroutine.");
+				// Only fibers can switch to other fibers, the thread is converted once and keeps being a fiber
+				if (!::IsThreadAFiber() && ::ConvertThreadToFiberEx(nullptr, FIBER_FLAG_FLOAT_SWITCH) == nullptr)
+					throw std::runtime_error("Create coroutine failed.");
+				m_caller = ::GetCurrentFiber();
+				::SwitchToFiber(m_callee);
+				if (m_error) {
+					std::exception_ptr error = m_error;
+					m_error = nullptr;
+					std::rethrow_exception(error);
+				}
+			}
+
+			// Must be called inside of the coroutine
+			void suspend()
+			{
+				::SwitchToFiber(m_caller);
+			}
+		};
+	}
+}
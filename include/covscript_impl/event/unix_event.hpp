@@ -0,0 +1,320 @@
+#pragma once
+/*
+* Covariant Script Event
+*
+* Licensed under the Covariant Innovation General Public License,
+* Version 1.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* https://covariant.cn/licenses/LICENSE-1.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* Copyright (C) 2019 Michael Lee(李登淳)
+* Email: mikecovlee@163.com
+* Github: https://github.com/mikecovlee
+*/
+#include <string>
+#include <vector>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <netdb.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+
+#ifdef __linux__
+
+#include <sys/epoll.h>
+
+#else
+
+#include <poll.h>
+#include <unordered_map>
+
+#endif
+
+namespace cs_impl {
+	namespace event {
+		using socket_t = int;
+
+		constexpr socket_t invalid_socket = -1;
+
+		enum event_types : int {
+			readable = 1, writable = 2
+		};
+
+		struct ready_event final {
+			socket_t handle;
+			int events;
+		};
+
+#ifdef __linux__
+
+		// Readiness notification by epoll, in level triggered mode
+		class poller final {
+			int m_fd;
+
+			static std::uint32_t native_events(int events)
+			{
+				return ((events & readable) ? EPOLLIN : 0) | ((events & writable) ? EPOLLOUT : 0);
+			}
+
+			bool control(int op, socket_t handle, int events)
+			{
+				epoll_event ev;
+				std::memset(&ev, 0, sizeof(ev));
+				ev.events = native_events(events);
+				ev.data.fd = handle;
+				return ::epoll_ctl(m_fd, op, handle, &ev) == 0;
+			}
+
+		public:
+			poller() : m_fd(::epoll_create1(EPOLL_CLOEXEC)) {}
+
+			poller(const poller &) = delete;
+
+			~poller()
+			{
+				if (m_fd >= 0)
+					::close(m_fd);
+			}
+
+			bool add(socket_t handle, int events)
+			{
+				return control(EPOLL_CTL_ADD, handle, events);
+			}
+
+			bool modify(socket_t handle, int events)
+			{
+				return control(EPOLL_CTL_MOD, handle, events);
+			}
+
+			void remove(socket_t handle)
+			{
+				control(EPOLL_CTL_DEL, handle, 0);
+			}
+
+			// Returns false on error, timeout in milliseconds and -1 means infinite
+			bool wait(int timeout, std::vector<ready_event> &ready)
+			{
+				epoll_event events[256];
+				int count = ::epoll_wait(m_fd, events, 256, timeout);
+				if (count < 0)
+					return errno == EINTR;
+				for (int i = 0; i < count; ++i) {
+					int flags = 0;
+					// Errors and hangups are reported as readable, so the next read sees them
+					if (events[i].events & (EPOLLIN | EPOLLERR | EPOLLHUP))
+						flags |= readable;
+					if (events[i].events & (EPOLLOUT | EPOLLERR))
+						flags |= writable;
+					ready.push_back({events[i].data.fd, flags});
+				}
+				return true;
+			}
+		};
+
+#else
+
+		// Readiness notification by poll, for the platforms without epoll
+		class poller final {
+			std::unordered_map<socket_t, int> m_handles;
+			std::vector<pollfd> m_fds;
+		public:
+			poller() = default;
+
+			poller(const poller &) = delete;
+
+			bool add(socket_t handle, int events)
+			{
+				return m_handles.emplace(handle, events).second;
+			}
+
+			bool modify(socket_t handle, int events)
+			{
+				auto it = m_handles.find(handle);
+				if (it == m_handles.end())
+					return false;
+				it->second = events;
+				return true;
+			}
+
+			void remove(socket_t handle)
+			{
+				m_handles.erase(handle);
+			}
+
+			bool wait(int timeout, std::vector<ready_event> &ready)
+			{
+				m_fds.clear();
+				for (auto &it:m_handles)
+					m_fds.push_back({it.first, static_cast<short>(((it.second & readable) ? POLLIN : 0) |
+					                 ((it.second & writable) ? POLLOUT : 0)), 0});
+				int count = ::poll(m_fds.data(), m_fds.size(), timeout);
+				if (count < 0)
+					return errno == EINTR;
+				for (auto &it:m_fds) {
+					int flags = 0;
+					if (it.revents & (POLLIN | POLLERR | POLLHUP))
+						flags |= readable;
+					if (it.revents & (POLLOUT | POLLERR))
+						flags |= writable;
+					if (flags != 0)
+						ready.push_back({it.fd, flags});
+				}
+				return true;
+			}
+		};
+
+#endif
+
+		static bool set_nonblocking(socket_t handle)
+		{
+			int flags = ::fcntl(handle, F_GETFL, 0);
+			return flags >= 0 && ::fcntl(handle, F_SETFL, flags | O_NONBLOCK) == 0 &&
+			       ::fcntl(handle, F_SETFD, FD_CLOEXEC) == 0;
+		}
+
+		static void close_socket(socket_t handle)
+		{
+			::close(handle);
+		}
+
+		static std::string last_error()
+		{
+			return std::strerror(errno);
+		}
+
+		static bool would_block()
+		{
+			return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+		}
+
+		// Returns the count of bytes, 0 at the end of stream and -1 on error or nothing to read
+		static long read_some(socket_t handle, char *buff, std::size_t size)
+		{
+			return ::read(handle, buff, size);
+		}
+
+		static long write_some(socket_t handle, const char *data, std::size_t size)
+		{
+#ifdef MSG_NOSIGNAL
+			long count = ::send(handle, data, size, MSG_NOSIGNAL);
+			// Not a socket, such as the pipes
+			if (count < 0 && errno == ENOTSOCK)
+				count = ::write(handle, data, size);
+			return count;
+#else
+			return ::write(handle, data, size);
+#endif
+		}
+
+		static bool resolve(const std::string &host, unsigned short port, bool passive, addrinfo *&result,
+		                    std::string &error)
+		{
+			addrinfo hints;
+			std::memset(&hints, 0, sizeof(hints));
+			hints.ai_family = AF_UNSPEC;
+			hints.ai_socktype = SOCK_STREAM;
+			hints.ai_flags = passive ? AI_PASSIVE : 0;
+			int code = ::getaddrinfo(host.empty() ? nullptr : host.c_str(), std::to_string(port).c_str(), &hints,
+			                         &result);
+			if (code != 0) {
+				error = ::gai_strerror(code);
+				return false;
+			}
+			return true;
+		}
+
+		static socket_t tcp_listen(const std::string &host, unsigned short port, std::string &error)
+		{
+			addrinfo *info = nullptr;
+			if (!resolve(host, port, true, info, error))
+				return invalid_socket;
+			socket_t handle = invalid_socket;
+			for (addrinfo *it = info; it != nullptr; it = it->ai_next) {
+				handle = ::socket(it->ai_family, it->ai_socktype, it->ai_protocol);
+				if (handle == invalid_socket)
+					continue;
+				int yes = 1;
+				::setsockopt(handle, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+				if (set_nonblocking(handle) && ::bind(handle, it->ai_addr, it->ai_addrlen) == 0 &&
+				        ::listen(handle, SOMAXCONN) == 0)
+					break;
+				error = last_error();
+				close_socket(handle);
+				handle = invalid_socket;
+			}
+			::freeaddrinfo(info);
+			return handle;
+		}
+
+		static socket_t tcp_accept(socket_t listener)
+		{
+			socket_t handle = ::accept(listener, nullptr, nullptr);
+			if (handle != invalid_socket) {
+				int yes = 1;
+				::setsockopt(handle, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+				set_nonblocking(handle);
+			}
+			return handle;
+		}
+
+		// Starts connecting without blocking, the result is known when the socket becomes writable
+		static socket_t tcp_connect(const std::string &host, unsigned short port, std::string &error)
+		{
+			addrinfo *info = nullptr;
+			if (!resolve(host, port, false, info, error))
+				return invalid_socket;
+			socket_t handle = invalid_socket;
+			for (addrinfo *it = info; it != nullptr; it = it->ai_next) {
+				handle = ::socket(it->ai_family, it->ai_socktype, it->ai_protocol);
+				if (handle == invalid_socket)
+					continue;
+				if (set_nonblocking(handle) &&
+				        (::connect(handle, it->ai_addr, it->ai_addrlen) == 0 || errno == EINPROGRESS)) {
+					int yes = 1;
+					::setsockopt(handle, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+					break;
+				}
+				error = last_error();
+				close_socket(handle);
+				handle = invalid_socket;
+			}
+			::freeaddrinfo(info);
+			return handle;
+		}
+
+		// Returns the error of a finished connecting, or an empty string on success
+		static std::string connect_error(socket_t handle)
+		{
+			int code = 0;
+			socklen_t size = sizeof(code);
+			if (::getsockopt(handle, SOL_SOCKET, SO_ERROR, &code, &size) != 0)
+				return last_error();
+			return code == 0 ? std::string() : std::strerror(code);
+		}
+
+		static int local_port(socket_t handle)
+		{
+			sockaddr_storage addr;
+			socklen_t size = sizeof(addr);
+			if (::getsockname(handle, reinterpret_cast<sockaddr *>(&addr), &size) != 0)
+				return -1;
+			if (addr.ss_family == AF_INET)
+				return ntohs(reinterpret_cast<sockaddr_in *>(&addr)->sin_port);
+			else
+				return ntohs(reinterpret_cast<sockaddr_in6 *>(&addr)->sin6_port);
+		}
+	}
+}
@@ -0,0 +1,241 @@
+#pragma once
+/*
+* Covariant Script Event
+*
+* Licensed under the Covariant Innovation General Public License,
+* Version 1.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* https://covariant.cn/licenses/LICENSE-1.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* Copyright (C) 2019 Michael Lee(李登淳)
+* Email: mikecovlee@163.com
+* Github: https://github.com/mikecovlee
+*/
+#include <unordered_map>
+#include <string>
+#include <vector>
+#include <winsock2.h>
+#include <ws2tcpip.h>
+
+namespace cs_impl {
+	namespace event {
+		using socket_t = SOCKET;
+
+		constexpr socket_t invalid_socket = INVALID_SOCKET;
+
+		enum event_types : int {
+			readable = 1, writable = 2
+		};
+
+		struct ready_event final {
+			socket_t handle;
+			int events;
+		};
+
+		static void startup()
+		{
+			static bool initialized = [] {
+				WSADATA data;
+				return ::WSAStartup(MAKEWORD(2, 2), &data) == 0;
+			}();
+			(void) initialized;
+		}
+
+		// Readiness notification by WSAPoll, only sockets can be watched
+		class poller final {
+			std::unordered_map<socket_t, int> m_handles;
+			std::vector<WSAPOLLFD> m_fds;
+		public:
+			poller()
+			{
+				startup();
+			}
+
+			poller(const poller &) = delete;
+
+			bool add(socket_t handle, int events)
+			{
+				return m_handles.emplace(handle, events).second;
+			}
+
+			bool modify(socket_t handle, int events)
+			{
+				auto it = m_handles.find(handle);
+				if (it == m_handles.end())
+					return false;
+				it->second = events;
+				return true;
+			}
+
+			void remove(socket_t handle)
+			{
+				m_handles.erase(handle);
+			}
+
+			bool wait(int timeout, std::vector<ready_event> &ready)
+			{
+				if (m_handles.empty()) {
+					::Sleep(timeout < 0 ? INFINITE : timeout);
+					return true;
+				}
+				m_fds.clear();
+				for (auto &it:m_handles) {
+					WSAPOLLFD fd;
+					fd.fd = it.first;
+					fd.events = ((it.second & readable) ? POLLRDNORM : 0) | ((it.second & writable) ? POLLWRNORM : 0);
+					fd.revents = 0;
+					m_fds.push_back(fd);
+				}
+				if (::WSAPoll(m_fds.data(), static_cast<ULONG>(m_fds.size()), timeout) == SOCKET_ERROR)
+					return false;
+				for (auto &it:m_fds) {
+					int flags = 0;
+					if (it.revents & (POLLRDNORM | POLLERR | POLLHUP))
+						flags |= readable;
+					if (it.revents & (POLLWRNORM | POLLERR))
+						flags |= writable;
+					if (flags != 0)
+						ready.push_back({it.fd, flags});
+				}
+				return true;
+			}
+		};
+
+		static bool set_nonblocking(socket_t handle)
+		{
+			u_long mode = 1;
+			return ::ioctlsocket(handle, FIONBIO, &mode) == 0;
+		}
+
+		static void close_socket(socket_t handle)
+		{
+			::closesocket(handle);
+		}
+
+		static std::string last_error()
+		{
+			return "Socket error " + std::to_string(::WSAGetLastError()) + ".";
+		}
+
+		static bool would_block()
+		{
+			return ::WSAGetLastError() == WSAEWOULDBLOCK;
+		}
+
+		// Returns the count of bytes, 0 at the end of stream and -1 on error or nothing to read
+		static long read_some(socket_t handle, char *buff, std::size_t size)
+		{
+			return ::recv(handle, buff, static_cast<int>(size), 0);
+		}
+
+		static long write_some(socket_t handle, const char *data, std::size_t size)
+		{
+			return ::send(handle, data, static_cast<int>(size), 0);
+		}
+
+		static bool resolve(const std::string &host, unsigned short port, bool passive, addrinfo *&result,
+		                    std::string &error)
+		{
+			startup();
+			addrinfo hints;
+			::ZeroMemory(&hints, sizeof(hints));
+			hints.ai_family = AF_UNSPEC;
+			hints.ai_socktype = SOCK_STREAM;
+			hints.ai_flags = passive ? AI_PASSIVE : 0;
+			int code = ::getaddrinfo(host.empty() ? nullptr : host.c_str(), std::to_string(port).c_str(), &hints,
+			                         &result);
+			if (code != 0) {
+				error = "Can not resolve \"" + host + "\".";
+				return false;
+			}
+			return true;
+		}
+
+		static socket_t tcp_listen(const std::string &host, unsigned short port, std::string &error)
+		{
+			addrinfo *info = nullptr;
+			if (!resolve(host, port, true, info, error))
+				return invalid_socket;
+			socket_t handle = invalid_socket;
+			for (addrinfo *it = info; it != nullptr; it = it->ai_next) {
+				handle = ::socket(it->ai_family, it->ai_socktype, it->ai_protocol);
+				if (handle == invalid_socket)
+					continue;
+				if (set_nonblocking(handle) && ::bind(handle, it->ai_addr, static_cast<int>(it->ai_addrlen)) == 0 &&
+				        ::listen(handle, SOMAXCONN) == 0)
+					break;
+				error = last_error();
+				close_socket(handle);
+				handle = invalid_socket;
+			}
+			::freeaddrinfo(info);
+			return handle;
+		}
+
+		static socket_t tcp_accept(socket_t listener)
+		{
+			socket_t handle = ::accept(listener, nullptr, nullptr);
+			if (handle != invalid_socket) {
+				BOOL yes = TRUE;
+				::setsockopt(handle, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char *>(&yes), sizeof(yes));
+				set_nonblocking(handle);
+			}
+			return handle;
+		}
+
+		// Starts connecting without blocking, the result is known when the socket becomes writable
+		static socket_t tcp_connect(const std::string &host, unsigned short port, std::string &error)
+		{
+			addrinfo *info = nullptr;
+			if (!resolve(host, port, false, info, error))
+				return invalid_socket;
+			socket_t handle = invalid_socket;
+			for (addrinfo *it = info; it != nullptr; it = it->ai_next) {
+				handle = ::socket(it->ai_family, it->ai_socktype, it->ai_protocol);
+				if (handle == invalid_socket)
+					continue;
+				if (set_nonblocking(handle) && (::connect(handle, it->ai_addr, static_cast<int>(it->ai_addrlen)) == 0 ||
+				                                ::WSAGetLastError() == WSAEWOULDBLOCK)) {
+					BOOL yes = TRUE;
+					::setsockopt(handle, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char *>(&yes), sizeof(yes));
+					break;
+				}
+				error = last_error();
+				close_socket(handle);
+				handle = invalid_socket;
+			}
+			::freeaddrinfo(info);
+			return handle;
+		}
+
+		// Returns the error of a finished connecting, or an empty string on success
+		static std::string connect_error(socket_t handle)
+		{
+			int code = 0;
+			int size = sizeof(code);
+			if (::getsockopt(handle, SOL_SOCKET, SO_ERROR, reinterpret_cast<char *>(&code), &size) != 0)
+				return last_error();
+			return code == 0 ? std::string() : "Socket error " + std::to_string(code) + ".";
+		}
+
+		static int local_port(socket_t handle)
+		{
+			sockaddr_storage addr;
+			int size = sizeof(addr);
+			if (::getsockname(handle, reinterpret_cast<sockaddr *>(&addr), &size) != 0)
+				return -1;
+			if (addr.ss_family == AF_INET)
+				return ntohs(reinterpret_cast<sockaddr_in *>(&addr)->sin_port);
+			else
+				return ntohs(reinterpret_cast<sockaddr_in6 *>(&addr)->sin6_port);
+		}
+	}
+}
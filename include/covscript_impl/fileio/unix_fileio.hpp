@@ -0,0 +1,204 @@
+#pragma once
+/*
+* Covariant Script File I/O
+*
+* Licensed under the Covariant Innovation General Public License,
+* Version 1.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* https://covariant.cn/licenses/LICENSE-1.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* Copyright (C) 2019 Michael Lee(李登淳)
+* Email: mikecovlee@163.com
+* Github: https://github.com/mikecovlee
+*/
+#include <atomic>
+#include <memory>
+#include <string>
+#include <cerrno>
+#include <cstdint>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#ifdef __linux__
+
+#include <sys/sendfile.h>
+
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 27))
+#define CS_FILEIO_COPY_FILE_RANGE
+#endif
+
+#endif
+
+namespace cs_impl {
+	namespace fileio {
+		constexpr std::size_t buffer_size = 1024 * 1024;
+
+		struct file_stat final {
+			std::uint64_t size = 0;
+			// Seconds since epoch
+			double mtime = 0;
+			bool directory = false;
+			bool symlink = false;
+		};
+
+		class file_descriptor final {
+			int m_fd;
+		public:
+			explicit file_descriptor(int fd) : m_fd(fd) {}
+
+			file_descriptor(const file_descriptor &) = delete;
+
+			~file_descriptor()
+			{
+				if (m_fd >= 0)
+					::close(m_fd);
+			}
+
+			int get() const
+			{
+				return m_fd;
+			}
+
+			bool close()
+			{
+				int fd = m_fd;
+				m_fd = -1;
+				return ::close(fd) == 0;
+			}
+		};
+
+		static bool write_fully(int fd, const char *data, std::size_t size)
+		{
+			while (size > 0) {
+				ssize_t count = ::write(fd, data, size);
+				if (count < 0) {
+					if (errno == EINTR)
+						continue;
+					return false;
+				}
+				data += count;
+				size -= count;
+			}
+			return true;
+		}
+
+		// Copies from the current offsets until the end of input
+		static bool copy_buffered(int in, int out)
+		{
+			std::unique_ptr<char[]> buff(new char[buffer_size]);
+			while (true) {
+				ssize_t count = ::read(in, buff.get(), buffer_size);
+				if (count < 0) {
+					if (errno == EINTR)
+						continue;
+					return false;
+				}
+				if (count == 0)
+					return true;
+				if (!write_fully(out, buff.get(), count))
+					return false;
+			}
+		}
+
+		/*
+		* Copies in the kernel when possible: copy_file_range first, which can share the extents
+		* on file systems supporting reflinks, then sendfile, then a large user space buffer.
+		* Every step continues from the offsets left by the former one.
+		*/
+		static bool copy(const std::string &source, const std::string &dest)
+		{
+			file_descriptor in(::open(source.c_str(), O_RDONLY));
+			if (in.get() < 0)
+				return false;
+			struct stat info;
+			if (::fstat(in.get(), &info) != 0 || S_ISDIR(info.st_mode))
+				return false;
+			file_descriptor out(::open(dest.c_str(), O_WRONLY | O_CREAT | O_TRUNC, info.st_mode & 0777));
+			if (out.get() < 0)
+				return false;
+#ifdef __linux__
+			bool kernel_copy = S_ISREG(info.st_mode);
+#ifdef CS_FILEIO_COPY_FILE_RANGE
+			while (kernel_copy) {
+				ssize_t count = ::copy_file_range(in.get(), nullptr, out.get(), nullptr, buffer_size * 64, 0);
+				if (count == 0)
+					return out.close();
+				if (count < 0) {
+					if (errno == EINTR)
+						continue;
+					if (errno != ENOSYS && errno != EXDEV && errno != EINVAL && errno != EOPNOTSUPP)
+						return false;
+					break;
+				}
+			}
+#endif
+			while (kernel_copy) {
+				ssize_t count = ::sendfile(out.get(), in.get(), nullptr, buffer_size * 64);
+				if (count == 0)
+					return out.close();
+				if (count < 0) {
+					if (errno == EINTR)
+						continue;
+					if (errno != ENOSYS && errno != EINVAL)
+						return false;
+					break;
+				}
+			}
+#endif
+			return copy_buffered(in.get(), out.get()) && out.close();
+		}
+
+		static bool stat(const std::string &path, file_stat &result, bool follow_link = true)
+		{
+			struct stat info;
+			if ((follow_link ? ::stat(path.c_str(), &info) : ::lstat(path.c_str(), &info)) != 0)
+				return false;
+			result.size = info.st_size;
+			result.directory = S_ISDIR(info.st_mode);
+			result.symlink = S_ISLNK(info.st_mode);
+#if defined(__APPLE__)
+			result.mtime = info.st_mtimespec.tv_sec + info.st_mtimespec.tv_nsec / 1e9;
+#else
+			result.mtime = info.st_mtim.tv_sec + info.st_mtim.tv_nsec / 1e9;
+#endif
+			return true;
+		}
+
+		static bool exists(const std::string &path)
+		{
+			struct stat info;
+			return ::stat(path.c_str(), &info) == 0;
+		}
+
+		// Writes into a temporary file next to the target, then renames it over the target
+		static bool write_atomic(const std::string &path, const char *data, std::size_t size)
+		{
+			static std::atomic<unsigned long> counter(0);
+			std::string temp = path + ".tmp." + std::to_string(::getpid()) + "." + std::to_string(++counter);
+			mode_t mode = 0666;
+			struct stat info;
+			if (::stat(path.c_str(), &info) == 0)
+				mode = info.st_mode & 0777;
+			file_descriptor out(::open(temp.c_str(), O_WRONLY | O_CREAT | O_EXCL, mode));
+			if (out.get() < 0)
+				return false;
+			if (mode != 0666)
+				::fchmod(out.get(), mode);
+			if (!write_fully(out.get(), data, size) || ::fsync(out.get()) != 0 || !out.close() ||
+			        ::rename(temp.c_str(), path.c_str()) != 0) {
+				::unlink(temp.c_str());
+				return false;
+			}
+			return true;
+		}
+	}
+}
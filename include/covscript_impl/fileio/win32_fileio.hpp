@@ -0,0 +1,88 @@
+#pragma once
+/*
+* Covariant Script File I/O
+*
+* Licensed under the Covariant Innovation General Public License,
+* Version 1.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* https://covariant.cn/licenses/LICENSE-1.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* Copyright (C) 2019 Michael Lee(李登淳)
+* Email: mikecovlee@163.com
+* Github: https://github.com/mikecovlee
+*/
+#include <atomic>
+#include <string>
+#include <cstdint>
+#include <windows.h>
+
+namespace cs_impl {
+	namespace fileio {
+		struct file_stat final {
+			std::uint64_t size = 0;
+			// Seconds since epoch
+			double mtime = 0;
+			bool directory = false;
+			bool symlink = false;
+		};
+
+		static bool copy(const std::string &source, const std::string &dest)
+		{
+			return ::CopyFileA(source.c_str(), dest.c_str(), FALSE) != 0;
+		}
+
+		static bool stat(const std::string &path, file_stat &result, bool follow_link = true)
+		{
+			WIN32_FILE_ATTRIBUTE_DATA info;
+			if (!::GetFileAttributesExA(path.c_str(), GetFileExInfoStandard, &info))
+				return false;
+			result.size = (std::uint64_t(info.nFileSizeHigh) << 32) | info.nFileSizeLow;
+			result.directory = (info.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
+			result.symlink = (info.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT) != 0;
+			// FILETIME counts 100 nanoseconds since 1601-01-01
+			std::uint64_t ticks = (std::uint64_t(info.ftLastWriteTime.dwHighDateTime) << 32) |
+			                      info.ftLastWriteTime.dwLowDateTime;
+			result.mtime = (ticks - 116444736000000000ULL) / 1e7;
+			return true;
+		}
+
+		static bool exists(const std::string &path)
+		{
+			return ::GetFileAttributesA(path.c_str()) != INVALID_FILE_ATTRIBUTES;
+		}
+
+		// Writes into a temporary file next to the target, then renames it over the target
+		static bool write_atomic(const std::string &path, const char *data, std::size_t size)
+		{
+			static std::atomic<unsigned long> counter(0);
+			std::string temp = path + ".tmp." + std::to_string(::GetCurrentProcessId()) + "." +
+			                   std::to_string(++counter);
+			HANDLE file = ::CreateFileA(temp.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_NEW, FILE_ATTRIBUTE_NORMAL,
+			                            nullptr);
+			if (file == INVALID_HANDLE_VALUE)
+				return false;
+			bool success = true;
+			while (success && size > 0) {
+				DWORD chunk = size > 0x40000000 ? 0x40000000 : static_cast<DWORD>(size), count = 0;
+				success = ::WriteFile(file, data, chunk, &count, nullptr) != 0;
+				data += count;
+				size -= count;
+			}
+			success = success && ::FlushFileBuffers(file) != 0;
+			::CloseHandle(file);
+			if (!success || !::MoveFileExA(temp.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING)) {
+				::DeleteFileA(temp.c_str());
+				return false;
+			}
+			return true;
+		}
+	}
+}
@@ -0,0 +1,90 @@
+#pragma once
+/*
+* Covariant Script File Mapping
+*
+* Licensed under the Covariant Innovation General Public License,
+* Version 1.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* https://covariant.cn/licenses/LICENSE-1.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* Copyright (C) 2019 Michael Lee(李登淳)
+* Email: mikecovlee@163.com
+* Github: https://github.com/mikecovlee
+*/
+#include <cstddef>
+#include <string>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace cs_impl {
+	// Read-only view of a whole file, released on destruction
+	class file_mapping final {
+		void *m_data = nullptr;
+		std::size_t m_size = 0;
+	public:
+		file_mapping() = default;
+
+		file_mapping(const file_mapping &) = delete;
+
+		file_mapping &operator=(const file_mapping &) = delete;
+
+		~file_mapping()
+		{
+			close();
+		}
+
+		bool open(const std::string &path)
+		{
+			close();
+			int fd = ::open(path.c_str(), O_RDONLY);
+			if (fd < 0)
+				return false;
+			struct stat info;
+			if (::fstat(fd, &info) != 0 || !S_ISREG(info.st_mode)) {
+				::close(fd);
+				return false;
+			}
+			m_size = info.st_size;
+			// Mapping an empty file is not allowed, which is represented by a null view
+			if (m_size > 0) {
+				void *data = ::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+				if (data == MAP_FAILED) {
+					::close(fd);
+					m_size = 0;
+					return false;
+				}
+				m_data = data;
+			}
+			::close(fd);
+			return true;
+		}
+
+		void close()
+		{
+			if (m_data != nullptr)
+				::munmap(m_data, m_size);
+			m_data = nullptr;
+			m_size = 0;
+		}
+
+		const unsigned char *data() const
+		{
+			return static_cast<const unsigned char *>(m_data);
+		}
+
+		std::size_t size() const
+		{
+			return m_size;
+		}
+	};
+}
@@ -0,0 +1,91 @@
+#pragma once
+/*
+* Covariant Script File Mapping
+*
+* Licensed under the Covariant Innovation General Public License,
+* Version 1.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* https://covariant.cn/licenses/LICENSE-1.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* Copyright (C) 2019 Michael Lee(李登淳)
+* Email: mikecovlee@163.com
+* Github: https://github.com/mikecovlee
+*/
+#include <cstddef>
+#include <string>
+#include <windows.h>
+
+namespace cs_impl {
+	// Read-only view of a whole file, released on destruction
+	class file_mapping final {
+		void *m_data = nullptr;
+		std::size_t m_size = 0;
+	public:
+		file_mapping() = default;
+
+		file_mapping(const file_mapping &) = delete;
+
+		file_mapping &operator=(const file_mapping &) = delete;
+
+		~file_mapping()
+		{
+			close();
+		}
+
+		bool open(const std::string &path)
+		{
+			close();
+			HANDLE file = ::CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+			                            FILE_ATTRIBUTE_NORMAL, nullptr);
+			if (file == INVALID_HANDLE_VALUE)
+				return false;
+			LARGE_INTEGER size;
+			if (!::GetFileSizeEx(file, &size)) {
+				::CloseHandle(file);
+				return false;
+			}
+			m_size = static_cast<std::size_t>(size.QuadPart);
+			// Mapping an empty file is not allowed, which is represented by a null view
+			if (m_size > 0) {
+				HANDLE mapping = ::CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+				if (mapping != nullptr) {
+					m_data = ::MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+					::CloseHandle(mapping);
+				}
+				if (m_data == nullptr) {
+					::CloseHandle(file);
+					m_size = 0;
+					return false;
+				}
+			}
+			::CloseHandle(file);
+			return true;
+		}
+
+		void close()
+		{
+			if (m_data != nullptr)
+				::UnmapViewOfFile(m_data);
+			m_data = nullptr;
+			m_size = 0;
+		}
+
+		const unsigned char *data() const
+		{
+			return static_cast<const unsigned char *>(m_data);
+		}
+
+		std::size_t size() const
+		{
+			return m_size;
+		}
+	};
+}
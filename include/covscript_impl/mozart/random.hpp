@@ -23,12 +23,74 @@
 */
 #include <covscript/import/mozart/base.hpp>
 #include <type_traits>
+#include <cstdint>
 #include <random>
 #include <ctime>
 
 namespace cov {
 	namespace random {
-		static std::random_device random_engine;
+		/*
+		* xoshiro256** generator, std::random_device is only used for the initial seed.
+		* Every thread owns an engine, so that no locking is needed and the seed of one thread does not affect others.
+		*/
+		class engine final {
+			std::uint64_t m_state[4];
+
+			static std::uint64_t rotl(std::uint64_t x, int k)
+			{
+				return (x << k) | (x >> (64 - k));
+			}
+
+		public:
+			using result_type = std::uint64_t;
+
+			static constexpr result_type min()
+			{
+				return 0;
+			}
+
+			static constexpr result_type max()
+			{
+				return UINT64_MAX;
+			}
+
+			engine()
+			{
+				std::random_device device;
+				seed((static_cast<std::uint64_t>(device()) << 32) ^ device());
+			}
+
+			// Expands the seed with splitmix64, so that similar seeds give unrelated sequences
+			void seed(std::uint64_t value)
+			{
+				for (auto &state:m_state) {
+					std::uint64_t z = (value += 0x9e3779b97f4a7c15);
+					z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+					z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+					state = z ^ (z >> 31);
+				}
+			}
+
+			result_type operator()()
+			{
+				const std::uint64_t result = rotl(m_state[1] * 5, 7) * 9;
+				const std::uint64_t t = m_state[1] << 17;
+				m_state[2] ^= m_state[0];
+				m_state[3] ^= m_state[1];
+				m_state[1] ^= m_state[2];
+				m_state[0] ^= m_state[3];
+				m_state[2] ^= t;
+				m_state[3] = rotl(m_state[3], 45);
+				return result;
+			}
+		};
+
+		inline engine &random_engine()
+		{
+			static thread_local engine instance;
+			return instance;
+		}
+
 		template<typename T, bool is_integral>
 		struct random_traits;
 
@@ -36,7 +98,7 @@ namespace cov {
 		struct random_traits<T, true> {
 			static T rand(T begin, T end)
 			{
-				return std::uniform_int_distribution<T>(begin, end)(random_engine);
+				return std::uniform_int_distribution<T>(begin, end)(random_engine());
 			}
 		};
 
@@ -44,7 +106,7 @@ namespace cov {
 		struct random_traits<T, false> {
 			static T rand(T begin, T end)
 			{
-				return std::uniform_real_distribution<T>(begin, end)(random_engine);
+				return std::uniform_real_distribution<T>(begin, end)(random_engine());
 			}
 		};
 	}
@@ -54,4 +116,10 @@ namespace cov {
 	{
 		return random::random_traits<T, std::is_integral<T>::value>::rand(begin, end);
 	}
+
+	// Makes the random numbers of the calling thread reproducible
+	inline void seed_rand(std::uint64_t value)
+	{
+		random::random_engine().seed(value);
+	}
 }
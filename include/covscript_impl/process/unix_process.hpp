@@ -0,0 +1,628 @@
+#pragma once
+/*
+* Covariant Script Process
+*
+* Licensed under the Covariant Innovation General Public License,
+* Version 1.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* https://covariant.cn/licenses/LICENSE-1.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* Copyright (C) 2019 Michael Lee(李登淳)
+* Email: mikecovlee@163.com
+* Github: https://github.com/mikecovlee
+*/
+#include <stdexcept>
+#include <streambuf>
+#include <istream>
+#include <ostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include <mutex>
+#include <chrono>
+#include <condition_variable>
+#include <csignal>
+#include <cstring>
+#include <cerrno>
+#include <ctime>
+#include <thread>
+#include <algorithm>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <spawn.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+extern char **environ;
+
+namespace cs_impl {
+	namespace subprocess {
+		class file_handle final {
+			int m_fd;
+		public:
+			explicit file_handle(int fd) : m_fd(fd) {}
+
+			file_handle(const file_handle &) = delete;
+
+			~file_handle()
+			{
+				close();
+			}
+
+			int get() const
+			{
+				return m_fd;
+			}
+
+			void close()
+			{
+				if (m_fd >= 0)
+					::close(m_fd);
+				m_fd = -1;
+			}
+		};
+
+		using handle_t = std::shared_ptr<file_handle>;
+
+		/*
+		* Blocks SIGPIPE for the calling thread while writing into a pipe,
+		* so that a closed pipe reports EPIPE instead of killing the interpreter,
+		* without changing the disposition of the whole process.
+		* Platforms with F_SETNOSIGPIPE mark the pipe itself instead.
+		*/
+		class sigpipe_guard final {
+#ifndef F_SETNOSIGPIPE
+			sigset_t m_set, m_old;
+			bool m_pending = false;
+
+			static bool is_pending()
+			{
+				sigset_t pending;
+				return ::sigpending(&pending) == 0 && ::sigismember(&pending, SIGPIPE) == 1;
+			}
+
+		public:
+			sigpipe_guard()
+			{
+				::sigemptyset(&m_set);
+				::sigaddset(&m_set, SIGPIPE);
+				::pthread_sigmask(SIG_BLOCK, &m_set, &m_old);
+				m_pending = is_pending();
+			}
+
+			~sigpipe_guard()
+			{
+				int error = errno;
+				// Consumes the signal raised by our own write, a signal pending before is kept
+				if (!m_pending && is_pending()) {
+					timespec zero{0, 0};
+					while (::sigtimedwait(&m_set, nullptr, &zero) < 0 && errno == EINTR);
+				}
+				::pthread_sigmask(SIG_SETMASK, &m_old, nullptr);
+				errno = error;
+			}
+#endif
+		};
+
+		static bool would_block()
+		{
+			return errno == EAGAIN || errno == EWOULDBLOCK;
+		}
+
+		/*
+		* The parent ends of the pipes of a child are non-blocking.
+		* While one pipe is waited, the output pipes of the same child are read ahead into memory,
+		* so reading one pipe to the end never deadlocks with a child blocked on another full pipe.
+		*/
+		class pipe_group final {
+		public:
+			enum pipe_id {
+				input_pipe = 0, output_pipe = 1, error_pipe = 2
+			};
+
+		private:
+			handle_t m_pipes[3];
+			std::string m_ahead[3];
+			bool m_eof[3] = {false, false, false};
+
+			// Returns false if the read ahead pipe has reached the end of file or failed
+			bool read_ahead(pipe_id id)
+			{
+				char buff[4096];
+				ssize_t count = 0;
+				do
+					count = ::read(m_pipes[id]->get(), buff, sizeof(buff));
+				while (count < 0 && errno == EINTR);
+				if (count > 0)
+					m_ahead[id].append(buff, count);
+				else if (count == 0 || !would_block())
+					m_eof[id] = true;
+				return !m_eof[id];
+			}
+
+			void wait(pipe_id id, short events)
+			{
+				pollfd fds[3];
+				pipe_id ids[3];
+				nfds_t size = 0;
+				for (pipe_id it : {output_pipe, error_pipe}) {
+					if (it != id && !m_eof[it] && m_pipes[it]->get() >= 0) {
+						fds[size] = {m_pipes[it]->get(), POLLIN, 0};
+						ids[size++] = it;
+					}
+				}
+				fds[size] = {m_pipes[id]->get(), events, 0};
+				ids[size++] = id;
+				if (::poll(fds, size, -1) <= 0)
+					return;
+				for (nfds_t i = 0; i + 1 < size; ++i) {
+					if (fds[i].revents != 0)
+						read_ahead(ids[i]);
+				}
+			}
+
+		public:
+			pipe_group(handle_t in, handle_t out, handle_t err) : m_pipes{std::move(in), std::move(out), std::move(err)}
+			{
+				for (auto &it:m_pipes)
+					::fcntl(it->get(), F_SETFL, ::fcntl(it->get(), F_GETFL, 0) | O_NONBLOCK);
+#ifdef F_SETNOSIGPIPE
+				::fcntl(m_pipes[input_pipe]->get(), F_SETNOSIGPIPE, 1);
+#endif
+			}
+
+			int handle(pipe_id id) const
+			{
+				return m_pipes[id]->get();
+			}
+
+			void close(pipe_id id)
+			{
+				m_pipes[id]->close();
+			}
+
+			// Returns the count of bytes, 0 at the end of file, or -1 with EAGAIN if nothing is available without blocking
+			ssize_t read(pipe_id id, char *buff, std::size_t size, bool block)
+			{
+				for (;;) {
+					if (!m_ahead[id].empty()) {
+						std::size_t count = std::min(size, m_ahead[id].size());
+						std::memcpy(buff, m_ahead[id].data(), count);
+						m_ahead[id].erase(0, count);
+						return count;
+					}
+					if (m_eof[id])
+						return 0;
+					ssize_t count = ::read(m_pipes[id]->get(), buff, size);
+					if (count >= 0)
+						return count;
+					if (errno == EINTR)
+						continue;
+					if (!would_block() || !block)
+						return -1;
+					wait(id, POLLIN);
+				}
+			}
+
+			bool write(const char *data, std::size_t size)
+			{
+				while (size > 0) {
+					ssize_t count = 0;
+					{
+						sigpipe_guard guard;
+						count = ::write(m_pipes[input_pipe]->get(), data, size);
+					}
+					if (count >= 0) {
+						data += count;
+						size -= count;
+					}
+					else if (would_block())
+						wait(input_pipe, POLLOUT);
+					else if (errno != EINTR)
+						return false;
+				}
+				return true;
+			}
+		};
+
+		using group_t = std::shared_ptr<pipe_group>;
+
+		class pipe_buffer final : public std::streambuf {
+			static constexpr std::size_t buffer_size = 4096;
+			group_t m_group;
+			pipe_group::pipe_id m_id;
+			char m_buff[buffer_size];
+
+			int flush()
+			{
+				if (!m_group->write(pbase(), pptr() - pbase()))
+					return -1;
+				setp(m_buff, m_buff + buffer_size);
+				return 0;
+			}
+
+		protected:
+			int_type underflow() override
+			{
+				if (gptr() < egptr())
+					return traits_type::to_int_type(*gptr());
+				ssize_t count = m_group->read(m_id, m_buff, buffer_size, true);
+				if (count <= 0)
+					return traits_type::eof();
+				setg(m_buff, m_buff, m_buff + count);
+				return traits_type::to_int_type(*gptr());
+			}
+
+			// Reads what is available without blocking, so that readsome() never waits for the child
+			std::streamsize showmanyc() override
+			{
+				ssize_t count = m_group->read(m_id, m_buff, buffer_size, false);
+				if (count > 0)
+					setg(m_buff, m_buff, m_buff + count);
+				return count == 0 ? -1 : std::max<ssize_t>(count, 0);
+			}
+
+			int_type overflow(int_type ch) override
+			{
+				if (flush() != 0)
+					return traits_type::eof();
+				if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+					*pptr() = traits_type::to_char_type(ch);
+					pbump(1);
+				}
+				return traits_type::not_eof(ch);
+			}
+
+			int sync() override
+			{
+				return pptr() == pbase() ? 0 : flush();
+			}
+
+		public:
+			pipe_buffer(group_t group, pipe_group::pipe_id id) : m_group(std::move(group)), m_id(id)
+			{
+				if (id == pipe_group::input_pipe)
+					setp(m_buff, m_buff + buffer_size);
+			}
+
+			~pipe_buffer() override
+			{
+				sync();
+			}
+		};
+
+		class pipe_istream final : public std::istream {
+			pipe_buffer m_buff;
+		public:
+			pipe_istream(group_t group, pipe_group::pipe_id id) : std::istream(nullptr), m_buff(std::move(group), id)
+			{
+				rdbuf(&m_buff);
+			}
+		};
+
+		class pipe_ostream final : public std::ostream {
+			pipe_buffer m_buff;
+		public:
+			explicit pipe_ostream(group_t group) : std::ostream(nullptr), m_buff(std::move(group), pipe_group::input_pipe)
+			{
+				rdbuf(&m_buff);
+			}
+		};
+
+		static bool make_pipe(handle_t &read_end, handle_t &write_end)
+		{
+			int fds[2];
+			// Not inherited by the other children, pipe2 also closes the window before the flags are set
+#if defined(__linux__) || defined(__FreeBSD__) || defined(__NetBSD__) || defined(__OpenBSD__)
+			if (::pipe2(fds, O_CLOEXEC) != 0)
+				return false;
+#else
+			if (::pipe(fds) != 0)
+				return false;
+			::fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+			::fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+#endif
+			read_end = std::make_shared<file_handle>(fds[0]);
+			write_end = std::make_shared<file_handle>(fds[1]);
+			return true;
+		}
+
+		/*
+		* Reaps the children which are still running when their objects are destroyed, so they do not stay as zombies.
+		* One thread is shared by all of the children, it is started with the first child instead of in a destructor.
+		*/
+		class child_reaper final {
+			std::mutex m_lock;
+			std::condition_variable m_cond;
+			std::vector<pid_t> m_pids;
+
+			child_reaper()
+			{
+				std::thread(&child_reaper::work, this).detach();
+			}
+
+			void work()
+			{
+				std::unique_lock<std::mutex> lock(m_lock);
+				while (true) {
+					// Children can not be waited together without taking the others, so the running ones are polled
+					if (m_pids.empty())
+						m_cond.wait(lock);
+					else
+						m_cond.wait_for(lock, std::chrono::milliseconds(100));
+					m_pids.erase(std::remove_if(m_pids.begin(), m_pids.end(), [](pid_t pid) {
+						int status = 0;
+						pid_t result = 0;
+						do
+							result = ::waitpid(pid, &status, WNOHANG);
+						while (result < 0 && errno == EINTR);
+						// Reaped, or not a child of us any more
+						return result != 0;
+					}), m_pids.end());
+				}
+			}
+
+		public:
+			child_reaper(const child_reaper &) = delete;
+
+			// Never destroyed, because the thread is still waiting at exit
+			static child_reaper &instance()
+			{
+				static child_reaper *reaper = new child_reaper;
+				return *reaper;
+			}
+
+			void reap(pid_t pid) noexcept
+			{
+				try {
+					std::lock_guard<std::mutex> guard(m_lock);
+					m_pids.push_back(pid);
+					m_cond.notify_one();
+				}
+				catch (...) {
+					// Out of memory, the child is left as a zombie
+				}
+			}
+		};
+
+		class child_process final {
+			pid_t m_pid = -1;
+			int m_exit_code = 0;
+			bool m_exited = false;
+			group_t m_pipes;
+			std::shared_ptr<std::ostream> m_in_stream;
+			std::shared_ptr<std::istream> m_out_stream, m_err_stream;
+
+			void finish(int status)
+			{
+				m_exited = true;
+				// Killed by signal is reported as the negative signal number
+				m_exit_code = WIFEXITED(status) ? WEXITSTATUS(status) : -WTERMSIG(status);
+			}
+
+		public:
+			child_process() = default;
+
+			child_process(const child_process &) = delete;
+
+			~child_process()
+			{
+				// A running child is reaped in the background, so that it does not stay as a zombie
+				if (m_pid > 0 && !poll())
+					child_reaper::instance().reap(m_pid);
+			}
+
+			// Throws std::runtime_error with the reason when the program can not be started
+			void spawn(const std::vector<std::string> &args)
+			{
+				if (args.empty())
+					throw std::runtime_error("Empty command.");
+				// Started before the child, so the destructor never has to
+				child_reaper::instance();
+				handle_t child_in, child_out, child_err, in, out, err;
+				if (!make_pipe(child_in, in) || !make_pipe(out, child_out) || !make_pipe(err, child_err))
+					throw std::runtime_error(std::strerror(errno));
+				m_pipes = std::make_shared<pipe_group>(std::move(in), std::move(out), std::move(err));
+				std::vector<char *> argv;
+				for (auto &it:args)
+					argv.push_back(const_cast<char *>(it.c_str()));
+				argv.push_back(nullptr);
+				posix_spawn_file_actions_t actions;
+				posix_spawn_file_actions_init(&actions);
+				posix_spawn_file_actions_adddup2(&actions, child_in->get(), STDIN_FILENO);
+				posix_spawn_file_actions_adddup2(&actions, child_out->get(), STDOUT_FILENO);
+				posix_spawn_file_actions_adddup2(&actions, child_err->get(), STDERR_FILENO);
+				int error = posix_spawnp(&m_pid, argv[0], &actions, nullptr, argv.data(), environ);
+				posix_spawn_file_actions_destroy(&actions);
+				if (error != 0) {
+					m_pid = -1;
+					throw std::runtime_error(std::strerror(error));
+				}
+			}
+
+			long id() const
+			{
+				return m_pid;
+			}
+
+			int input_handle() const
+			{
+				return m_pipes->handle(pipe_group::input_pipe);
+			}
+
+			int output_handle() const
+			{
+				return m_pipes->handle(pipe_group::output_pipe);
+			}
+
+			int error_handle() const
+			{
+				return m_pipes->handle(pipe_group::error_pipe);
+			}
+
+			std::shared_ptr<std::ostream> input()
+			{
+				if (!m_in_stream)
+					m_in_stream = std::make_shared<pipe_ostream>(m_pipes);
+				return m_in_stream;
+			}
+
+			std::shared_ptr<std::istream> output()
+			{
+				if (!m_out_stream)
+					m_out_stream = std::make_shared<pipe_istream>(m_pipes, pipe_group::output_pipe);
+				return m_out_stream;
+			}
+
+			std::shared_ptr<std::istream> error()
+			{
+				if (!m_err_stream)
+					m_err_stream = std::make_shared<pipe_istream>(m_pipes, pipe_group::error_pipe);
+				return m_err_stream;
+			}
+
+			// Sends the end of file to the child
+			void close_input()
+			{
+				if (m_in_stream)
+					m_in_stream->flush();
+				m_pipes->close(pipe_group::input_pipe);
+			}
+
+			// Returns true if the child has exited, without blocking
+			bool poll()
+			{
+				if (m_exited)
+					return true;
+				int status = 0;
+				pid_t pid = 0;
+				do
+					pid = ::waitpid(m_pid, &status, WNOHANG);
+				while (pid < 0 && errno == EINTR);
+				if (pid == m_pid)
+					finish(status);
+				return m_exited;
+			}
+
+			int wait()
+			{
+				if (m_exited)
+					return m_exit_code;
+				int status = 0;
+				pid_t pid = 0;
+				do
+					pid = ::waitpid(m_pid, &status, 0);
+				while (pid < 0 && errno == EINTR);
+				if (pid == m_pid)
+					finish(status);
+				return m_exit_code;
+			}
+
+			bool exited() const
+			{
+				return m_exited;
+			}
+
+			int exit_code() const
+			{
+				return m_exit_code;
+			}
+
+			void terminate()
+			{
+				if (!m_exited)
+					::kill(m_pid, SIGTERM);
+			}
+
+			void kill()
+			{
+				if (!m_exited)
+					::kill(m_pid, SIGKILL);
+			}
+		};
+
+		struct process_result final {
+			int exit_code = 0;
+			std::string output;
+			std::string error;
+		};
+
+		/*
+		* Runs the commands with at most limit children at the same time.
+		* The outputs of all running children are drained with poll(), so no child blocks on a full pipe.
+		* A command can not be started gets the exit code -1 and the reason as its error output.
+		*/
+		static std::vector<process_result> run_all(const std::vector<std::vector<std::string>> &commands,
+		        std::size_t limit)
+		{
+			struct running_type {
+				std::size_t index;
+				std::unique_ptr<child_process> process;
+				bool output_open, error_open;
+			};
+			std::vector<process_result> results(commands.size());
+			std::vector<running_type> running;
+			std::vector<pollfd> fds;
+			char buff[4096];
+			std::size_t next = 0;
+			while (next < commands.size() || !running.empty()) {
+				while (running.size() < limit && next < commands.size()) {
+					std::unique_ptr<child_process> process(new child_process);
+					try {
+						process->spawn(commands[next]);
+						process->close_input();
+						running.push_back({next, std::move(process), true, true});
+					}
+					catch (const std::runtime_error &e) {
+						results[next].exit_code = -1;
+						results[next].error = e.what();
+					}
+					++next;
+				}
+				fds.clear();
+				for (auto &it:running) {
+					if (it.output_open)
+						fds.push_back({it.process->output_handle(), POLLIN, 0});
+					if (it.error_open)
+						fds.push_back({it.process->error_handle(), POLLIN, 0});
+				}
+				if (!fds.empty() && ::poll(fds.data(), fds.size(), -1) < 0 && errno != EINTR)
+					throw std::runtime_error(std::strerror(errno));
+				std::size_t fd_index = 0;
+				for (auto &it:running) {
+					for (int stream = 0; stream < 2; ++stream) {
+						bool &open = stream == 0 ? it.output_open : it.error_open;
+						if (!open)
+							continue;
+						const pollfd &fd = fds[fd_index++];
+						if (fd.revents == 0)
+							continue;
+						ssize_t count = ::read(fd.fd, buff, sizeof(buff));
+						if (count > 0)
+							(stream == 0 ? results[it.index].output : results[it.index].error).append(buff, count);
+						else if (count == 0 || (errno != EINTR && !would_block()))
+							open = false;
+					}
+				}
+				for (auto it = running.begin(); it != running.end();) {
+					if (!it->output_open && !it->error_open) {
+						results[it->index].exit_code = it->process->wait();
+						it = running.erase(it);
+					}
+					else
+						++it;
+				}
+			}
+			return results;
+		}
+	}
+}
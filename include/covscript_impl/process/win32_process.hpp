@@ -0,0 +1,475 @@
+#pragma once
+/*
+* Covariant Script Process
+*
+* Licensed under the Covariant Innovation General Public License,
+* Version 1.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* https://covariant.cn/licenses/LICENSE-1.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* Copyright (C) 2019 Michael Lee(李登淳)
+* Email: mikecovlee@163.com
+* Github: https://github.com/mikecovlee
+*/
+#include <stdexcept>
+#include <streambuf>
+#include <istream>
+#include <ostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <cstring>
+#include <windows.h>
+
+namespace cs_impl {
+	namespace subprocess {
+		class file_handle final {
+			HANDLE m_handle;
+		public:
+			explicit file_handle(HANDLE handle) : m_handle(handle) {}
+
+			file_handle(const file_handle &) = delete;
+
+			~file_handle()
+			{
+				close();
+			}
+
+			HANDLE get() const
+			{
+				return m_handle;
+			}
+
+			void close()
+			{
+				if (m_handle != INVALID_HANDLE_VALUE)
+					::CloseHandle(m_handle);
+				m_handle = INVALID_HANDLE_VALUE;
+			}
+		};
+
+		using handle_t = std::shared_ptr<file_handle>;
+
+		/*
+		* Anonymous pipes can not be waited together, so a blocking read polls with PeekNamedPipe.
+		* While one pipe is waited, the other output pipe of the same child is read ahead into memory,
+		* so reading one pipe to the end never deadlocks with a child blocked on another full pipe.
+		*/
+		class pipe_group final {
+		public:
+			enum pipe_id {
+				input_pipe = 0, output_pipe = 1, error_pipe = 2
+			};
+
+		private:
+			handle_t m_pipes[3];
+			std::string m_ahead[3];
+			bool m_eof[3] = {false, false, false};
+
+			// Returns false at the end of file
+			bool available(pipe_id id, DWORD &count)
+			{
+				count = 0;
+				return ::PeekNamedPipe(m_pipes[id]->get(), nullptr, 0, nullptr, &count, nullptr) != 0;
+			}
+
+			void read_ahead(pipe_id id)
+			{
+				DWORD count = 0;
+				if (!available(id, count)) {
+					m_eof[id] = true;
+					return;
+				}
+				if (count == 0)
+					return;
+				std::size_t offset = m_ahead[id].size();
+				m_ahead[id].resize(offset + count);
+				if (!::ReadFile(m_pipes[id]->get(), &m_ahead[id][offset], count, &count, nullptr))
+					m_eof[id] = true;
+				m_ahead[id].resize(offset + count);
+			}
+
+		public:
+			pipe_group(handle_t in, handle_t out, handle_t err) : m_pipes{std::move(in), std::move(out), std::move(err)} {}
+
+			HANDLE handle(pipe_id id) const
+			{
+				return m_pipes[id]->get();
+			}
+
+			void close(pipe_id id)
+			{
+				m_pipes[id]->close();
+			}
+
+			// Returns the count of bytes, 0 at the end of file, or -1 if nothing is available without blocking
+			long read(pipe_id id, char *buff, std::size_t size, bool block)
+			{
+				for (;;) {
+					if (!m_ahead[id].empty()) {
+						std::size_t count = (std::min)(size, m_ahead[id].size());
+						std::memcpy(buff, m_ahead[id].data(), count);
+						m_ahead[id].erase(0, count);
+						return static_cast<long>(count);
+					}
+					if (m_eof[id])
+						return 0;
+					DWORD count = 0;
+					if (!available(id, count) || count > 0) {
+						if (!::ReadFile(m_pipes[id]->get(), buff, static_cast<DWORD>(size), &count, nullptr) || count == 0) {
+							m_eof[id] = true;
+							return 0;
+						}
+						return static_cast<long>(count);
+					}
+					if (!block)
+						return -1;
+					pipe_id other = id == output_pipe ? error_pipe : output_pipe;
+					if (!m_eof[other])
+						read_ahead(other);
+					::Sleep(1);
+				}
+			}
+
+			bool write(const char *data, std::size_t size)
+			{
+				while (size > 0) {
+					DWORD count = 0;
+					if (!::WriteFile(m_pipes[input_pipe]->get(), data, static_cast<DWORD>(size), &count, nullptr))
+						return false;
+					data += count;
+					size -= count;
+				}
+				return true;
+			}
+		};
+
+		using group_t = std::shared_ptr<pipe_group>;
+
+		class pipe_buffer final : public std::streambuf {
+			static constexpr std::size_t buffer_size = 4096;
+			group_t m_group;
+			pipe_group::pipe_id m_id;
+			char m_buff[buffer_size];
+
+			int flush()
+			{
+				if (!m_group->write(pbase(), pptr() - pbase()))
+					return -1;
+				setp(m_buff, m_buff + buffer_size);
+				return 0;
+			}
+
+		protected:
+			int_type underflow() override
+			{
+				if (gptr() < egptr())
+					return traits_type::to_int_type(*gptr());
+				long count = m_group->read(m_id, m_buff, buffer_size, true);
+				if (count <= 0)
+					return traits_type::eof();
+				setg(m_buff, m_buff, m_buff + count);
+				return traits_type::to_int_type(*gptr());
+			}
+
+			// Reads what is available without blocking, so that readsome() never waits for the child
+			std::streamsize showmanyc() override
+			{
+				long count = m_group->read(m_id, m_buff, buffer_size, false);
+				if (count > 0)
+					setg(m_buff, m_buff, m_buff + count);
+				return count == 0 ? -1 : (std::max)(count, 0L);
+			}
+
+			int_type overflow(int_type ch) override
+			{
+				if (flush() != 0)
+					return traits_type::eof();
+				if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+					*pptr() = traits_type::to_char_type(ch);
+					pbump(1);
+				}
+				return traits_type::not_eof(ch);
+			}
+
+			int sync() override
+			{
+				return pptr() == pbase() ? 0 : flush();
+			}
+
+		public:
+			pipe_buffer(group_t group, pipe_group::pipe_id id) : m_group(std::move(group)), m_id(id)
+			{
+				if (id == pipe_group::input_pipe)
+					setp(m_buff, m_buff + buffer_size);
+			}
+
+			~pipe_buffer() override
+			{
+				sync();
+			}
+		};
+
+		class pipe_istream final : public std::istream {
+			pipe_buffer m_buff;
+		public:
+			pipe_istream(group_t group, pipe_group::pipe_id id) : std::istream(nullptr), m_buff(std::move(group), id)
+			{
+				rdbuf(&m_buff);
+			}
+		};
+
+		class pipe_ostream final : public std::ostream {
+			pipe_buffer m_buff;
+		public:
+			explicit pipe_ostream(group_t group) : std::ostream(nullptr), m_buff(std::move(group), pipe_group::input_pipe)
+			{
+				rdbuf(&m_buff);
+			}
+		};
+
+		// Only the end belongs to the child is inheritable
+		static bool make_pipe(handle_t &read_end, handle_t &write_end, bool child_reads)
+		{
+			SECURITY_ATTRIBUTES attr = {sizeof(SECURITY_ATTRIBUTES), nullptr, TRUE};
+			HANDLE read_handle, write_handle;
+			if (!::CreatePipe(&read_handle, &write_handle, &attr, 0))
+				return false;
+			::SetHandleInformation(child_reads ? write_handle : read_handle, HANDLE_FLAG_INHERIT, 0);
+			read_end = std::make_shared<file_handle>(read_handle);
+			write_end = std::make_shared<file_handle>(write_handle);
+			return true;
+		}
+
+		// Quotes the arguments by the rules of CommandLineToArgvW
+		static std::string make_command_line(const std::vector<std::string> &args)
+		{
+			std::string cmd;
+			for (auto &arg:args) {
+				if (!cmd.empty())
+					cmd += ' ';
+				if (!arg.empty() && arg.find_first_of(" \t\n\v\"") == std::string::npos) {
+					cmd += arg;
+					continue;
+				}
+				cmd += '"';
+				std::size_t backslashes = 0;
+				for (char ch:arg) {
+					if (ch == '\\')
+						++backslashes;
+					else {
+						cmd.append(ch == '"' ? backslashes * 2 + 1 : backslashes, '\\');
+						backslashes = 0;
+					}
+					if (ch != '\\')
+						cmd += ch;
+				}
+				cmd.append(backslashes * 2, '\\');
+				cmd += '"';
+			}
+			return cmd;
+		}
+
+		class child_process final {
+			HANDLE m_process = INVALID_HANDLE_VALUE;
+			DWORD m_pid = 0;
+			int m_exit_code = 0;
+			bool m_exited = false;
+			group_t m_pipes;
+			std::shared_ptr<std::ostream> m_in_stream;
+			std::shared_ptr<std::istream> m_out_stream, m_err_stream;
+
+			void finish()
+			{
+				DWORD code = 0;
+				::GetExitCodeProcess(m_process, &code);
+				m_exited = true;
+				m_exit_code = static_cast<int>(code);
+			}
+
+		public:
+			child_process() = default;
+
+			child_process(const child_process &) = delete;
+
+			~child_process()
+			{
+				if (m_process != INVALID_HANDLE_VALUE)
+					::CloseHandle(m_process);
+			}
+
+			// Throws std::runtime_error with the reason when the program can not be started
+			void spawn(const std::vector<std::string> &args)
+			{
+				if (args.empty())
+					throw std::runtime_error("Empty command.");
+				handle_t child_in, child_out, child_err, in, out, err;
+				if (!make_pipe(child_in, in, true) || !make_pipe(out, child_out, false) ||
+				        !make_pipe(err, child_err, false))
+					throw std::runtime_error("Can not create pipe.");
+				m_pipes = std::make_shared<pipe_group>(std::move(in), std::move(out), std::move(err));
+				STARTUPINFOA info;
+				::ZeroMemory(&info, sizeof(info));
+				info.cb = sizeof(info);
+				info.dwFlags = STARTF_USESTDHANDLES;
+				info.hStdInput = child_in->get();
+				info.hStdOutput = child_out->get();
+				info.hStdError = child_err->get();
+				PROCESS_INFORMATION proc;
+				std::string cmd = make_command_line(args);
+				if (!::CreateProcessA(nullptr, &cmd[0], nullptr, nullptr, TRUE, 0, nullptr, nullptr, &info, &proc))
+					throw std::runtime_error("Can not create process, error code " + std::to_string(::GetLastError()) + ".");
+				::CloseHandle(proc.hThread);
+				m_process = proc.hProcess;
+				m_pid = proc.dwProcessId;
+			}
+
+			long id() const
+			{
+				return m_pid;
+			}
+
+			HANDLE input_handle() const
+			{
+				return m_pipes->handle(pipe_group::input_pipe);
+			}
+
+			HANDLE output_handle() const
+			{
+				return m_pipes->handle(pipe_group::output_pipe);
+			}
+
+			HANDLE error_handle() const
+			{
+				return m_pipes->handle(pipe_group::error_pipe);
+			}
+
+			std::shared_ptr<std::ostream> input()
+			{
+				if (!m_in_stream)
+					m_in_stream = std::make_shared<pipe_ostream>(m_pipes);
+				return m_in_stream;
+			}
+
+			std::shared_ptr<std::istream> output()
+			{
+				if (!m_out_stream)
+					m_out_stream = std::make_shared<pipe_istream>(m_pipes, pipe_group::output_pipe);
+				return m_out_stream;
+			}
+
+			std::shared_ptr<std::istream> error()
+			{
+				if (!m_err_stream)
+					m_err_stream = std::make_shared<pipe_istream>(m_pipes, pipe_group::error_pipe);
+				return m_err_stream;
+			}
+
+			// Sends the end of file to the child
+			void close_input()
+			{
+				if (m_in_stream)
+					m_in_stream->flush();
+				m_pipes->close(pipe_group::input_pipe);
+			}
+
+			// Returns true if the child has exited, without blocking
+			bool poll()
+			{
+				if (!m_exited && ::WaitForSingleObject(m_process, 0) == WAIT_OBJECT_0)
+					finish();
+				return m_exited;
+			}
+
+			int wait()
+			{
+				if (!m_exited && ::WaitForSingleObject(m_process, INFINITE) == WAIT_OBJECT_0)
+					finish();
+				return m_exit_code;
+			}
+
+			bool exited() const
+			{
+				return m_exited;
+			}
+
+			int exit_code() const
+			{
+				return m_exit_code;
+			}
+
+			void terminate()
+			{
+				if (!m_exited)
+					::TerminateProcess(m_process, 1);
+			}
+
+			void kill()
+			{
+				terminate();
+			}
+		};
+
+		struct process_result final {
+			int exit_code = 0;
+			std::string output;
+			std::string error;
+		};
+
+		static void drain(HANDLE handle, std::string &str)
+		{
+			char buff[4096];
+			DWORD count = 0;
+			while (::ReadFile(handle, buff, sizeof(buff), &count, nullptr) && count > 0)
+				str.append(buff, count);
+		}
+
+		/*
+		* Runs the commands with at most limit children at the same time.
+		* Every running child is served by a worker thread draining its standard error
+		* and a helper draining its standard output, so no child blocks on a full pipe.
+		* A command can not be started gets the exit code -1 and the reason as its error output.
+		*/
+		static std::vector<process_result> run_all(const std::vector<std::vector<std::string>> &commands,
+		        std::size_t limit)
+		{
+			std::vector<process_result> results(commands.size());
+			std::atomic<std::size_t> next(0);
+			auto work = [&]() {
+				for (std::size_t index = next++; index < commands.size(); index = next++) {
+					child_process process;
+					try {
+						process.spawn(commands[index]);
+					}
+					catch (const std::runtime_error &e) {
+						results[index].exit_code = -1;
+						results[index].error = e.what();
+						continue;
+					}
+					process.close_input();
+					std::thread output(drain, process.output_handle(), std::ref(results[index].output));
+					drain(process.error_handle(), results[index].error);
+					output.join();
+					results[index].exit_code = process.wait();
+				}
+			};
+			std::vector<std::thread> workers;
+			for (std::size_t i = 0; i < limit && i < commands.size(); ++i)
+				workers.emplace_back(work);
+			for (auto &it:workers)
+				it.join();
+			return results;
+		}
+	}
+}
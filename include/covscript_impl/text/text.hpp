@@ -0,0 +1,330 @@
+#pragma once
+/*
+* Covariant Script Text Algorithms
+*
+* Licensed under the Covariant Innovation General Public License,
+* Version 1.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* https://covariant.cn/licenses/LICENSE-1.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* Copyright (C) 2019 Michael Lee(李登淳)
+* Email: mikecovlee@163.com
+* Github: https://github.com/mikecovlee
+*/
+#include <cstring>
+#include <cstdint>
+#include <cstddef>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define CS_TEXT_X86_64
+
+#include <immintrin.h>
+
+#ifdef _MSC_VER
+
+#include <intrin.h>
+
+#define CS_TEXT_AVX2
+#else
+#define CS_TEXT_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+/*
+* Byte-wise text scanning and case mapping.
+* SSE2 is always available on x86-64, AVX2 is used when the processor supports it,
+* other architectures use the scalar implementations.
+*/
+namespace cs_impl {
+	namespace text {
+		constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+		// Set of delimiters, the first few are also kept as a list for the vectorized scanning
+		class char_set final {
+		public:
+			static constexpr std::size_t vector_limit = 8;
+		private:
+			bool m_table[256] = {false};
+			unsigned char m_chars[vector_limit] = {0};
+			std::size_t m_count = 0;
+		public:
+			void add(char ch)
+			{
+				unsigned char idx = static_cast<unsigned char>(ch);
+				if (m_table[idx])
+					return;
+				m_table[idx] = true;
+				if (m_count < vector_limit)
+					m_chars[m_count] = idx;
+				++m_count;
+			}
+
+			bool contains(char ch) const
+			{
+				return m_table[static_cast<unsigned char>(ch)];
+			}
+
+			std::size_t count() const
+			{
+				return m_count;
+			}
+
+			bool vectorizable() const
+			{
+				return m_count > 0 && m_count <= vector_limit;
+			}
+
+			char at(std::size_t idx) const
+			{
+				return static_cast<char>(m_chars[idx]);
+			}
+		};
+
+// Scalar implementations
+		template<typename T>
+		static void for_each_of_scalar(const char *data, std::size_t size, const char_set &set, T &&func)
+		{
+			for (std::size_t i = 0; i < size; ++i)
+				if (set.contains(data[i]))
+					func(i);
+		}
+
+		static std::size_t find_scalar(const char *data, std::size_t size, const char *str, std::size_t len)
+		{
+			if (len == 0)
+				return 0;
+			if (len > size)
+				return npos;
+			const char *end = data + size - len + 1;
+			for (const char *it = data; it < end; ++it) {
+				it = static_cast<const char *>(std::memchr(it, str[0], end - it));
+				if (it == nullptr)
+					return npos;
+				if (std::memcmp(it + 1, str + 1, len - 1) == 0)
+					return it - data;
+			}
+			return npos;
+		}
+
+		// Flips the case of the bytes in [first, last]
+		static void flip_case_scalar(char *data, std::size_t size, char first, char last)
+		{
+			for (std::size_t i = 0; i < size; ++i)
+				if (data[i] >= first && data[i] <= last)
+					data[i] ^= 0x20;
+		}
+
+#ifdef CS_TEXT_X86_64
+
+		static unsigned int count_trailing_zeros(std::uint32_t mask)
+		{
+#ifdef _MSC_VER
+			unsigned long idx = 0;
+			_BitScanForward(&idx, mask);
+			return idx;
+#else
+			return __builtin_ctz(mask);
+#endif
+		}
+
+		static bool support_avx2()
+		{
+#ifdef _MSC_VER
+			int info[4];
+			__cpuid(info, 0);
+			if (info[0] < 7)
+				return false;
+			__cpuid(info, 1);
+			// The operating system must save the AVX registers
+			if ((info[2] & (1 << 27)) == 0 || (info[2] & (1 << 28)) == 0 || (_xgetbv(0) & 6) != 6)
+				return false;
+			__cpuidex(info, 7, 0);
+			return (info[1] & (1 << 5)) != 0;
+#else
+			return __builtin_cpu_supports("avx2");
+#endif
+		}
+
+		static bool use_avx2()
+		{
+			static const bool value = support_avx2();
+			return value;
+		}
+
+// SSE2 implementations
+		// Visits every set bit of the block masks, so that short fields cost no extra setup
+		template<typename T>
+		static void for_each_of_sse2(const char *data, std::size_t size, const char_set &set, T &&func)
+		{
+			__m128i chars[char_set::vector_limit];
+			std::size_t count = set.count();
+			for (std::size_t j = 0; j < count; ++j)
+				chars[j] = _mm_set1_epi8(set.at(j));
+			std::size_t i = 0;
+			for (; i + 16 <= size; i += 16) {
+				__m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+				__m128i hit = _mm_cmpeq_epi8(block, chars[0]);
+				for (std::size_t j = 1; j < count; ++j)
+					hit = _mm_or_si128(hit, _mm_cmpeq_epi8(block, chars[j]));
+				for (std::uint32_t mask = _mm_movemask_epi8(hit); mask != 0; mask &= mask - 1)
+					func(i + count_trailing_zeros(mask));
+			}
+			for (; i < size; ++i)
+				if (set.contains(data[i]))
+					func(i);
+		}
+
+		// Compares the first and the last byte of str at 16 positions at once, then verifies the candidates
+		static std::size_t find_sse2(const char *data, std::size_t size, const char *str, std::size_t len)
+		{
+			__m128i first = _mm_set1_epi8(str[0]), last = _mm_set1_epi8(str[len - 1]);
+			std::size_t i = 0;
+			for (; i + len - 1 + 16 <= size; i += 16) {
+				__m128i block_first = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+				__m128i block_last = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i + len - 1));
+				std::uint32_t mask = _mm_movemask_epi8(
+				                         _mm_and_si128(_mm_cmpeq_epi8(block_first, first), _mm_cmpeq_epi8(block_last, last)));
+				for (; mask != 0; mask &= mask - 1) {
+					std::size_t pos = i + count_trailing_zeros(mask);
+					if (std::memcmp(data + pos + 1, str + 1, len - 1) == 0)
+						return pos;
+				}
+			}
+			std::size_t pos = find_scalar(data + i, size - i, str, len);
+			return pos == npos ? npos : i + pos;
+		}
+
+		static void flip_case_sse2(char *data, std::size_t size, char first, char last)
+		{
+			// Shift the range to the bottom of the signed bytes, so that one signed comparison is enough
+			__m128i offset = _mm_set1_epi8(static_cast<char>(-128 - first));
+			__m128i limit = _mm_set1_epi8(static_cast<char>(-128 + (last - first) + 1));
+			__m128i flag = _mm_set1_epi8(0x20);
+			std::size_t i = 0;
+			for (; i + 16 <= size; i += 16) {
+				__m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+				__m128i hit = _mm_cmplt_epi8(_mm_add_epi8(block, offset), limit);
+				_mm_storeu_si128(reinterpret_cast<__m128i *>(data + i), _mm_xor_si128(block, _mm_and_si128(hit, flag)));
+			}
+			flip_case_scalar(data + i, size - i, first, last);
+		}
+
+// AVX2 implementations
+		template<typename T>
+		CS_TEXT_AVX2 static void for_each_of_avx2(const char *data, std::size_t size, const char_set &set, T &&func)
+		{
+			__m256i chars[char_set::vector_limit];
+			std::size_t count = set.count();
+			for (std::size_t j = 0; j < count; ++j)
+				chars[j] = _mm256_set1_epi8(set.at(j));
+			std::size_t i = 0;
+			for (; i + 32 <= size; i += 32) {
+				__m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i));
+				__m256i hit = _mm256_cmpeq_epi8(block, chars[0]);
+				for (std::size_t j = 1; j < count; ++j)
+					hit = _mm256_or_si256(hit, _mm256_cmpeq_epi8(block, chars[j]));
+				for (std::uint32_t mask = _mm256_movemask_epi8(hit); mask != 0; mask &= mask - 1)
+					func(i + count_trailing_zeros(mask));
+			}
+			for (; i < size; ++i)
+				if (set.contains(data[i]))
+					func(i);
+		}
+
+		CS_TEXT_AVX2 static std::size_t find_avx2(const char *data, std::size_t size, const char *str, std::size_t len)
+		{
+			__m256i first = _mm256_set1_epi8(str[0]), last = _mm256_set1_epi8(str[len - 1]);
+			std::size_t i = 0;
+			for (; i + len - 1 + 32 <= size; i += 32) {
+				__m256i block_first = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i));
+				__m256i block_last = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i + len - 1));
+				std::uint32_t mask = _mm256_movemask_epi8(
+				                         _mm256_and_si256(_mm256_cmpeq_epi8(block_first, first),
+				                                 _mm256_cmpeq_epi8(block_last, last)));
+				for (; mask != 0; mask &= mask - 1) {
+					std::size_t pos = i + count_trailing_zeros(mask);
+					if (std::memcmp(data + pos + 1, str + 1, len - 1) == 0)
+						return pos;
+				}
+			}
+			std::size_t pos = find_sse2(data + i, size - i, str, len);
+			return pos == npos ? npos : i + pos;
+		}
+
+		CS_TEXT_AVX2 static void flip_case_avx2(char *data, std::size_t size, char first, char last)
+		{
+			__m256i offset = _mm256_set1_epi8(static_cast<char>(-128 - first));
+			__m256i limit = _mm256_set1_epi8(static_cast<char>(-128 + (last - first) + 1));
+			__m256i flag = _mm256_set1_epi8(0x20);
+			std::size_t i = 0;
+			for (; i + 32 <= size; i += 32) {
+				__m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i));
+				__m256i hit = _mm256_cmpgt_epi8(limit, _mm256_add_epi8(block, offset));
+				_mm256_storeu_si256(reinterpret_cast<__m256i *>(data + i),
+				                    _mm256_xor_si256(block, _mm256_and_si256(hit, flag)));
+			}
+			flip_case_sse2(data + i, size - i, first, last);
+		}
+
+#endif
+
+		// Calls func with the position of every byte in the set, in ascending order
+		template<typename T>
+		static void for_each_of(const char *data, std::size_t size, const char_set &set, T &&func)
+		{
+#ifdef CS_TEXT_X86_64
+			if (set.vectorizable()) {
+				if (use_avx2())
+					for_each_of_avx2(data, size, set, func);
+				else
+					for_each_of_sse2(data, size, set, func);
+				return;
+			}
+#endif
+			for_each_of_scalar(data, size, set, func);
+		}
+
+		// Position of the first occurrence of str, or npos if there is none
+		static std::size_t find(const char *data, std::size_t size, const char *str, std::size_t len)
+		{
+#ifdef CS_TEXT_X86_64
+			if (len > 1 && len <= size)
+				return use_avx2() ? find_avx2(data, size, str, len) : find_sse2(data, size, str, len);
+#endif
+			return find_scalar(data, size, str, len);
+		}
+
+		// ASCII case mapping, other bytes are unchanged
+		static void to_lower(char *data, std::size_t size)
+		{
+#ifdef CS_TEXT_X86_64
+			if (use_avx2())
+				flip_case_avx2(data, size, 'A', 'Z');
+			else
+				flip_case_sse2(data, size, 'A', 'Z');
+#else
+			flip_case_scalar(data, size, 'A', 'Z');
+#endif
+		}
+
+		static void to_upper(char *data, std::size_t size)
+		{
+#ifdef CS_TEXT_X86_64
+			if (use_avx2())
+				flip_case_avx2(data, size, 'a', 'z');
+			else
+				flip_case_sse2(data, size, 'a', 'z');
+#else
+			flip_case_scalar(data, size, 'a', 'z');
+#endif
+		}
+	}
+}
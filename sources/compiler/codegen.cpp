@@ -457,7 +457,13 @@ namespace cs {
 			}
 		}
 		std::deque<statement_base *> body;
+		// Yield statements of the nested functions do not belong to this one
+		bool outer_found_yield = context->compiler->found_yield;
+		context->compiler->found_yield = false;
 		context->compiler->translate({raw.begin() + 1, raw.end()}, body);
+		bool is_generator = context->compiler->found_yield;
+		context->compiler->found_yield = outer_found_yield;
+		statement_function *func = nullptr;
 #ifdef CS_DEBUGGER
 		std::string decl="function "+name+"(";
 		if(args.size()!=0) {
@@ -470,10 +476,13 @@ namespace cs {
 			decl+=")";
 		if(raw.front().size() == 4)
 			decl+=" override";
-		return new statement_function(name, decl, args, body, raw.front().size() == 4, is_vargs, context, raw.front().back());
+		func = new statement_function(name, decl, args, body, raw.front().size() == 4, is_vargs, context, raw.front().back());
 #else
-		return new statement_function(name, args, body, raw.front().size() == 4, is_vargs, context, raw.front().back());
+		func = new statement_function(name, args, body, raw.front().size() == 4, is_vargs, context, raw.front().back());
 #endif
+		if (is_generator)
+			func->set_generator();
+		return func;
 	}
 
 	statement_base *
@@ -491,6 +500,14 @@ namespace cs {
 		return new statement_return(tree, context, raw.front().back());
 	}
 
+	statement_base *
+	method_yield::translate(const context_t &context, const std::deque<std::deque<token_base *>> &raw)
+	{
+		context->compiler->found_yield = true;
+		return new statement_yield(static_cast<token_expr *>(raw.front().at(1))->get_tree(), context,
+		                           raw.front().back());
+	}
+
 	void method_struct::preprocess(const context_t &context, const std::deque<std::deque<token_base *>> &)
 	{
 		context->instance->storage.mark_set_as_struct();
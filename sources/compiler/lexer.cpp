@@ -63,7 +63,7 @@ namespace cs {
 					escape = true;
 				}
 				else if (buff[i] == '\"') {
-					tokens.push_back(new_value(tmp));
+					tokens.push_back(new_string(tmp));
 					tmp.clear();
 					inside_str = false;
 				}
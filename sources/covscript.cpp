@@ -76,16 +76,27 @@ std::ostream &operator<<(std::ostream &out, const cs_impl::any &val)
 }
 
 namespace cs_impl {
-	default_allocator<any::proxy> any::allocator;
+	CS_ALLOCATOR_STORAGE default_allocator<any::proxy> any::allocator;
 	cs::namespace_t except_ext = cs::make_shared_namespace<cs::name_space>();
 	cs::namespace_t array_ext = cs::make_shared_namespace<cs::name_space>();
 	cs::namespace_t array_iterator_ext = cs::make_shared_namespace<cs::name_space>();
 	cs::namespace_t char_ext = cs::make_shared_namespace<cs::name_space>();
 	cs::namespace_t math_ext = cs::make_shared_namespace<cs::name_space>();
 	cs::namespace_t math_const_ext = cs::make_shared_namespace<cs::name_space>();
+	cs::namespace_t math_vector_ext = cs::make_shared_namespace<cs::name_space>();
 	cs::namespace_t list_ext = cs::make_shared_namespace<cs::name_space>();
 	cs::namespace_t list_iterator_ext = cs::make_shared_namespace<cs::name_space>();
 	cs::namespace_t hash_map_ext = cs::make_shared_namespace<cs::name_space>();
+	cs::namespace_t byte_buffer_ext = cs::make_shared_namespace<cs::name_space>();
+	cs::namespace_t concurrent_hash_map_ext = cs::make_shared_namespace<cs::name_space>();
+	cs::namespace_t priority_queue_ext = cs::make_shared_namespace<cs::name_space>();
+	cs::namespace_t ordered_map_ext = cs::make_shared_namespace<cs::name_space>();
+	cs::namespace_t ordered_set_ext = cs::make_shared_namespace<cs::name_space>();
+	cs::namespace_t bitset_ext = cs::make_shared_namespace<cs::name_space>();
+	cs::namespace_t persistent_vector_ext = cs::make_shared_namespace<cs::name_space>();
+	cs::namespace_t persistent_map_ext = cs::make_shared_namespace<cs::name_space>();
+	cs::namespace_t iterator_ext = cs::make_shared_namespace<cs::name_space>();
+	cs::namespace_t range_ext = cs::make_shared_namespace<cs::name_space>();
 	cs::namespace_t pair_ext = cs::make_shared_namespace<cs::name_space>();
 	cs::namespace_t context_ext = cs::make_shared_namespace<cs::name_space>();
 	cs::namespace_t runtime_ext = cs::make_shared_namespace<cs::name_space>();
@@ -93,14 +104,22 @@ namespace cs_impl {
 	cs::namespace_t iostream_ext = cs::make_shared_namespace<cs::name_space>();
 	cs::namespace_t seekdir_ext = cs::make_shared_namespace<cs::name_space>();
 	cs::namespace_t openmode_ext = cs::make_shared_namespace<cs::name_space>();
+	cs::namespace_t buffering_ext = cs::make_shared_namespace<cs::name_space>();
+	cs::namespace_t endian_ext = cs::make_shared_namespace<cs::name_space>();
 	cs::namespace_t istream_ext = cs::make_shared_namespace<cs::name_space>();
 	cs::namespace_t ostream_ext = cs::make_shared_namespace<cs::name_space>();
 	cs::namespace_t system_ext = cs::make_shared_namespace<cs::name_space>();
 	cs::namespace_t console_ext = cs::make_shared_namespace<cs::name_space>();
 	cs::namespace_t file_ext = cs::make_shared_namespace<cs::name_space>();
+	cs::namespace_t mapped_file_ext = cs::make_shared_namespace<cs::name_space>();
 	cs::namespace_t path_ext = cs::make_shared_namespace<cs::name_space>();
 	cs::namespace_t path_type_ext = cs::make_shared_namespace<cs::name_space>();
 	cs::namespace_t path_info_ext = cs::make_shared_namespace<cs::name_space>();
+	cs::namespace_t path_entry_ext = cs::make_shared_namespace<cs::name_space>();
+	cs::namespace_t process_ext = cs::make_shared_namespace<cs::name_space>();
+	cs::namespace_t event_ext = cs::make_shared_namespace<cs::name_space>();
+	cs::namespace_t event_loop_ext = cs::make_shared_namespace<cs::name_space>();
+	cs::namespace_t connection_ext = cs::make_shared_namespace<cs::name_space>();
 }
 
 namespace cs {
@@ -166,16 +185,97 @@ namespace cs {
 		return var::make_protect<namespace_t>(ns);
 	}
 
-	number parse_number(const std::string &str)
+	// Powers of ten which can be represented exactly
+	static const number exact_pow10[] = {
+		1e0L, 1e1L, 1e2L, 1e3L, 1e4L, 1e5L, 1e6L, 1e7L, 1e8L, 1e9L, 1e10L, 1e11L, 1e12L, 1e13L,
+		1e14L, 1e15L, 1e16L, 1e17L, 1e18L, 1e19L, 1e20L, 1e21L, 1e22L, 1e23L, 1e24L, 1e25L, 1e26L, 1e27L
+	};
+
+	static int max_exact_pow10()
+	{
+		// 10^k is exact while 5^k fits into the mantissa
+		int max_pow = static_cast<int>(std::numeric_limits<number>::digits * 0.43067655807339306);
+		return (std::min)(max_pow, 27);
+	}
+
+	static bool exact_mantissa(std::uint64_t mantissa)
+	{
+		return std::numeric_limits<number>::digits >= 64 || mantissa >> std::numeric_limits<number>::digits == 0;
+	}
+
+	bool try_parse_number(const std::string &str, number &val) noexcept
 	{
-		int point_count = 0;
+		static const int max_pow = max_exact_pow10();
+		std::uint64_t mantissa = 0;
+		int significant = 0, exponent = 0, point_count = 0;
+		bool has_digit = false;
+		for (auto &ch:str) {
+			if (ch >= '0' && ch <= '9') {
+				has_digit = true;
+				mantissa = mantissa * 10 + (ch - '0');
+				if (mantissa != 0 && ++significant > 19)
+					break;
+				if (point_count > 0)
+					--exponent;
+			}
+			else if (ch != '.' || ++point_count > 1)
+				return false;
+		}
+		if (!has_digit)
+			return false;
+		// Clinger's fast path: both of the mantissa and the power of ten are exact, so one division rounds correctly
+		if (significant <= 19 && exact_mantissa(mantissa) && -exponent <= max_pow) {
+			val = static_cast<number>(mantissa) / exact_pow10[-exponent];
+			return true;
+		}
+		point_count = 0;
 		for (auto &ch:str) {
-			if (!std::isdigit(ch)) {
-				if (ch != '.' || ++point_count > 1)
-					throw runtime_error("Wrong literal format.");
+			if (!std::isdigit(ch) && (ch != '.' || ++point_count > 1))
+				return false;
+		}
+		try {
+			val = std::stold(str);
+			return true;
+		}
+		catch (...) {
+			return false;
+		}
+	}
+
+	number parse_number(const std::string &str)
+	{
+		number val = 0;
+		if (!try_parse_number(str, val))
+			throw runtime_error("Wrong literal format.");
+		return val;
+	}
+
+	std::string format_number(number val, int precision)
+	{
+		// Integers which have no more digits than the precision are printed as is by %g
+		if (precision > 0 && val == std::trunc(val) && !(val == 0 && std::signbit(val)) &&
+		        std::fabs(val) < exact_pow10[(std::min)(precision, 19)]) {
+			char buff[24];
+			char *end = buff + sizeof(buff), *ptr = end;
+			auto integer = static_cast<std::uint64_t>(std::fabs(val));
+			do {
+				*--ptr = static_cast<char>('0' + integer % 10);
+				integer /= 10;
 			}
+			while (integer != 0);
+			if (val < 0)
+				*--ptr = '-';
+			return std::string(ptr, end);
 		}
-		return std::stold(str);
+		char buff[64];
+		int size = std::snprintf(buff, sizeof(buff), "%.*Lg", precision, val);
+		if (size < 0)
+			throw runtime_error("Format number failed.");
+		if (static_cast<std::size_t>(size) < sizeof(buff))
+			return std::string(buff, size);
+		std::string str(size, '\0');
+		std::snprintf(&str[0], size + 1, "%.*Lg", precision, val);
+		return str;
 	}
 
 	garbage_collector<cov::dll> extension::gc;
@@ -379,6 +479,9 @@ namespace cs {
 			            new token_endline(0)}, new method_return)
 		.add_method({new token_action(action_types::return_), new token_endline(0)},
 		new method_return_no_value)
+		// Yield Grammar
+		.add_method({new token_action(action_types::yield_), new token_expr(tree_type<token_base *>()),
+			            new token_endline(0)}, new method_yield)
 		// Struct Grammar
 		.add_method({new token_action(action_types::struct_), new token_expr(tree_type<token_base *>()),
 			            new token_endline(0)}, new method_struct)
@@ -410,6 +513,22 @@ namespace cs {
 		                  cs_impl::pair_ext)
 		.add_buildin_type("hash_map", []() -> var { return var::make<hash_map>(); }, typeid(hash_map),
 		                  cs_impl::hash_map_ext)
+		.add_buildin_type("byte_buffer", []() -> var { return var::make<byte_buffer>(); }, typeid(byte_buffer),
+		                  cs_impl::byte_buffer_ext)
+		.add_buildin_type("concurrent_hash_map", []() -> var { return var::make<concurrent_hash_map>(); },
+		                  typeid(concurrent_hash_map), cs_impl::concurrent_hash_map_ext)
+		.add_buildin_type("priority_queue", []() -> var { return var::make<priority_queue>(); },
+		                  typeid(priority_queue), cs_impl::priority_queue_ext)
+		.add_buildin_type("ordered_map", []() -> var { return var::make<ordered_map>(); }, typeid(ordered_map),
+		                  cs_impl::ordered_map_ext)
+		.add_buildin_type("ordered_set", []() -> var { return var::make<ordered_set>(); }, typeid(ordered_set),
+		                  cs_impl::ordered_set_ext)
+		.add_buildin_type("bitset", []() -> var { return var::make<bitset>(); }, typeid(bitset),
+		                  cs_impl::bitset_ext)
+		.add_buildin_type("persistent_vector", []() -> var { return var::make<persistent_vector>(); },
+		                  typeid(persistent_vector), cs_impl::persistent_vector_ext)
+		.add_buildin_type("persistent_map", []() -> var { return var::make<persistent_map>(); },
+		                  typeid(persistent_map), cs_impl::persistent_map_ext)
 		// Context
 		.add_buildin_var("context", var::make_constant<context_t>(context))
 		// Add Internal Functions to storage
@@ -453,6 +572,22 @@ namespace cs {
 		                  cs_impl::pair_ext)
 		.add_buildin_type("hash_map", []() -> var { return var::make<hash_map>(); }, typeid(hash_map),
 		                  cs_impl::hash_map_ext)
+		.add_buildin_type("byte_buffer", []() -> var { return var::make<byte_buffer>(); }, typeid(byte_buffer),
+		                  cs_impl::byte_buffer_ext)
+		.add_buildin_type("concurrent_hash_map", []() -> var { return var::make<concurrent_hash_map>(); },
+		                  typeid(concurrent_hash_map), cs_impl::concurrent_hash_map_ext)
+		.add_buildin_type("priority_queue", []() -> var { return var::make<priority_queue>(); },
+		                  typeid(priority_queue), cs_impl::priority_queue_ext)
+		.add_buildin_type("ordered_map", []() -> var { return var::make<ordered_map>(); }, typeid(ordered_map),
+		                  cs_impl::ordered_map_ext)
+		.add_buildin_type("ordered_set", []() -> var { return var::make<ordered_set>(); }, typeid(ordered_set),
+		                  cs_impl::ordered_set_ext)
+		.add_buildin_type("bitset", []() -> var { return var::make<bitset>(); }, typeid(bitset),
+		                  cs_impl::bitset_ext)
+		.add_buildin_type("persistent_vector", []() -> var { return var::make<persistent_vector>(); },
+		                  typeid(persistent_vector), cs_impl::persistent_vector_ext)
+		.add_buildin_type("persistent_map", []() -> var { return var::make<persistent_map>(); },
+		                  typeid(persistent_map), cs_impl::persistent_map_ext)
 		// Context
 		.add_buildin_var("context", var::make_constant<context_t>(context))
 		// Add Internal Functions to storage
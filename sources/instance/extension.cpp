@@ -18,17 +18,610 @@
 * Email: mikecovlee@163.com
 * Github: https://github.com/mikecovlee
 */
+// Winsock must be included before windows.h
+#include <covscript_impl/event/event.hpp>
 #include <covscript_impl/console/conio.hpp>
 #include <covscript_impl/dirent/dirent.hpp>
+#include <covscript_impl/fileio/fileio.hpp>
+#include <covscript_impl/mapping/mapping.hpp>
+#include <covscript_impl/process/process.hpp>
+#include <covscript_impl/text/text.hpp>
 #include <covscript_impl/mozart/random.hpp>
 #include <covscript_impl/mozart/timer.hpp>
 #include <covscript/impl/impl.hpp>
+#include <condition_variable>
+#include <unordered_map>
+#include <chrono>
+#include <queue>
+#include <atomic>
 #include <iostream>
+#include <cstring>
+#include <thread>
+#include <system_error>
 
 namespace cs_impl {
+	namespace iterator_cs_ext {
+		using namespace cs;
+
+// Generators
+		class array_generator final : public iterator_base {
+			var m_data;
+			std::size_t m_index = 0, m_end = static_cast<std::size_t>(-1);
+		public:
+			explicit array_generator(var data) : m_data(std::move(data)) {}
+
+			// Elements in [begin, end), the array is not copied
+			array_generator(var data, std::size_t begin, std::size_t end) : m_data(std::move(data)), m_index(begin),
+				m_end(end) {}
+
+			bool next(var &val) override
+			{
+				const array &arr = m_data.const_val<array>();
+				if (m_index >= arr.size() || m_index >= m_end)
+					return false;
+				val = arr[m_index++];
+				return true;
+			}
+		};
+
+		/*
+		* At most count elements of a list from the given position, the list is not copied
+		* The list must not be changed during the iteration, which is detected by the version of the list.
+		*/
+		class list_view_generator final : public iterator_base {
+			var m_data;
+			list::const_iterator m_it;
+			std::size_t m_count, m_version;
+		public:
+			list_view_generator(var data, list::const_iterator it, std::size_t count) : m_data(std::move(data)),
+				m_it(it), m_count(count), m_version(m_data.const_val<list>().version()) {}
+
+			bool next(var &val) override
+			{
+				const list &lst = m_data.const_val<list>();
+				if (lst.version() != m_version)
+					throw lang_error("List is changed during the iteration.");
+				if (m_count == 0 || m_it == lst.end())
+					return false;
+				val = *m_it++;
+				--m_count;
+				return true;
+			}
+		};
+
+		/*
+		* Keys or values of a hash map, without building an array
+		* The map must not be changed during the iteration, which is detected by the version of the map.
+		*/
+		template<bool is_key>
+		class hash_map_generator final : public iterator_base {
+			var m_data;
+			hash_map::const_iterator m_it;
+			std::size_t m_version;
+		public:
+			explicit hash_map_generator(var data) : m_data(std::move(data)), m_it(m_data.const_val<hash_map>().begin()),
+				m_version(m_data.const_val<hash_map>().version()) {}
+
+			bool next(var &val) override
+			{
+				const hash_map &map = m_data.const_val<hash_map>();
+				if (map.version() != m_version)
+					throw lang_error("Hash map is changed during the iteration.");
+				if (m_it == map.end())
+					return false;
+				val = is_key ? m_it->first : m_it->second;
+				++m_it;
+				return true;
+			}
+		};
+
+		// The list must not be changed during the iteration, which is detected by the version of the list
+		class list_generator final : public iterator_base {
+			var m_data;
+			list::const_iterator m_it;
+			std::size_t m_version;
+		public:
+			explicit list_generator(var data) : m_data(std::move(data)), m_it(m_data.const_val<list>().begin()),
+				m_version(m_data.const_val<list>().version()) {}
+
+			bool next(var &val) override
+			{
+				const list &lst = m_data.const_val<list>();
+				if (lst.version() != m_version)
+					throw lang_error("List is changed during the iteration.");
+				if (m_it == lst.end())
+					return false;
+				val = *m_it++;
+				return true;
+			}
+		};
+
+		class string_generator final : public iterator_base {
+			var m_data;
+			std::size_t m_index = 0;
+		public:
+			explicit string_generator(var data) : m_data(std::move(data)) {}
+
+			bool next(var &val) override
+			{
+				const string &str = m_data.const_val<string>();
+				if (m_index >= str.size())
+					return false;
+				store<char>(val, str[m_index++]);
+				return true;
+			}
+		};
+
+		class istream_generator final : public iterator_base {
+			istream m_in;
+			string m_line;
+		public:
+			explicit istream_generator(istream in) : m_in(std::move(in)) {}
+
+			bool next(var &val) override
+			{
+				if (!std::getline(*m_in, m_line))
+					return false;
+				store<string>(val, m_line);
+				return true;
+			}
+		};
+
+		/*
+		* Reads the stream in large chunks and splits the lines with memchr,
+		* the line is assigned into the string yielded last time if it is not referred anymore.
+		* The stream is read ahead, so it should not be read by other means at the same time.
+		*/
+		class line_generator final : public iterator_base {
+			static constexpr std::size_t chunk_size = 64 * 1024;
+			istream m_in;
+			std::unique_ptr<char[]> m_buff;
+			std::size_t m_begin = 0, m_end = 0;
+			string m_carry;
+			bool m_finish = false;
+
+			void yield(var &val, const char *str, std::size_t len)
+			{
+				if (!m_carry.empty()) {
+					m_carry.append(str, len);
+					store<string>(val, m_carry);
+					m_carry.clear();
+				}
+				else if (reusable<string>(val))
+					val.val<string>().assign(str, len);
+				else
+					val = var::make<string>(str, len);
+			}
+
+		public:
+			explicit line_generator(istream in) : m_in(std::move(in)), m_buff(new char[chunk_size]) {}
+
+			bool next(var &val) override
+			{
+				while (!m_finish) {
+					const char *begin = m_buff.get() + m_begin;
+					auto *pos = static_cast<const char *>(std::memchr(begin, '\n', m_end - m_begin));
+					if (pos != nullptr) {
+						yield(val, begin, pos - begin);
+						m_begin += pos - begin + 1;
+						return true;
+					}
+					m_carry.append(begin, m_end - m_begin);
+					m_in->read(m_buff.get(), chunk_size);
+					m_begin = 0;
+					m_end = m_in->gcount();
+					if (m_end == 0) {
+						m_finish = true;
+						// The last line without a line break
+						if (!m_carry.empty()) {
+							yield(val, nullptr, 0);
+							return true;
+						}
+					}
+				}
+				return false;
+			}
+		};
+
+		/*
+		* Yields the elements of ordered_map and ordered_set in ascending order.
+		* Every step searches the key after the last one, so the container can be modified during the iteration.
+		*/
+		template<typename T>
+		class ordered_generator final : public iterator_base {
+			var m_data, m_key;
+			bool m_started = false;
+
+			static const var &key_of(const var &val)
+			{
+				return val;
+			}
+
+			static const var &key_of(const pair &val)
+			{
+				return val.first;
+			}
+
+			// Keys are copied, so that scripts can not break the ordering of the tree through them
+			static var value_of(const var &val)
+			{
+				return copy(val);
+			}
+
+			static var value_of(const pair &val)
+			{
+				return var::make<pair>(copy(val.first), val.second);
+			}
+
+		public:
+			explicit ordered_generator(var data) : m_data(std::move(data)) {}
+
+			bool next(var &val) override
+			{
+				const T &tree = m_data.const_val<T>();
+				auto *it = m_started ? tree.upper_bound(m_key) : tree.front();
+				if (it == nullptr)
+					return false;
+				m_key = key_of(*it);
+				m_started = true;
+				val = value_of(*it);
+				return true;
+			}
+		};
+
+		// Iterates over a snapshot, which stays unchanged even if the variable is assigned during the iteration
+		class persistent_vector_generator final : public iterator_base {
+			persistent_vector m_data;
+			std::size_t m_index = 0;
+		public:
+			explicit persistent_vector_generator(persistent_vector data) : m_data(std::move(data)) {}
+
+			bool next(var &val) override
+			{
+				if (m_index >= m_data.size())
+					return false;
+				val = m_data.at(m_index++);
+				return true;
+			}
+		};
+
+		class persistent_map_generator final : public iterator_base {
+			persistent_map m_data;
+			persistent_map::cursor m_cursor;
+		public:
+			explicit persistent_map_generator(persistent_map data) : m_data(std::move(data)), m_cursor(m_data) {}
+
+			bool next(var &val) override
+			{
+				const pair *it = m_cursor.next();
+				if (it == nullptr)
+					return false;
+				val = var::make<pair>(it->first, it->second);
+				return true;
+			}
+		};
+
+// Adapters
+		class map_adapter final : public iterator_base {
+			iterator_t m_it;
+			var m_func, m_buff;
+		public:
+			map_adapter(iterator_t it, var func) : m_it(std::move(it)), m_func(std::move(func)) {}
+
+			bool next(var &val) override
+			{
+				if (!m_it->next(m_buff))
+					return false;
+				val = invoke(m_func, m_buff);
+				return true;
+			}
+		};
+
+		class filter_adapter final : public iterator_base {
+			iterator_t m_it;
+			var m_func;
+		public:
+			filter_adapter(iterator_t it, var func) : m_it(std::move(it)), m_func(std::move(func)) {}
+
+			bool next(var &val) override
+			{
+				while (m_it->next(val))
+					if (invoke(m_func, val).const_val<boolean>())
+						return true;
+				return false;
+			}
+		};
+
+		class zip_adapter final : public iterator_base {
+			iterator_t m_first, m_second;
+			var m_buff;
+		public:
+			zip_adapter(iterator_t first, iterator_t second) : m_first(std::move(first)), m_second(std::move(second)) {}
+
+			bool next(var &val) override
+			{
+				var first;
+				if (!m_first->next(first) || !m_second->next(m_buff))
+					return false;
+				val = var::make<pair>(first, m_buff);
+				return true;
+			}
+		};
+
+		class enumerate_adapter final : public iterator_base {
+			iterator_t m_it;
+			std::size_t m_index = 0;
+		public:
+			explicit enumerate_adapter(iterator_t it) : m_it(std::move(it)) {}
+
+			bool next(var &val) override
+			{
+				var data;
+				if (!m_it->next(data))
+					return false;
+				val = var::make<pair>(number(m_index++), data);
+				return true;
+			}
+		};
+
+		class take_adapter final : public iterator_base {
+			iterator_t m_it;
+			std::size_t m_count;
+		public:
+			take_adapter(iterator_t it, std::size_t count) : m_it(std::move(it)), m_count(count) {}
+
+			bool next(var &val) override
+			{
+				if (m_count == 0 || !m_it->next(val))
+					return false;
+				--m_count;
+				return true;
+			}
+		};
+
+		class chain_adapter final : public iterator_base {
+			iterator_t m_first, m_second;
+		public:
+			chain_adapter(iterator_t first, iterator_t second) : m_first(std::move(first)), m_second(std::move(second)) {}
+
+			bool next(var &val) override
+			{
+				if (m_first) {
+					if (m_first->next(val))
+						return true;
+					m_first = nullptr;
+				}
+				return m_second->next(val);
+			}
+		};
+
+		iterator_t iterate(const var &obj)
+		{
+			if (obj.type() == typeid(iterator_t))
+				return obj.const_val<iterator_t>();
+			else if (obj.type() == typeid(range_type))
+				return std::make_shared<range_generator>(obj.const_val<range_type>());
+			else if (obj.type() == typeid(array))
+				return std::make_shared<array_generator>(obj);
+			else if (obj.type() == typeid(list))
+				return std::make_shared<list_generator>(obj);
+			else if (obj.type() == typeid(string))
+				return std::make_shared<string_generator>(obj);
+			else if (obj.type() == typeid(istream))
+				return std::make_shared<istream_generator>(obj.const_val<istream>());
+			else if (obj.type() == typeid(ordered_map))
+				return std::make_shared<ordered_generator<ordered_map>>(obj);
+			else if (obj.type() == typeid(ordered_set))
+				return std::make_shared<ordered_generator<ordered_set>>(obj);
+			else if (obj.type() == typeid(persistent_vector))
+				return std::make_shared<persistent_vector_generator>(obj.const_val<persistent_vector>());
+			else if (obj.type() == typeid(persistent_map))
+				return std::make_shared<persistent_map_generator>(obj.const_val<persistent_map>());
+			else
+				throw lang_error("Target type is not iterable.");
+		}
+
+		iterator_t map(const iterator_t &it, const var &func)
+		{
+			return std::make_shared<map_adapter>(it, func);
+		}
+
+		iterator_t filter(const iterator_t &it, const var &func)
+		{
+			return std::make_shared<filter_adapter>(it, func);
+		}
+
+		iterator_t zip(const iterator_t &it, const var &obj)
+		{
+			return std::make_shared<zip_adapter>(it, iterate(obj));
+		}
+
+		iterator_t enumerate(const iterator_t &it)
+		{
+			return std::make_shared<enumerate_adapter>(it);
+		}
+
+		iterator_t take(const iterator_t &it, number count)
+		{
+			return std::make_shared<take_adapter>(it, count > 0 ? static_cast<std::size_t>(count) : 0);
+		}
+
+		iterator_t chain(const iterator_t &it, const var &obj)
+		{
+			return std::make_shared<chain_adapter>(it, iterate(obj));
+		}
+
+		iterator_t lines(const var &obj)
+		{
+			if (obj.type() == typeid(istream))
+				return std::make_shared<line_generator>(obj.const_val<istream>());
+			else if (obj.type() == typeid(string)) {
+				const string &path = obj.const_val<string>();
+				istream in = std::make_shared<std::ifstream>(path, std::ios_base::in | std::ios_base::binary);
+				if (!*in)
+					throw lang_error("Can not open file \"" + path + "\".");
+				return std::make_shared<line_generator>(in);
+			}
+			else
+				throw lang_error("Lines can only be read from a stream or a file path.");
+		}
+
+		array to_array(const iterator_t &it)
+		{
+			array arr;
+			var val;
+			while (it->next(val))
+				arr.push_back(copy(val));
+			return std::move(arr);
+		}
+
+		list to_list(const iterator_t &it)
+		{
+			list lst;
+			var val;
+			while (it->next(val))
+				lst.push_back(copy(val));
+			return std::move(lst);
+		}
+
+		void init()
+		{
+			(*iterator_ext)
+			.add_var("map", make_cni(map))
+			.add_var("filter", make_cni(filter))
+			.add_var("zip", make_cni(zip))
+			.add_var("enumerate", make_cni(enumerate))
+			.add_var("take", make_cni(take))
+			.add_var("chain", make_cni(chain))
+			.add_var("to_array", make_cni(to_array))
+			.add_var("to_list", make_cni(to_list));
+			(*range_ext)
+			.add_var("iterate", make_cni(iterate));
+		}
+	}
 	namespace array_cs_ext {
 		using namespace cs;
 
+// Ordering
+		// The type of elements is checked before sorting, so that the comparison never throws or re-enters the interpreter
+		template<typename T>
+		struct value_less final {
+			bool operator()(const var &a, const var &b) const
+			{
+				return a.const_val<T>() < b.const_val<T>();
+			}
+
+			bool operator()(const std::pair<var, var> &a, const std::pair<var, var> &b) const
+			{
+				return a.first.const_val<T>() < b.first.const_val<T>();
+			}
+		};
+
+		// Only numbers, strings and chars of the same type have a default ordering
+		void check_orderable(const var &val, const std::type_info *&type)
+		{
+			if (type == nullptr) {
+				var_less::check(val);
+				type = &val.type();
+			}
+			else if (val.type() != *type)
+				throw lang_error("Values of different types can not be ordered by default.");
+		}
+
+		template<typename T>
+		void with_value_less(const std::type_info *type, T &&func)
+		{
+			if (type == nullptr)
+				return;
+			if (*type == typeid(number))
+				func(value_less<number>());
+			else if (*type == typeid(string))
+				func(value_less<string>());
+			else
+				func(value_less<char>());
+		}
+
+		template<typename It, typename T>
+		void with_default_less(It begin, It end, T &&func)
+		{
+			const std::type_info *type = nullptr;
+			for (It it = begin; it != end; ++it)
+				check_orderable(*it, type);
+			with_value_less(type, func);
+		}
+
+		/*
+		* Script comparators are not guaranteed to be strict weak orderings,
+		* so they are never handed to std::sort, whose unguarded loops may run past the buffer.
+		* This merge sort checks every bound itself and is stable for any comparator.
+		*/
+		template<typename Compare>
+		void checked_merge_sort(std::vector<var> &items, Compare &&less)
+		{
+			const std::size_t size = items.size(), run = 16;
+			for (std::size_t begin = 0; begin < size; begin += run) {
+				std::size_t end = std::min(begin + run, size);
+				for (std::size_t i = begin + 1; i < end; ++i) {
+					for (std::size_t j = i; j > begin && less(items[j], items[j - 1]); --j)
+						std::swap(items[j], items[j - 1]);
+				}
+			}
+			std::vector<var> buffer(size);
+			for (std::size_t width = run; width < size; width *= 2) {
+				for (std::size_t begin = 0; begin < size; begin += 2 * width) {
+					std::size_t middle = std::min(begin + width, size), end = std::min(begin + 2 * width, size);
+					std::size_t i = begin, j = middle, k = begin;
+					while (i < middle && j < end)
+						buffer[k++] = std::move(less(items[j], items[i]) ? items[j++] : items[i++]);
+					while (i < middle)
+						buffer[k++] = std::move(items[i++]);
+					while (j < end)
+						buffer[k++] = std::move(items[j++]);
+				}
+				items.swap(buffer);
+			}
+		}
+
+		/*
+		* Sorting with script functions works on a copy of the elements,
+		* so that an exception or a modification from the script leaves the container valid.
+		* The result is always stable, so both sort_with and stable_sort_with share this path.
+		*/
+		template<typename T>
+		void sort_elements_with(T &container, const var &func)
+		{
+			std::vector<var> items(container.begin(), container.end());
+			checked_merge_sort(items, [&func](const var &a, const var &b) {
+				return invoke(func, a, b).template const_val<boolean>();
+			});
+			container.clear();
+			for (auto &it:items)
+				container.push_back(std::move(it));
+		}
+
+		template<typename T>
+		void sort_elements_by(T &container, const var &func, bool stable)
+		{
+			std::vector<std::pair<var, var>> items;
+			items.reserve(container.size());
+			for (auto &it:container)
+				items.emplace_back(var(), it);
+			const std::type_info *type = nullptr;
+			for (auto &it:items) {
+				it.first = invoke(func, it.second);
+				check_orderable(it.first, type);
+			}
+			with_value_less(type, [&](auto less) {
+				if (stable)
+					std::stable_sort(items.begin(), items.end(), less);
+				else
+					std::sort(items.begin(), items.end(), less);
+			});
+			container.clear();
+			for (auto &it:items)
+				container.push_back(std::move(it.second));
+		}
+
 // Element access
 		var at(const array &arr, number posit)
 		{
@@ -122,28 +715,158 @@ namespace cs_impl {
 			arr.pop_back();
 		}
 
+		// Arrays are deques, which grow by fixed blocks and never move the elements, so there is nothing to reserve
+		void shrink_to_fit(array &arr)
+		{
+			arr.shrink_to_fit();
+		}
+
 // Operations
-		var to_hash_map(const array &arr)
+		// Nobody else refers to an unprotected rvalue (a temporary or the result of move), so its elements can be taken
+		bool is_movable(const var &val)
+		{
+			return val.is_rvalue() && !val.is_protect();
+		}
+
+		var to_hash_map(const var &val)
 		{
+			const array &arr = val.const_val<array>();
+			// Checked in advance, so that a failed conversion does not leave the array half moved
+			for (auto &it:arr)
+				if (it.type() != typeid(pair))
+					throw lang_error("Wrong syntax for hash map.");
+			bool movable = is_movable(val);
 			hash_map map;
+			map.reserve(arr.size());
 			for (auto &it:arr) {
-				if (it.type() == typeid(pair)) {
-					const auto &p = it.const_val<pair>();
+				if (movable && !it.is_protect()) {
+					pair &p = it.val<pair>();
+					auto result = map.find_or_emplace(rvalue(p.first), [&p] {
+						return std::move(p.second);
+					});
+					if (!result.second)
+						result.first->second = std::move(p.second);
+				}
+				else {
+					const pair &p = it.const_val<pair>();
 					map[p.first] = copy(p.second);
 				}
-				else
-					throw lang_error("Wrong syntax for hash map.");
 			}
+			if (movable)
+				val.val<array>().clear();
 			return var::make<hash_map>(std::move(map));
 		}
 
-		var to_list(const array &arr)
+		var to_list(const var &val)
 		{
+			if (is_movable(val)) {
+				array &arr = val.val<array>();
+				var lst = var::make<list>(std::make_move_iterator(arr.begin()), std::make_move_iterator(arr.end()));
+				arr.clear();
+				return std::move(lst);
+			}
+			const array &arr = val.const_val<array>();
 			var lst = var::make<list>(arr.begin(), arr.end());
 			lst.detach();
 			return std::move(lst);
 		}
 
+		// Returns the position and the count of a view, the count is limited to the rest of the container
+		std::pair<std::size_t, std::size_t> view_range(number posit, number count, std::size_t size)
+		{
+			if (!std::isfinite(posit) || !std::isfinite(count) || posit != std::floor(posit) || count != std::floor(count))
+				throw lang_error("Position and count must be integers.");
+			if (posit < 0 || posit > size || count < 0)
+				throw lang_error("Out of range.");
+			std::size_t begin = static_cast<std::size_t>(posit);
+			return {begin, static_cast<std::size_t>((std::min)(count, static_cast<number>(size - begin)))};
+		}
+
+		// Iterates over count elements from posit without copying them
+		iterator_t view(const var &val, number posit, number count)
+		{
+			auto range = view_range(posit, count, val.const_val<array>().size());
+			return std::make_shared<iterator_cs_ext::array_generator>(val, range.first, range.first + range.second);
+		}
+
+		void sort(array &arr)
+		{
+			with_default_less(arr.begin(), arr.end(), [&arr](auto less) {
+				std::sort(arr.begin(), arr.end(), less);
+			});
+		}
+
+		void stable_sort(array &arr)
+		{
+			with_default_less(arr.begin(), arr.end(), [&arr](auto less) {
+				std::stable_sort(arr.begin(), arr.end(), less);
+			});
+		}
+
+		void sort_with(array &arr, const var &func)
+		{
+			sort_elements_with(arr, func);
+		}
+
+		void stable_sort_with(array &arr, const var &func)
+		{
+			sort_elements_with(arr, func);
+		}
+
+		void sort_by(array &arr, const var &func)
+		{
+			sort_elements_by(arr, func, false);
+		}
+
+		void stable_sort_by(array &arr, const var &func)
+		{
+			sort_elements_by(arr, func, true);
+		}
+
+		array::iterator get_position(array &arr, number posit)
+		{
+			if (posit < 0 || posit > arr.size())
+				throw lang_error("Out of range.");
+			return arr.begin() + static_cast<std::size_t>(posit);
+		}
+
+		void partial_sort(array &arr, number count)
+		{
+			auto middle = get_position(arr, count);
+			with_default_less(arr.begin(), arr.end(), [&arr, &middle](auto less) {
+				std::partial_sort(arr.begin(), middle, arr.end(), less);
+			});
+		}
+
+		void nth_element(array &arr, number posit)
+		{
+			auto nth = get_position(arr, posit);
+			with_default_less(arr.begin(), arr.end(), [&arr, &nth](auto less) {
+				std::nth_element(arr.begin(), nth, arr.end(), less);
+			});
+		}
+
+		void reverse(array &arr)
+		{
+			std::reverse(arr.begin(), arr.end());
+		}
+
+// Binary search, the array must be sorted by the default ordering
+		number lower_bound(const array &arr, const var &val)
+		{
+			return std::lower_bound(arr.begin(), arr.end(), val, var_less()) - arr.begin();
+		}
+
+		number upper_bound(const array &arr, const var &val)
+		{
+			return std::upper_bound(arr.begin(), arr.end(), val, var_less()) - arr.begin();
+		}
+
+		bool binary_search(const array &arr, const var &val)
+		{
+			return std::binary_search(arr.begin(), arr.end(), val, var_less());
+		}
+
 		void init()
 		{
 			(*array_iterator_ext)
@@ -166,8 +889,23 @@ namespace cs_impl {
 			.add_var("pop_front", make_cni(pop_front, true))
 			.add_var("push_back", make_cni(push_back, true))
 			.add_var("pop_back", make_cni(pop_back, true))
+			.add_var("shrink_to_fit", make_cni(shrink_to_fit, true))
 			.add_var("to_hash_map", make_cni(to_hash_map, true))
-			.add_var("to_list", make_cni(to_list, true));
+			.add_var("to_list", make_cni(to_list, true))
+			.add_var("view", make_cni(view))
+			.add_var("sort", make_cni(sort, true))
+			.add_var("stable_sort", make_cni(stable_sort, true))
+			.add_var("sort_with", make_cni(sort_with))
+			.add_var("stable_sort_with", make_cni(stable_sort_with))
+			.add_var("sort_by", make_cni(sort_by))
+			.add_var("stable_sort_by", make_cni(stable_sort_by))
+			.add_var("partial_sort", make_cni(partial_sort, true))
+			.add_var("nth_element", make_cni(nth_element, true))
+			.add_var("reverse", make_cni(reverse, true))
+			.add_var("lower_bound", make_cni(lower_bound, true))
+			.add_var("upper_bound", make_cni(upper_bound, true))
+			.add_var("binary_search", make_cni(binary_search, true))
+			.add_var("iterate", make_cni(iterator_cs_ext::iterate));
 		}
 
 	}
@@ -292,6 +1030,31 @@ namespace cs_impl {
 			return map.size();
 		}
 
+		number capacity(const hash_map &map)
+		{
+			return map.bucket_count();
+		}
+
+		void reserve(hash_map &map, number count)
+		{
+			if (count < 0)
+				throw lang_error("Reserve a negative size.");
+			map.reserve(count);
+		}
+
+		void shrink_to_fit(hash_map &map)
+		{
+			map.shrink_to_fit();
+		}
+
+		var with_capacity(number count)
+		{
+			var map = var::make<hash_map>();
+			reserve(map.val<hash_map>(), count);
+			// A copy would lose the capacity, so the result is an rvalue and the function is never folded as a constant
+			return rvalue(map);
+		}
+
 // Modifiers
 		void clear(hash_map &map)
 		{
@@ -300,10 +1063,22 @@ namespace cs_impl {
 
 		void insert(hash_map &map, const var &key, const var &val)
 		{
-			if (map.count(key) > 0)
-				map.at(key).swap(copy(val), true);
-			else
-				map.emplace(copy(key), copy(val));
+			auto result = map.find_or_emplace(key, [&val] {
+				return copy(val);
+			});
+			if (!result.second)
+				result.first->second.swap(copy(val), true);
+		}
+
+		// Replaces the value with func(value) and returns it, missing keys start from zero like map[key]
+		var update(hash_map &map, const var &key, const var &func)
+		{
+			// The value is held by reference, so the script function can not invalidate it
+			var current = map.find_or_emplace(key, [] {
+				return var::make<number>(0);
+			}).first->second;
+			current.swap(copy(invoke(func, current)), true);
+			return current;
 		}
 
 		void erase(hash_map &map, const var &key)
@@ -322,6 +1097,24 @@ namespace cs_impl {
 			return map.count(key) > 0;
 		}
 
+		// Returns val if the key does not exist, the map is unchanged
+		var get(const hash_map &map, const var &key, const var &val)
+		{
+			auto it = map.find(key);
+			return it != map.end() ? it->second : val;
+		}
+
+// Views
+		iterator_t keys(const var &map)
+		{
+			return std::make_shared<iterator_cs_ext::hash_map_generator<true>>(map);
+		}
+
+		iterator_t values(const var &map)
+		{
+			return std::make_shared<iterator_cs_ext::hash_map_generator<false>>(map);
+		}
+
 		void init()
 		{
 			(*hash_map_ext)
@@ -331,881 +1124,3299 @@ namespace cs_impl {
 			.add_var("insert", make_cni(insert, true))
 			.add_var("erase", make_cni(erase, true))
 			.add_var("at", make_cni(at, true))
-			.add_var("exist", make_cni(exist, true));
+			.add_var("exist", make_cni(exist, true))
+			.add_var("get", make_cni(get, true))
+			.add_var("update", make_cni(update))
+			.add_var("keys", make_cni(keys))
+			.add_var("values", make_cni(values))
+			.add_var("capacity", make_cni(capacity, true))
+			.add_var("reserve", make_cni(reserve, true))
+			.add_var("shrink_to_fit", make_cni(shrink_to_fit, true))
+			.add_var("with_capacity", make_cni(with_capacity));
 		}
 	}
-	namespace iostream_cs_ext {
+	namespace concurrent_hash_map_cs_ext {
 		using namespace cs;
 
-		var fstream(const string &path, std::ios_base::openmode openmode)
+// Capacity
+		bool empty(const concurrent_hash_map &map)
 		{
-			switch (openmode) {
-			case std::ios_base::in:
-				return var::make<istream>(new std::ifstream(path, std::ios_base::in));
-				break;
-			case std::ios_base::out:
-				return var::make<ostream>(new std::ofstream(path, std::ios_base::out));
-				break;
-			case std::ios_base::app:
-				return var::make<ostream>(new std::ofstream(path, std::ios_base::app));
-				break;
-			default:
-				throw lang_error("Unsupported openmode.");
-			}
+			return map.empty();
 		}
 
-		void setprecision(number pre)
+		number size(const concurrent_hash_map &map)
 		{
-			current_process->output_precision = pre;
+			return map.size();
 		}
 
-		void init()
+// Modifiers
+		void clear(concurrent_hash_map &map)
 		{
-			(*iostream_ext)
-			.add_var("istream", make_namespace(istream_ext))
-			.add_var("ostream", make_namespace(ostream_ext))
-			.add_var("seekdir", make_namespace(seekdir_ext))
-			.add_var("openmode", make_namespace(openmode_ext));
-			(*seekdir_ext)
-			.add_var("start", var::make_constant<std::ios_base::seekdir>(std::ios_base::beg))
-			.add_var("finish", var::make_constant<std::ios_base::seekdir>(std::ios_base::end))
-			.add_var("present", var::make_constant<std::ios_base::seekdir>(std::ios_base::cur));
-			(*openmode_ext)
-			.add_var("in", var::make_constant<std::ios_base::openmode>(std::ios_base::in))
-			.add_var("out", var::make_constant<std::ios_base::openmode>(std::ios_base::out))
-			.add_var("app", var::make_constant<std::ios_base::openmode>(std::ios_base::app));
-			(*iostream_ext)
-			.add_var("fstream", make_cni(fstream))
-			.add_var("setprecision", make_cni(setprecision));
+			map.clear();
 		}
-	}
-	namespace istream_cs_ext {
-		using namespace cs;
 
-		var parse_value(const std::string &str)
+		void insert(concurrent_hash_map &map, const var &key, const var &val)
 		{
-			if (str == "true")
-				return true;
-			if (str == "false")
-				return false;
-			try {
-				return parse_number(str);
-			}
-			catch (...) {
-				return str;
-			}
-			return str;
+			map.insert(key, val);
 		}
 
-// Input Stream
-		char get(istream &in)
+		void insert_or_update(concurrent_hash_map &map, const var &key, const var &val, const var &func)
 		{
-			return in->get();
+			map.insert_or_update(key, val, [&func, &val](const var &current) {
+				return invoke(func, current, val);
+			});
 		}
 
-		char peek(istream &in)
+		bool erase(concurrent_hash_map &map, const var &key)
 		{
-			return in->peek();
+			return map.erase(key);
 		}
 
-		void unget(istream &in)
+		bool erase_if(concurrent_hash_map &map, const var &key, const var &pred)
 		{
-			in->unget();
+			return map.erase_if(key, [&pred](const var &current) {
+				return invoke(pred, current).const_val<boolean>();
+			});
 		}
 
-		string getline(istream &in)
+// Lookup
+		var get_or_default(const concurrent_hash_map &map, const var &key, const var &val)
 		{
-			std::string str;
-			std::getline(*in, str);
-			return std::move(str);
+			return map.get_or_default(key, val);
 		}
 
-		number tell(istream &in)
+		bool exist(const concurrent_hash_map &map, const var &key)
 		{
-			return in->tellg();
+			return map.exist(key);
 		}
 
-		void seek(istream &in, number pos)
+		var to_hash_map(const concurrent_hash_map &map)
 		{
-			in->seekg(pos);
+			return var::make<hash_map>(map.snapshot());
 		}
 
-		void seek_from(istream &in, std::ios_base::seekdir dir, number offset)
+		void init()
 		{
-			in->seekg(offset, dir);
+			(*concurrent_hash_map_ext)
+			.add_var("empty", make_cni(empty, true))
+			.add_var("size", make_cni(size, true))
+			.add_var("clear", make_cni(clear, true))
+			.add_var("insert", make_cni(insert, true))
+			.add_var("insert_or_update", make_cni(insert_or_update))
+			.add_var("erase", make_cni(erase, true))
+			.add_var("erase_if", make_cni(erase_if))
+			.add_var("get_or_default", make_cni(get_or_default, true))
+			.add_var("exist", make_cni(exist, true))
+			.add_var("to_hash_map", make_cni(to_hash_map, true));
+		}
+	}
+	namespace priority_queue_cs_ext {
+		using namespace cs;
+
+// Capacity
+		bool empty(const priority_queue &queue)
+		{
+			return queue.empty();
 		}
 
-		bool good(const istream &in)
+		number size(const priority_queue &queue)
 		{
-			return static_cast<bool>(*in);
+			return queue.size();
 		}
 
-		bool eof(const istream &in)
+// Modifiers
+		void clear(priority_queue &queue)
 		{
-			return in->eof();
+			queue.clear();
 		}
 
-		var input(istream &in)
+		void push(priority_queue &queue, const var &val)
 		{
-			std::string str;
-			*in >> str;
-			return parse_value(str);
+			queue.push(val);
 		}
 
-		void ignore(istream &in)
+		void pop(priority_queue &queue)
 		{
-			in->ignore((std::numeric_limits<std::streamsize>::max)(), '\n');
+			queue.pop();
+		}
+
+// Element access
+		var top(const priority_queue &queue)
+		{
+			return queue.top();
+		}
+
+		array to_array(const priority_queue &queue)
+		{
+			std::vector<var> data = queue.sorted();
+			return array(std::make_move_iterator(data.begin()), std::make_move_iterator(data.end()));
 		}
 
 		void init()
 		{
-			(*istream_ext)
-			.add_var("get", make_cni(get))
-			.add_var("peek", make_cni(peek))
-			.add_var("unget", make_cni(unget))
-			.add_var("getline", make_cni(getline))
-			.add_var("tell", make_cni(tell))
-			.add_var("seek", make_cni(seek))
-			.add_var("seek_from", make_cni(seek_from))
-			.add_var("good", make_cni(good))
-			.add_var("eof", make_cni(eof))
-			.add_var("input", make_cni(input))
-			.add_var("ignore", make_cni(ignore));
+			(*priority_queue_ext)
+			.add_var("empty", make_cni(empty, true))
+			.add_var("size", make_cni(size, true))
+			.add_var("clear", make_cni(clear, true))
+			.add_var("push", make_cni(push, true))
+			.add_var("pop", make_cni(pop, true))
+			.add_var("top", make_cni(top, true))
+			.add_var("to_array", make_cni(to_array, true));
 		}
 	}
-	namespace ostream_cs_ext {
+	namespace ordered_map_cs_ext {
 		using namespace cs;
 
-// Output Stream
-		void put(ostream &out, char c)
+		// Keys are copied, so that scripts can not break the ordering of the tree through them
+		var make_pair(const pair *it)
 		{
-			out->put(c);
+			return it == nullptr ? var::make<pointer>(null_pointer) : var::make<pair>(copy(it->first), it->second);
 		}
 
-		number tell(ostream &out)
+// Capacity
+		bool empty(const ordered_map &map)
 		{
-			return out->tellp();
+			return map.empty();
 		}
 
-		void seek(ostream &out, number pos)
+		number size(const ordered_map &map)
 		{
-			out->seekp(pos);
+			return map.size();
 		}
 
-		void seek_from(ostream &out, std::ios_base::seekdir dir, number offset)
+// Modifiers
+		void clear(ordered_map &map)
 		{
-			out->seekp(offset, dir);
+			map.clear();
 		}
 
-		void flush(ostream &out)
+		void insert(ordered_map &map, const var &key, const var &val)
 		{
-			out->flush();
+			pair *it = map.find(key);
+			if (it != nullptr)
+				it->second.swap(copy(val), true);
+			else
+				map.insert(pair(copy(key), copy(val)));
 		}
 
-		bool good(const ostream &out)
+		bool erase(ordered_map &map, const var &key)
 		{
-			return static_cast<bool>(*out);
+			return map.erase(key);
 		}
 
-		void print(ostream &out, const var &val)
+// Lookup
+		bool exist(const ordered_map &map, const var &key)
 		{
-			*out << val << std::flush;
+			return map.find(key) != nullptr;
 		}
 
-		void println(ostream &out, const var &val)
+		var get(const ordered_map &map, const var &key)
 		{
-			*out << val << std::endl;
+			const pair *it = map.find(key);
+			if (it == nullptr)
+				throw lang_error("Key does not exist.");
+			return it->second;
 		}
 
-		void init()
+		var get_or_default(const ordered_map &map, const var &key, const var &val)
 		{
-			(*ostream_ext)
-			.add_var("put", make_cni(put))
-			.add_var("tell", make_cni(tell))
-			.add_var("seek", make_cni(seek))
-			.add_var("seek_from", make_cni(seek_from))
-			.add_var("flush", make_cni(flush))
-			.add_var("good", make_cni(good))
-			.add_var("print", make_cni(print))
-			.add_var("println", make_cni(println));
+			const pair *it = map.find(key);
+			return it != nullptr ? it->second : val;
 		}
-	}
-	namespace list_cs_ext {
-		using namespace cs;
 
-// Element access
-		var front(const list &lst)
+		// Returns null if the map is empty
+		var first(const ordered_map &map)
 		{
-			return lst.front();
+			return make_pair(map.front());
 		}
 
-		var back(const list &lst)
+		var last(const ordered_map &map)
 		{
-			return lst.back();
+			return make_pair(map.back());
 		}
 
-// Iterators
-		list::iterator begin(list &lst)
+		// Returns null if there is no such entry
+		var lower_bound(const ordered_map &map, const var &key)
 		{
-			return lst.begin();
+			return make_pair(map.lower_bound(key));
 		}
 
-		list::iterator end(list &lst)
+		var upper_bound(const ordered_map &map, const var &key)
 		{
-			return lst.end();
+			return make_pair(map.upper_bound(key));
 		}
 
-		list::iterator forward(list::iterator &it)
+		// Entries whose keys are in [low, high)
+		array range(const ordered_map &map, const var &low, const var &high)
 		{
-			return ++it;
+			array arr;
+			map.for_each_range(low, high, [&arr](const pair &it) {
+				arr.push_back(var::make<pair>(copy(it.first), it.second));
+			});
+			return std::move(arr);
 		}
 
-		list::iterator backward(list::iterator &it)
+		var to_hash_map(const ordered_map &map)
 		{
-			return --it;
+			hash_map data;
+			data.reserve(map.size());
+			map.for_each([&data](const pair &it) {
+				data.emplace(copy(it.first), copy(it.second));
+			});
+			return var::make<hash_map>(std::move(data));
 		}
 
-		var data(list::iterator &it)
+		void init()
 		{
-			return *it;
+			(*ordered_map_ext)
+			.add_var("empty", make_cni(empty, true))
+			.add_var("size", make_cni(size, true))
+			.add_var("clear", make_cni(clear, true))
+			.add_var("insert", make_cni(insert, true))
+			.add_var("erase", make_cni(erase, true))
+			.add_var("exist", make_cni(exist, true))
+			.add_var("get", make_cni(get, true))
+			.add_var("get_or_default", make_cni(get_or_default, true))
+			.add_var("first", make_cni(first, true))
+			.add_var("last", make_cni(last, true))
+			.add_var("lower_bound", make_cni(lower_bound, true))
+			.add_var("upper_bound", make_cni(upper_bound, true))
+			.add_var("range", make_cni(range, true))
+			.add_var("to_hash_map", make_cni(to_hash_map, true))
+			.add_var("iterate", make_cni(iterator_cs_ext::iterate));
+		}
+	}
+	namespace ordered_set_cs_ext {
+		using namespace cs;
+
+		// Keys are copied, so that scripts can not break the ordering of the tree through them
+		var make_key(const var *it)
+		{
+			return it == nullptr ? var::make<pointer>(null_pointer) : copy(*it);
 		}
 
 // Capacity
-		bool empty(const list &lst)
+		bool empty(const ordered_set &set)
 		{
-			return lst.empty();
+			return set.empty();
 		}
 
-		number size(const list &lst)
+		number size(const ordered_set &set)
 		{
-			return lst.size();
+			return set.size();
 		}
 
 // Modifiers
-		void clear(list &lst)
+		void clear(ordered_set &set)
 		{
-			lst.clear();
+			set.clear();
 		}
 
-		list::iterator insert(list &lst, list::iterator &pos, const var &val)
+		bool insert(ordered_set &set, const var &key)
 		{
-			return lst.insert(pos, copy(val));
+			return set.insert(copy(key));
 		}
 
-		list::iterator erase(list &lst, list::iterator &pos)
+		bool erase(ordered_set &set, const var &key)
 		{
-			return lst.erase(pos);
+			return set.erase(key);
 		}
 
-		void push_front(list &lst, const var &val)
+// Lookup
+		bool exist(const ordered_set &set, const var &key)
 		{
-			lst.push_front(copy(val));
+			return set.find(key) != nullptr;
 		}
 
-		void pop_front(list &lst)
+		// Returns null if the set is empty
+		var first(const ordered_set &set)
 		{
-			lst.pop_front();
+			return make_key(set.front());
 		}
 
-		void push_back(list &lst, const var &val)
+		var last(const ordered_set &set)
 		{
-			lst.push_back(copy(val));
+			return make_key(set.back());
 		}
 
-		void pop_back(list &lst)
+		// Returns null if there is no such key
+		var lower_bound(const ordered_set &set, const var &key)
 		{
-			lst.pop_back();
+			return make_key(set.lower_bound(key));
 		}
 
-// Operations
-		void remove(list &lst, const var &val)
+		var upper_bound(const ordered_set &set, const var &key)
 		{
-			lst.remove(val);
+			return make_key(set.upper_bound(key));
 		}
 
-		void reverse(list &lst)
+		// Keys in [low, high)
+		array range(const ordered_set &set, const var &low, const var &high)
 		{
-			lst.reverse();
+			array arr;
+			set.for_each_range(low, high, [&arr](const var &it) {
+				arr.push_back(copy(it));
+			});
+			return std::move(arr);
 		}
 
-		void unique(list &lst)
+		array to_array(const ordered_set &set)
 		{
-			lst.unique();
+			array arr;
+			set.for_each([&arr](const var &it) {
+				arr.push_back(copy(it));
+			});
+			return std::move(arr);
 		}
 
 		void init()
 		{
-			(*list_iterator_ext)
-			.add_var("forward", make_cni(forward, true))
-			.add_var("backward", make_cni(backward, true))
-			.add_var("data", make_cni(data, true));
-			(*list_ext)
-			.add_var("iterator", make_namespace(list_iterator_ext))
-			.add_var("front", make_cni(front, true))
-			.add_var("back", make_cni(back, true))
-			.add_var("begin", make_cni(begin, true))
-			.add_var("end", make_cni(end, true))
+			(*ordered_set_ext)
 			.add_var("empty", make_cni(empty, true))
 			.add_var("size", make_cni(size, true))
 			.add_var("clear", make_cni(clear, true))
 			.add_var("insert", make_cni(insert, true))
 			.add_var("erase", make_cni(erase, true))
-			.add_var("push_front", make_cni(push_front, true))
-			.add_var("pop_front", make_cni(pop_front, true))
-			.add_var("push_back", make_cni(push_back, true))
-			.add_var("pop_back", make_cni(pop_back, true))
-			.add_var("remove", make_cni(remove, true))
-			.add_var("reverse", make_cni(reverse, true))
-			.add_var("unique", make_cni(unique, true));
+			.add_var("exist", make_cni(exist, true))
+			.add_var("first", make_cni(first, true))
+			.add_var("last", make_cni(last, true))
+			.add_var("lower_bound", make_cni(lower_bound, true))
+			.add_var("upper_bound", make_cni(upper_bound, true))
+			.add_var("range", make_cni(range, true))
+			.add_var("to_array", make_cni(to_array, true))
+			.add_var("iterate", make_cni(iterator_cs_ext::iterate));
 		}
 	}
-	namespace math_cs_ext {
+	namespace persistent_vector_cs_ext {
 		using namespace cs;
 
-		number abs(number n)
+		// Stored values are constants, so that a version can not be changed through another one
+		var freeze(const var &val)
 		{
-			return std::abs(n);
+			var data = copy(val);
+			data.constant();
+			return data;
 		}
 
-		number ln(number n)
+		std::size_t get_position(number posit)
 		{
-			return std::log(n);
+			if (posit < 0)
+				throw lang_error("Out of range.");
+			return posit;
 		}
 
-		number log10(number n)
+// Capacity
+		bool empty(const persistent_vector &vec)
 		{
-			return std::log10(n);
+			return vec.empty();
 		}
 
-		number log(number a, number b)
+		number size(const persistent_vector &vec)
 		{
-			return std::log(b / a);
+			return vec.size();
 		}
 
-		number sin(number n)
+// Access
+		var at(const persistent_vector &vec, number posit)
 		{
-			return std::sin(n);
+			return vec.at(get_position(posit));
 		}
 
-		number cos(number n)
+		var front(const persistent_vector &vec)
 		{
-			return std::cos(n);
+			return vec.at(0);
 		}
 
-		number tan(number n)
+		var back(const persistent_vector &vec)
 		{
-			return std::tan(n);
+			return vec.at(vec.size() - 1);
 		}
 
-		number asin(number n)
+// Updates, which return the new version and keep the old one unchanged
+		var set(const persistent_vector &vec, number posit, const var &val)
 		{
-			return std::asin(n);
+			return var::make<persistent_vector>(vec.set(get_position(posit), freeze(val)));
 		}
 
-		number acos(number n)
+		var push_back(const persistent_vector &vec, const var &val)
 		{
-			return std::acos(n);
+			return var::make<persistent_vector>(vec.push_back(freeze(val)));
 		}
 
-		number atan(number n)
+		var pop_back(const persistent_vector &vec)
 		{
-			return std::atan(n);
+			return var::make<persistent_vector>(vec.pop_back());
 		}
 
-		number sqrt(number n)
+// Conversions
+		array to_array(const persistent_vector &vec)
 		{
-			return std::sqrt(n);
+			array arr;
+			vec.for_each([&arr](const var &it) {
+				arr.push_back(copy(it));
+			});
+			return std::move(arr);
 		}
 
-		number root(number a, number b)
+		var from_array(const array &arr)
 		{
-			return std::pow(a, number(1) / b);
+			std::vector<var> data;
+			data.reserve(arr.size());
+			for (auto &it:arr)
+				data.push_back(freeze(it));
+			return var::make<persistent_vector>(data.begin(), data.end());
 		}
 
-		number pow(number a, number b)
+		void init()
 		{
-			return std::pow(a, b);
+			(*persistent_vector_ext)
+			.add_var("empty", make_cni(empty, true))
+			.add_var("size", make_cni(size, true))
+			.add_var("at", make_cni(at, true))
+			.add_var("front", make_cni(front, true))
+			.add_var("back", make_cni(back, true))
+			.add_var("set", make_cni(set, true))
+			.add_var("push_back", make_cni(push_back, true))
+			.add_var("pop_back", make_cni(pop_back, true))
+			.add_var("to_array", make_cni(to_array, true))
+			.add_var("from_array", make_cni(from_array, true))
+			.add_var("iterate", make_cni(iterator_cs_ext::iterate));
 		}
+	}
+	namespace persistent_map_cs_ext {
+		using namespace cs;
+		using persistent_vector_cs_ext::freeze;
 
-		number _min(number a, number b)
+// Capacity
+		bool empty(const persistent_map &map)
 		{
-			return (std::min)(a, b);
+			return map.empty();
 		}
 
-		number _max(number a, number b)
+		number size(const persistent_map &map)
 		{
-			return (std::max)(a, b);
+			return map.size();
 		}
 
-		number rand(number b, number e)
+// Lookup
+		bool exist(const persistent_map &map, const var &key)
 		{
-			return cov::rand<number>(b, e);
+			return map.find(key) != nullptr;
 		}
 
-		number randint(number b, number e)
+		var get(const persistent_map &map, const var &key)
 		{
-			return cov::rand<long>(b, e);
+			const pair *it = map.find(key);
+			if (it == nullptr)
+				throw lang_error("Key does not exist.");
+			return it->second;
 		}
 
-		void init()
+		var get_or_default(const persistent_map &map, const var &key, const var &val)
 		{
-			(*math_const_ext)
-			.add_var("max", var::make_constant<number>((std::numeric_limits<number>::max)()))
-			.add_var("min", var::make_constant<number>((std::numeric_limits<number>::min)()))
-			.add_var("inf", var::make_constant<number>(std::numeric_limits<number>::infinity()))
-			.add_var("nan", var::make_constant<number>(std::numeric_limits<number>::quiet_NaN()))
-			.add_var("pi", var::make_constant<number>(std::asin(number(1)) * 2))
-			.add_var("e", var::make_constant<number>(std::exp(number(1))));
-			(*math_ext)
-			.add_var("constants", make_namespace(math_const_ext))
-			.add_var("abs", make_cni(abs, true))
-			.add_var("ln", make_cni(ln, true))
-			.add_var("log10", make_cni(log10, true))
-			.add_var("log", make_cni(log, true))
-			.add_var("sin", make_cni(sin, true))
-			.add_var("cos", make_cni(cos, true))
-			.add_var("tan", make_cni(tan, true))
-			.add_var("asin", make_cni(asin, true))
-			.add_var("acos", make_cni(acos, true))
-			.add_var("atan", make_cni(atan, true))
-			.add_var("sqrt", make_cni(sqrt, true))
-			.add_var("root", make_cni(root, true))
-			.add_var("pow", make_cni(pow, true))
-			.add_var("min", make_cni(_min, true))
-			.add_var("max", make_cni(_max, true))
-			.add_var("rand", make_cni(rand))
-			.add_var("randint", make_cni(randint));
+			const pair *it = map.find(key);
+			return it != nullptr ? it->second : val;
 		}
-	}
-	namespace pair_cs_ext {
-		using namespace cs;
 
-		var first(const pair &p)
+// Updates, which return the new version and keep the old one unchanged
+		var insert(const persistent_map &map, const var &key, const var &val)
 		{
-			return p.first;
+			return var::make<persistent_map>(map.insert(freeze(key), freeze(val)));
 		}
 
-		var second(const pair &p)
+		var erase(const persistent_map &map, const var &key)
 		{
-			return p.second;
+			return var::make<persistent_map>(map.erase(key));
 		}
 
-		void init()
+// Conversions
+		var to_hash_map(const persistent_map &map)
 		{
-			(*pair_ext)
-			.add_var("first", make_cni(first, true))
-			.add_var("second", make_cni(second, true));
+			hash_map data;
+			data.reserve(map.size());
+			map.for_each([&data](const pair &it) {
+				data.emplace(copy(it.first), copy(it.second));
+			});
+			return var::make<hash_map>(std::move(data));
 		}
-	}
-	namespace runtime_cs_ext {
-		using namespace cs;
 
-		string get_import_path()
+		var from_hash_map(const hash_map &data)
 		{
-			return current_process->import_path;
+			persistent_map map;
+			for (auto &it:data)
+				map = map.insert(freeze(it.first), freeze(it.second));
+			return var::make<persistent_map>(std::move(map));
 		}
 
-		void info()
+		void init()
 		{
-			std::cout << "Covariant Script Programming Language Interpreter\nVersion: " << current_process->version
-			          << "\n"
-			          "Copyright (C) 2019 Michael Lee. All rights reserved.\n"
-			          "Licensed under the Covariant Innovation General Public License,\n"
-			          "Version 1.0 (the \"License\");\n"
-			          "you may not use this file except in compliance with the License.\n"
-			          "You may obtain a copy of the License at\n"
-			          "\nhttps://covariant.cn/licenses/LICENSE-1.0\n"
-			          "Unless required by applicable law or agreed to in writing, software\n"
-			          "distributed under the License is distributed on an \"AS IS\" BASIS,\n"
-			          "WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.\n"
-			          "See the License for the specific language governing permissions and\n"
-			          "limitations under the License.\n"
-			          "Please visit http://covscript.org for more information."
-			          << std::endl;
+			(*persistent_map_ext)
+			.add_var("empty", make_cni(empty, true))
+			.add_var("size", make_cni(size, true))
+			.add_var("exist", make_cni(exist, true))
+			.add_var("get", make_cni(get, true))
+			.add_var("get_or_default", make_cni(get_or_default, true))
+			.add_var("insert", make_cni(insert, true))
+			.add_var("erase", make_cni(erase, true))
+			.add_var("to_hash_map", make_cni(to_hash_map, true))
+			.add_var("from_hash_map", make_cni(from_hash_map, true))
+			.add_var("iterate", make_cni(iterator_cs_ext::iterate));
 		}
+	}
+	namespace bitset_cs_ext {
+		using namespace cs;
 
-		number time()
+		std::size_t get_position(number posit)
 		{
-			return cov::timer::time(cov::timer::time_unit::milli_sec);
+			if (posit < 0)
+				throw lang_error("Out of range.");
+			return posit;
 		}
 
-		void delay(number time)
+// Capacity
+		number size(const bitset &bits)
 		{
-			cov::timer::delay(cov::timer::time_unit::milli_sec, time);
+			return bits.size();
 		}
 
-		var exception(const string &str)
+		void resize(bitset &bits, number size)
 		{
-			return var::make<lang_error>(str);
+			bits.resize(get_position(size));
 		}
 
-		std::size_t hash(const var &val)
+// Bit access
+		bool test(const bitset &bits, number posit)
 		{
-			return val.hash();
+			return bits.test(get_position(posit));
 		}
 
-		var build(const context_t &context, const string &expr)
+		void set(bitset &bits, number posit)
 		{
-			std::deque<char> buff;
-			expression_t tree;
-			for (auto &ch:expr)
-				buff.push_back(ch);
-			context->compiler->build_expr(buff, tree);
-			return var::make<expression_t>(tree);
+			bits.set(get_position(posit));
 		}
 
-		var solve(const context_t &context, expression_t &tree)
+		void reset(bitset &bits, number posit)
 		{
-			return context->instance->parse_expr(tree.root());
+			bits.reset(get_position(posit));
 		}
 
-		var cmd_args(const context_t &context)
+		void flip(bitset &bits, number posit)
 		{
-			return context->cmd_args;
+			bits.flip(get_position(posit));
 		}
 
-		var import(const context_t &context, const string &dir, const string &name)
+		void set_all(bitset &bits)
 		{
-			return make_namespace(context->instance->import(dir, name));
+			bits.set_all();
 		}
 
-		var source_import(const context_t &context, const string &path)
+		void reset_all(bitset &bits)
 		{
-			return make_namespace(context->instance->source_import(path));
+			bits.reset_all();
 		}
 
-		number argument_count(const var &func)
+// Operations
+		number count(const bitset &bits)
 		{
-			if (func.type() == typeid(object_method)) {
-				const callable::function_type &target = func.const_val<object_method>().callable.const_val<callable>().get_raw_data();
-				if (target.target_type() == typeid(function))
-					return target.target<function>()->argument_count() - 1;
-				else
-					return target.target<cni>()->argument_count() - 1;
-			}
-			else if (func.type() == typeid(callable)) {
-				const callable::function_type &target = func.const_val<callable>().get_raw_data();
-				if (target.target_type() == typeid(function))
-					return target.target<function>()->argument_count();
-				else
-					return target.target<cni>()->argument_count();
-			}
-			else
-				throw lang_error("Not a function.");
+			return bits.count();
 		}
 
-		void init()
+		bool any(const bitset &bits)
 		{
-			(*runtime_ext)
-			.add_var("std_version", var::make_constant<number>(current_process->std_version))
-			.add_var("get_import_path", make_cni(get_import_path, true))
-			.add_var("info", make_cni(info))
-			.add_var("time", make_cni(time))
-			.add_var("delay", make_cni(delay))
-			.add_var("exception", make_cni(exception))
-			.add_var("hash", make_cni(hash, true))
-			.add_var("build", make_cni(build))
-			.add_var("solve", make_cni(solve))
-			.add_var("cmd_args", make_cni(cmd_args, true))
-			.add_var("import", make_cni(import, true))
-			.add_var("source_import", make_cni(source_import, true))
-			.add_var("argument_count", make_cni(argument_count, true));
-			(*context_ext)
-			.add_var("build", make_cni(build))
-			.add_var("solve", make_cni(solve))
-			.add_var("cmd_args", make_cni(cmd_args, true))
-			.add_var("import", make_cni(import, true))
-			.add_var("source_import", make_cni(source_import, true));
+			return bits.any();
 		}
-	}
-	namespace string_cs_ext {
-		using namespace cs;
 
-		string append(string &str, const var &val)
+		bool none(const bitset &bits)
 		{
-			str.append(val.to_string());
-			return str;
+			return !bits.any();
 		}
 
-		string insert(string &str, number posit, const var &val)
+		// Returns -1 if there is no set bit
+		number find_next(const bitset &bits, number posit)
 		{
-			str.insert(posit, val.to_string());
-			return str;
+			std::size_t pos = bits.find_next(get_position(posit));
+			return pos == bitset::npos ? -1 : number(pos);
 		}
 
-		string erase(string &str, number b, number e)
+		number find_first(const bitset &bits)
 		{
-			str.erase(b, e);
-			return str;
+			return find_next(bits, 0);
 		}
 
-		string replace(string &str, number posit, number count, const var &val)
+		void and_with(bitset &bits, const bitset &other)
 		{
-			str.replace(posit, count, val.to_string());
-			return str;
+			bits.and_with(other);
 		}
 
-		string substr(string &str, number b, number e)
+		void or_with(bitset &bits, const bitset &other)
 		{
-			return str.substr(b, e);
+			bits.or_with(other);
 		}
 
-		number find(string &str, const string &s, number posit)
+		void xor_with(bitset &bits, const bitset &other)
 		{
-			auto pos = str.find(s, posit);
-			if (pos == std::string::npos)
-				return -1;
-			else
-				return pos;
+			bits.xor_with(other);
 		}
 
-		number rfind(string &str, const string &s, number posit)
+		void init()
 		{
-			std::size_t pos = 0;
-			if (posit == -1)
-				pos = str.rfind(s, std::string::npos);
-			else
-				pos = str.rfind(s, posit);
-			if (pos == std::string::npos)
-				return -1;
-			else
-				return pos;
+			(*bitset_ext)
+			.add_var("size", make_cni(size, true))
+			.add_var("resize", make_cni(resize, true))
+			.add_var("test", make_cni(test, true))
+			.add_var("set", make_cni(set, true))
+			.add_var("reset", make_cni(reset, true))
+			.add_var("flip", make_cni(flip, true))
+			.add_var("set_all", make_cni(set_all, true))
+			.add_var("reset_all", make_cni(reset_all, true))
+			.add_var("count", make_cni(count, true))
+			.add_var("any", make_cni(any, true))
+			.add_var("none", make_cni(none, true))
+			.add_var("find_first", make_cni(find_first, true))
+			.add_var("find_next", make_cni(find_next, true))
+			.add_var("and_with", make_cni(and_with, true))
+			.add_var("or_with", make_cni(or_with, true))
+			.add_var("xor_with", make_cni(xor_with, true));
 		}
+	}
+	namespace byte_buffer_cs_ext {
+		using namespace cs;
 
-		string cut(string &str, number n)
+		enum class byte_order {
+			little, big
+		};
+
+// Decoding and encoding, shared with the mapped files
+		void check_range(std::size_t size, number posit, std::size_t width)
 		{
-			for (std::size_t i = 0; i < n; ++i)
-				str.pop_back();
-			return str;
+			if (posit < 0 || posit + width > size)
+				throw lang_error("Out of range.");
 		}
 
-		bool empty(const string &str)
+		std::size_t check_width(number width)
 		{
-			return str.empty();
+			if (width < 1 || width > 8)
+				throw lang_error("Width of integer must between 1 and 8 bytes.");
+			return width;
 		}
 
-		void clear(string &str)
+		std::uint64_t load_bits(const std::uint8_t *data, std::size_t width, byte_order order)
 		{
-			str.clear();
+			std::uint64_t bits = 0;
+			for (std::size_t i = 0; i < width; ++i)
+				bits = (bits << 8) | data[order == byte_order::little ? width - 1 - i : i];
+			return bits;
 		}
 
-		number size(const string &str)
+		void store_bits(byte_buffer &buff, std::uint64_t bits, std::size_t width, byte_order order)
 		{
-			return str.size();
+			std::size_t offset = buff.size();
+			buff.resize(offset + width);
+			for (std::size_t i = 0; i < width; ++i, bits >>= 8)
+				buff[order == byte_order::little ? offset + i : offset + width - 1 - i] = bits & 0xFF;
 		}
 
-		string tolower(const string &str)
+		number load_uint(const std::uint8_t *data, std::size_t size, number posit, number width, byte_order order)
 		{
-			string s;
-			for (auto &ch:str)
-				s.push_back(std::tolower(ch));
-			return std::move(s);
+			std::size_t w = check_width(width);
+			check_range(size, posit, w);
+			return load_bits(data + static_cast<std::size_t>(posit), w, order);
 		}
 
-		string toupper(const string &str)
+		number load_int(const std::uint8_t *data, std::size_t size, number posit, number width, byte_order order)
 		{
-			string s;
-			for (auto &ch:str)
-				s.push_back(std::toupper(ch));
-			return std::move(s);
+			std::size_t w = check_width(width);
+			check_range(size, posit, w);
+			std::uint64_t bits = load_bits(data + static_cast<std::size_t>(posit), w, order);
+			// Sign extension
+			if (w < 8 && (bits >> (w * 8 - 1)) & 1)
+				bits |= ~std::uint64_t(0) << (w * 8);
+			return static_cast<std::int64_t>(bits);
 		}
 
-		number to_number(const string &str)
+		number load_float(const std::uint8_t *data, std::size_t size, number posit, byte_order order)
 		{
-			return parse_number(str);
+			check_range(size, posit, sizeof(float));
+			std::uint32_t bits = load_bits(data + static_cast<std::size_t>(posit), sizeof(float), order);
+			float val = 0;
+			std::memcpy(&val, &bits, sizeof(float));
+			return val;
 		}
 
-		array split(const string &str, const array &signals)
+		number load_double(const std::uint8_t *data, std::size_t size, number posit, byte_order order)
 		{
-			array
-			arr;
-			string buf;
-			bool found = false;
-			for (auto &ch:str) {
-				for (auto &sig:signals) {
-					if (ch == sig.const_val<char>()) {
-						if (!buf.empty()) {
-							arr.push_back(buf);
-							buf.clear();
-						}
-						found = true;
-						break;
-					}
-				}
-				if (found)
-					found = false;
-				else
-					buf.push_back(ch);
-			}
-			if (!buf.empty())
-				arr.push_back(buf);
-			return std::move(arr);
+			check_range(size, posit, sizeof(double));
+			std::uint64_t bits = load_bits(data + static_cast<std::size_t>(posit), sizeof(double), order);
+			double val = 0;
+			std::memcpy(&val, &bits, sizeof(double));
+			return val;
 		}
 
-		void init()
+// Element access
+		number at(const byte_buffer &buff, number posit)
 		{
-			(*string_ext)
-			.add_var("append", make_cni(append, true))
-			.add_var("insert", make_cni(insert, true))
-			.add_var("erase", make_cni(erase, true))
-			.add_var("replace", make_cni(replace, true))
-			.add_var("substr", make_cni(substr, true))
-			.add_var("find", make_cni(find, true))
-			.add_var("rfind", make_cni(rfind, true))
-			.add_var("cut", make_cni(cut, true))
-			.add_var("empty", make_cni(empty, true))
-			.add_var("clear", make_cni(clear, true))
-			.add_var("size", make_cni(size, true))
-			.add_var("tolower", make_cni(tolower, true))
-			.add_var("toupper", make_cni(toupper, true))
-			.add_var("to_number", make_cni(to_number, true))
-			.add_var("split", make_cni(split, true));
+			check_range(buff.size(), posit, 1);
+			return buff[posit];
 		}
-	}
-	namespace console_cs_ext {
-		using namespace cs;
-		using namespace cs_impl;
 
-		number terminal_width()
+		void set(byte_buffer &buff, number posit, number val)
 		{
-			return conio::terminal_width();
+			check_range(buff.size(), posit, 1);
+			buff[posit] = static_cast<std::uint8_t>(static_cast<unsigned int>(val));
 		}
 
-		number terminal_height()
+		number get_uint(const byte_buffer &buff, number posit, number width, byte_order order)
 		{
-			return conio::terminal_height();
+			return load_uint(buff.data(), buff.size(), posit, width, order);
 		}
 
-		void gotoxy(number x, number y)
+		number get_int(const byte_buffer &buff, number posit, number width, byte_order order)
 		{
-			conio::gotoxy(x, y);
+			return load_int(buff.data(), buff.size(), posit, width, order);
 		}
 
-		void echo(bool v)
+		number get_float(const byte_buffer &buff, number posit, byte_order order)
 		{
-			conio::echo(v);
+			return load_float(buff.data(), buff.size(), posit, order);
 		}
 
-		void clrscr()
+		number get_double(const byte_buffer &buff, number posit, byte_order order)
 		{
-			conio::clrscr();
+			return load_double(buff.data(), buff.size(), posit, order);
 		}
 
-		char getch()
+// Capacity
+		bool empty(const byte_buffer &buff)
 		{
-			return conio::getch();
+			return buff.empty();
 		}
 
-		bool kbhit()
+		number size(const byte_buffer &buff)
 		{
-			return conio::kbhit();
+			return buff.size();
 		}
 
-		void init()
+// Modifiers
+		void clear(byte_buffer &buff)
 		{
-			(*console_ext)
-			.add_var("terminal_width", make_cni(terminal_width))
-			.add_var("terminal_height", make_cni(terminal_height))
-			.add_var("gotoxy", make_cni(gotoxy))
-			.add_var("echo", make_cni(echo))
-			.add_var("clrscr", make_cni(clrscr))
-			.add_var("getch", make_cni(getch))
-			.add_var("kbhit", make_cni(kbhit));
+			buff.clear();
 		}
-	}
-
-	namespace file_cs_ext {
-		using namespace cs;
-		using namespace cs_impl;
 
-		bool copy(const string &source, const string &dest)
+		void resize(byte_buffer &buff, number size)
 		{
-			std::ifstream in(source, std::ios_base::in | std::ios_base::binary);
-			std::ofstream out(dest, std::ios_base::out | std::ios_base::binary);
-			if (!in || !out)
-				return false;
-			char buffer[256];
-			while (!in.eof()) {
-				in.read(buffer, 256);
-				out.write(buffer, in.gcount());
-			}
-			return true;
+			if (size < 0)
+				throw lang_error("Size of buffer can not be negative.");
+			buff.resize(size);
 		}
 
-		bool remove(const string &path)
+		void append(byte_buffer &buff, const byte_buffer &other)
 		{
-			return std::remove(path.c_str()) == 0;
+			buff.insert(buff.end(), other.begin(), other.end());
 		}
 
-		bool exists(const string &path)
+		void append_string(byte_buffer &buff, const string &str)
 		{
-			return std::ifstream(path).is_open();
+			buff.insert(buff.end(), str.begin(), str.end());
 		}
 
-		bool rename(const string &source, const string &dest)
+		void append_uint(byte_buffer &buff, number val, number width, byte_order order)
 		{
-			return std::rename(source.c_str(), dest.c_str()) == 0;
+			if (val < 0)
+				throw lang_error("Unsigned integer can not be negative.");
+			store_bits(buff, static_cast<std::uint64_t>(val), check_width(width), order);
 		}
 
-		void init()
+		void append_int(byte_buffer &buff, number val, number width, byte_order order)
 		{
-			(*file_ext)
-			.add_var("copy", make_cni(copy))
-			.add_var("remove", make_cni(remove))
-			.add_var("exists", make_cni(exists))
-			.add_var("rename", make_cni(rename));
+			store_bits(buff, static_cast<std::uint64_t>(static_cast<std::int64_t>(val)), check_width(width), order);
 		}
-	}
 
-	namespace path_cs_ext {
-		using namespace cs;
-		using namespace cs_impl;
+		void append_float(byte_buffer &buff, number val, byte_order order)
+		{
+			float data = static_cast<float>(val);
+			std::uint32_t bits = 0;
+			std::memcpy(&bits, &data, sizeof(float));
+			store_bits(buff, bits, sizeof(float), order);
+		}
 
-		string name(const path_info &info)
+		void append_double(byte_buffer &buff, number val, byte_order order)
 		{
-			return info.name;
+			double data = static_cast<double>(val);
+			std::uint64_t bits = 0;
+			std::memcpy(&bits, &data, sizeof(double));
+			store_bits(buff, bits, sizeof(double), order);
 		}
 
-		int type(const path_info &info)
+// Conversions
+		byte_buffer slice(const byte_buffer &buff, number posit, number count)
 		{
-			return info.type;
+			if (count < 0)
+				throw lang_error("Out of range.");
+			check_range(buff.size(), posit, count);
+			return byte_buffer(buff.begin() + posit, buff.begin() + posit + count);
 		}
 
-		array scan(const string &path)
+		string to_string(const byte_buffer &buff)
 		{
-			DIR *dir = ::opendir(path.c_str());
-			if (dir == nullptr)
-				throw cs::lang_error("Path does not exist.");
-			array
-			entries;
-			for (dirent *dp = ::readdir(dir); dp != nullptr; dp = ::readdir(dir))
-				entries.push_back(var::make<path_info>(dp->d_name, dp->d_type));
-			::closedir(dir);
-			return std::move(entries);
+			return string(buff.begin(), buff.end());
 		}
 
 		void init()
 		{
-			(*path_type_ext)
-			.add_var("unknown", var::make_constant<int>(DT_UNKNOWN))
-			.add_var("fifo", var::make_constant<int>(DT_FIFO))
-			.add_var("sock", var::make_constant<int>(DT_SOCK))
-			.add_var("chr", var::make_constant<int>(DT_CHR))
-			.add_var("dir", var::make_constant<int>(DT_DIR))
-			.add_var("blk", var::make_constant<int>(DT_BLK))
-			.add_var("reg", var::make_constant<int>(DT_REG))
-			.add_var("lnk", var::make_constant<int>(DT_LNK));
-			(*path_info_ext)
-			.add_var("name", make_cni(name))
-			.add_var("type", make_cni(type));
-			(*path_ext)
-			.add_var("type", make_namespace(path_type_ext))
-			.add_var("info", make_namespace(path_info_ext))
-			.add_var("separator", var::make_constant<char>(path_separator))
-			.add_var("delimiter", var::make_constant<char>(path_delimiter))
-			.add_var("scan", make_cni(scan));
-		}
-	}
+			(*byte_buffer_ext)
+			.add_var("at", make_cni(at, true))
+			.add_var("set", make_cni(set, true))
+			.add_var("get_uint", make_cni(get_uint, true))
+			.add_var("get_int", make_cni(get_int, true))
+			.add_var("get_float", make_cni(get_float, true))
+			.add_var("get_double", make_cni(get_double, true))
+			.add_var("empty", make_cni(empty, true))
+			.add_var("size", make_cni(size, true))
+			.add_var("clear", make_cni(clear, true))
+			.add_var("resize", make_cni(resize, true))
+			.add_var("append", make_cni(append, true))
+			.add_var("append_string", make_cni(append_string, true))
+			.add_var("append_uint", make_cni(append_uint, true))
+			.add_var("append_int", make_cni(append_int, true))
+			.add_var("append_float", make_cni(append_float, true))
+			.add_var("append_double", make_cni(append_double, true))
+			.add_var("slice", make_cni(slice, true))
+			.add_var("to_string", make_cni(to_string, true));
+		}
+	}
+	namespace iostream_cs_ext {
+		using namespace cs;
+
+		enum class buffer_policy {
+			automatic, none, line, full
+		};
+
+		// Files are written through a larger buffer than the default one
+		class buffered_ofstream final : public std::ofstream {
+			static constexpr std::size_t buffer_size = 64 * 1024;
+			std::unique_ptr<char[]> m_buff;
+		public:
+			buffered_ofstream(const std::string &path, std::ios_base::openmode openmode) : m_buff(new char[buffer_size])
+			{
+				rdbuf()->pubsetbuf(m_buff.get(), buffer_size);
+				open(path, openmode);
+			}
+
+			~buffered_ofstream() override
+			{
+				// The buffer must outlive the last flush
+				close();
+			}
+		};
+
+		var fstream(const string &path, std::ios_base::openmode openmode)
+		{
+			switch (openmode) {
+			case std::ios_base::in:
+				return var::make<istream>(new std::ifstream(path, std::ios_base::in));
+				break;
+			case std::ios_base::out:
+				return var::make<ostream>(new buffered_ofstream(path, std::ios_base::out));
+				break;
+			case std::ios_base::app:
+				return var::make<ostream>(new buffered_ofstream(path, std::ios_base::app));
+				break;
+			case std::ios_base::in | std::ios_base::binary:
+				return var::make<istream>(new std::ifstream(path, std::ios_base::in | std::ios_base::binary));
+				break;
+			case std::ios_base::out | std::ios_base::binary:
+				return var::make<ostream>(new buffered_ofstream(path, std::ios_base::out | std::ios_base::binary));
+				break;
+			case std::ios_base::app | std::ios_base::binary:
+				return var::make<ostream>(new buffered_ofstream(path, std::ios_base::app | std::ios_base::binary));
+				break;
+			default:
+				throw lang_error("Unsupported openmode.");
+			}
+		}
+
+		void setprecision(number pre)
+		{
+			current_process->output_precision = pre;
+		}
+
+		void init()
+		{
+			(*iostream_ext)
+			.add_var("istream", make_namespace(istream_ext))
+			.add_var("ostream", make_namespace(ostream_ext))
+			.add_var("seekdir", make_namespace(seekdir_ext))
+			.add_var("openmode", make_namespace(openmode_ext))
+			.add_var("buffering", make_namespace(buffering_ext))
+			.add_var("endian", make_namespace(endian_ext));
+			(*seekdir_ext)
+			.add_var("start", var::make_constant<std::ios_base::seekdir>(std::ios_base::beg))
+			.add_var("finish", var::make_constant<std::ios_base::seekdir>(std::ios_base::end))
+			.add_var("present", var::make_constant<std::ios_base::seekdir>(std::ios_base::cur));
+			(*openmode_ext)
+			.add_var("in", var::make_constant<std::ios_base::openmode>(std::ios_base::in))
+			.add_var("out", var::make_constant<std::ios_base::openmode>(std::ios_base::out))
+			.add_var("app", var::make_constant<std::ios_base::openmode>(std::ios_base::app))
+			.add_var("bin_in", var::make_constant<std::ios_base::openmode>(std::ios_base::in | std::ios_base::binary))
+			.add_var("bin_out", var::make_constant<std::ios_base::openmode>(std::ios_base::out | std::ios_base::binary))
+			.add_var("bin_app", var::make_constant<std::ios_base::openmode>(std::ios_base::app | std::ios_base::binary));
+			(*buffering_ext)
+			.add_var("automatic", var::make_constant<buffer_policy>(buffer_policy::automatic))
+			.add_var("none", var::make_constant<buffer_policy>(buffer_policy::none))
+			.add_var("line", var::make_constant<buffer_policy>(buffer_policy::line))
+			.add_var("full", var::make_constant<buffer_policy>(buffer_policy::full));
+			(*endian_ext)
+			.add_var("little", var::make_constant<byte_buffer_cs_ext::byte_order>(byte_buffer_cs_ext::byte_order::little))
+			.add_var("big", var::make_constant<byte_buffer_cs_ext::byte_order>(byte_buffer_cs_ext::byte_order::big));
+			(*iostream_ext)
+			.add_var("fstream", make_cni(fstream))
+			.add_var("lines", make_cni(iterator_cs_ext::lines))
+			.add_var("setprecision", make_cni(setprecision));
+		}
+	}
+	namespace istream_cs_ext {
+		using namespace cs;
+
+		var parse_value(const std::string &str)
+		{
+			if (str == "true")
+				return true;
+			if (str == "false")
+				return false;
+			number val = 0;
+			if (try_parse_number(str, val))
+				return val;
+			else
+				return str;
+		}
+
+// Input Stream
+		char get(istream &in)
+		{
+			return in->get();
+		}
+
+		char peek(istream &in)
+		{
+			return in->peek();
+		}
+
+		void unget(istream &in)
+		{
+			in->unget();
+		}
+
+		string getline(istream &in)
+		{
+			std::string str;
+			std::getline(*in, str);
+			return std::move(str);
+		}
+
+		number tell(istream &in)
+		{
+			return in->tellg();
+		}
+
+		void seek(istream &in, number pos)
+		{
+			in->seekg(pos);
+		}
+
+		void seek_from(istream &in, std::ios_base::seekdir dir, number offset)
+		{
+			in->seekg(offset, dir);
+		}
+
+		bool good(const istream &in)
+		{
+			return static_cast<bool>(*in);
+		}
+
+		bool eof(const istream &in)
+		{
+			return in->eof();
+		}
+
+		var input(istream &in)
+		{
+			std::string str;
+			*in >> str;
+			return parse_value(str);
+		}
+
+		void ignore(istream &in)
+		{
+			in->ignore((std::numeric_limits<std::streamsize>::max)(), '\n');
+		}
+
+		// The buffer grows by chunks, so a large count on a short stream does not allocate the whole count
+		byte_buffer read(istream &in, number count)
+		{
+			constexpr std::size_t chunk_size = 64 * 1024;
+			if (count < 0)
+				throw lang_error("Count of bytes can not be negative.");
+			std::size_t total = count;
+			byte_buffer buff;
+			while (buff.size() < total) {
+				std::size_t offset = buff.size();
+				buff.resize(offset + std::min(chunk_size, total - offset));
+				in->read(reinterpret_cast<char *>(buff.data() + offset), buff.size() - offset);
+				buff.resize(offset + in->gcount());
+				if (!*in)
+					break;
+			}
+			return std::move(buff);
+		}
+
+		// Reads at most count bytes which are available without blocking, pipes of processes never wait for the child
+		byte_buffer read_some(istream &in, number count)
+		{
+			if (count < 0)
+				throw lang_error("Count of bytes can not be negative.");
+			byte_buffer buff(std::min<std::size_t>(count, 64 * 1024));
+			buff.resize(in->readsome(reinterpret_cast<char *>(buff.data()), buff.size()));
+			return std::move(buff);
+		}
+
+		byte_buffer read_all(istream &in)
+		{
+			constexpr std::size_t chunk_size = 64 * 1024;
+			byte_buffer buff;
+			// Reserve the remaining size when the stream is seekable
+			std::streampos begin = in->tellg();
+			if (begin != std::streampos(-1) && in->seekg(0, std::ios_base::end)) {
+				std::streampos end = in->tellg();
+				in->seekg(begin);
+				// One more byte to detect the end of file without growing again
+				if (end >= begin)
+					buff.reserve(static_cast<std::size_t>(end - begin) + 1);
+			}
+			in->clear();
+			std::size_t count = 0;
+			do {
+				std::size_t offset = buff.size();
+				std::size_t room = buff.capacity() - offset;
+				buff.resize(offset + (room == 0 ? chunk_size : room));
+				in->read(reinterpret_cast<char *>(buff.data() + offset), buff.size() - offset);
+				count = in->gcount();
+				buff.resize(offset + count);
+			}
+			while (*in);
+			return std::move(buff);
+		}
+
+		void init()
+		{
+			(*istream_ext)
+			.add_var("get", make_cni(get))
+			.add_var("peek", make_cni(peek))
+			.add_var("unget", make_cni(unget))
+			.add_var("getline", make_cni(getline))
+			.add_var("tell", make_cni(tell))
+			.add_var("seek", make_cni(seek))
+			.add_var("seek_from", make_cni(seek_from))
+			.add_var("good", make_cni(good))
+			.add_var("eof", make_cni(eof))
+			.add_var("input", make_cni(input))
+			.add_var("ignore", make_cni(ignore))
+			.add_var("read", make_cni(read))
+			.add_var("read_all", make_cni(read_all))
+			.add_var("read_some", make_cni(read_some))
+			.add_var("iterate", make_cni(iterator_cs_ext::iterate))
+			.add_var("lines", make_cni(iterator_cs_ext::lines));
+		}
+	}
+	namespace ostream_cs_ext {
+		using namespace cs;
+
+// Output Stream
+		void put(ostream &out, char c)
+		{
+			out->put(c);
+		}
+
+		number tell(ostream &out)
+		{
+			return out->tellp();
+		}
+
+		void seek(ostream &out, number pos)
+		{
+			out->seekp(pos);
+		}
+
+		void seek_from(ostream &out, std::ios_base::seekdir dir, number offset)
+		{
+			out->seekp(offset, dir);
+		}
+
+		void flush(ostream &out)
+		{
+			out->flush();
+		}
+
+		bool good(const ostream &out)
+		{
+			return static_cast<bool>(*out);
+		}
+
+		using iostream_cs_ext::buffer_policy;
+
+		int buffer_policy_index()
+		{
+			static const int index = std::ios_base::xalloc();
+			return index;
+		}
+
+		void set_buffering(ostream &out, buffer_policy policy)
+		{
+			out->iword(buffer_policy_index()) = static_cast<long>(policy);
+			if (policy == buffer_policy::none)
+				out->flush();
+		}
+
+		buffer_policy get_buffering(ostream &out)
+		{
+			auto policy = static_cast<buffer_policy>(out->iword(buffer_policy_index()));
+			if (policy != buffer_policy::automatic)
+				return policy;
+			// Line buffered for terminals, fully buffered for files and pipes
+			if (out.get() == &std::cout && conio::output_is_terminal())
+				return buffer_policy::line;
+			else
+				return buffer_policy::full;
+		}
+
+		void print(ostream &out, const var &val)
+		{
+			*out << val;
+			if (get_buffering(out) == buffer_policy::none)
+				out->flush();
+		}
+
+		void println(ostream &out, const var &val)
+		{
+			*out << val << '\n';
+			if (get_buffering(out) != buffer_policy::full)
+				out->flush();
+		}
+
+		// Formats every element into one line of a single buffer
+		void write_all(ostream &out, const array &arr)
+		{
+			std::string buff;
+			for (auto &it:arr) {
+				buff += it.to_string();
+				buff += '\n';
+			}
+			out->write(buff.data(), buff.size());
+			if (get_buffering(out) != buffer_policy::full)
+				out->flush();
+		}
+
+		void write(ostream &out, const byte_buffer &buff)
+		{
+			out->write(reinterpret_cast<const char *>(buff.data()), buff.size());
+			if (get_buffering(out) == buffer_policy::none)
+				out->flush();
+		}
+
+		void init()
+		{
+			(*ostream_ext)
+			.add_var("put", make_cni(put))
+			.add_var("tell", make_cni(tell))
+			.add_var("seek", make_cni(seek))
+			.add_var("seek_from", make_cni(seek_from))
+			.add_var("flush", make_cni(flush))
+			.add_var("good", make_cni(good))
+			.add_var("set_buffering", make_cni(set_buffering))
+			.add_var("get_buffering", make_cni(get_buffering))
+			.add_var("write", make_cni(write))
+			.add_var("write_all", make_cni(write_all))
+			.add_var("print", make_cni(print))
+			.add_var("println", make_cni(println));
+		}
+	}
+	namespace list_cs_ext {
+		using namespace cs;
+
+// Element access
+		var front(const list &lst)
+		{
+			return lst.front();
+		}
+
+		var back(const list &lst)
+		{
+			return lst.back();
+		}
+
+// Iterators
+		list::iterator begin(list &lst)
+		{
+			return lst.begin();
+		}
+
+		list::iterator end(list &lst)
+		{
+			return lst.end();
+		}
+
+		list::iterator forward(list::iterator &it)
+		{
+			return ++it;
+		}
+
+		list::iterator backward(list::iterator &it)
+		{
+			return --it;
+		}
+
+		var data(list::iterator &it)
+		{
+			return *it;
+		}
+
+// Capacity
+		bool empty(const list &lst)
+		{
+			return lst.empty();
+		}
+
+		number size(const list &lst)
+		{
+			return lst.size();
+		}
+
+// Modifiers
+		void clear(list &lst)
+		{
+			lst.clear();
+		}
+
+		list::iterator insert(list &lst, list::iterator &pos, const var &val)
+		{
+			return lst.insert(pos, copy(val));
+		}
+
+		list::iterator erase(list &lst, list::iterator &pos)
+		{
+			return lst.erase(pos);
+		}
+
+		void push_front(list &lst, const var &val)
+		{
+			lst.push_front(copy(val));
+		}
+
+		void pop_front(list &lst)
+		{
+			lst.pop_front();
+		}
+
+		void push_back(list &lst, const var &val)
+		{
+			lst.push_back(copy(val));
+		}
+
+		void pop_back(list &lst)
+		{
+			lst.pop_back();
+		}
+
+// Operations
+		void remove(list &lst, const var &val)
+		{
+			lst.remove(val);
+		}
+
+		void reverse(list &lst)
+		{
+			lst.reverse();
+		}
+
+		void unique(list &lst)
+		{
+			lst.unique();
+		}
+
+		// The list is sorted stably, by the default ordering or by script functions
+		void sort(list &lst)
+		{
+			array_cs_ext::with_default_less(lst.begin(), lst.end(), [&lst](auto less) {
+				lst.sort(less);
+			});
+		}
+
+		void sort_with(list &lst, const var &func)
+		{
+			array_cs_ext::sort_elements_with(lst, func);
+		}
+
+		void sort_by(list &lst, const var &func)
+		{
+			array_cs_ext::sort_elements_by(lst, func, true);
+		}
+
+// Operations
+		var to_array(const var &val)
+		{
+			if (array_cs_ext::is_movable(val)) {
+				list &lst = val.val<list>();
+				var arr = var::make<array>(std::make_move_iterator(lst.begin()), std::make_move_iterator(lst.end()));
+				lst.clear();
+				return std::move(arr);
+			}
+			const list &lst = val.const_val<list>();
+			var arr = var::make<array>(lst.begin(), lst.end());
+			arr.detach();
+			return std::move(arr);
+		}
+
+		// Iterates over count elements from posit without copying them
+		iterator_t view(const var &val, number posit, number count)
+		{
+			const list &lst = val.const_val<list>();
+			auto range = array_cs_ext::view_range(posit, count, lst.size());
+			return std::make_shared<iterator_cs_ext::list_view_generator>(val, std::next(lst.begin(), range.first), range.second);
+		}
+
+		void init()
+		{
+			(*list_iterator_ext)
+			.add_var("forward", make_cni(forward, true))
+			.add_var("backward", make_cni(backward, true))
+			.add_var("data", make_cni(data, true));
+			(*list_ext)
+			.add_var("iterator", make_namespace(list_iterator_ext))
+			.add_var("front", make_cni(front, true))
+			.add_var("back", make_cni(back, true))
+			.add_var("begin", make_cni(begin, true))
+			.add_var("end", make_cni(end, true))
+			.add_var("empty", make_cni(empty, true))
+			.add_var("size", make_cni(size, true))
+			.add_var("clear", make_cni(clear, true))
+			.add_var("insert", make_cni(insert, true))
+			.add_var("erase", make_cni(erase, true))
+			.add_var("push_front", make_cni(push_front, true))
+			.add_var("pop_front", make_cni(pop_front, true))
+			.add_var("push_back", make_cni(push_back, true))
+			.add_var("pop_back", make_cni(pop_back, true))
+			.add_var("remove", make_cni(remove, true))
+			.add_var("reverse", make_cni(reverse, true))
+			.add_var("unique", make_cni(unique, true))
+			.add_var("sort", make_cni(sort, true))
+			.add_var("sort_with", make_cni(sort_with))
+			.add_var("sort_by", make_cni(sort_by))
+			.add_var("to_array", make_cni(to_array, true))
+			.add_var("view", make_cni(view))
+			.add_var("iterate", make_cni(iterator_cs_ext::iterate));
+		}
+	}
+	namespace math_cs_ext {
+		using namespace cs;
+
+		number abs(number n)
+		{
+			return std::abs(n);
+		}
+
+		number ln(number n)
+		{
+			return std::log(n);
+		}
+
+		number log10(number n)
+		{
+			return std::log10(n);
+		}
+
+		number log(number a, number b)
+		{
+			return std::log(b / a);
+		}
+
+		number sin(number n)
+		{
+			return std::sin(n);
+		}
+
+		number cos(number n)
+		{
+			return std::cos(n);
+		}
+
+		number tan(number n)
+		{
+			return std::tan(n);
+		}
+
+		number asin(number n)
+		{
+			return std::asin(n);
+		}
+
+		number acos(number n)
+		{
+			return std::acos(n);
+		}
+
+		number atan(number n)
+		{
+			return std::atan(n);
+		}
+
+		number sqrt(number n)
+		{
+			return std::sqrt(n);
+		}
+
+		number root(number a, number b)
+		{
+			return std::pow(a, number(1) / b);
+		}
+
+		number pow(number a, number b)
+		{
+			return std::pow(a, b);
+		}
+
+		number _min(number a, number b)
+		{
+			return (std::min)(a, b);
+		}
+
+		number _max(number a, number b)
+		{
+			return (std::max)(a, b);
+		}
+
+		number rand(number b, number e)
+		{
+			return cov::rand<number>(b, e);
+		}
+
+		number randint(number b, number e)
+		{
+			return cov::rand<long>(b, e);
+		}
+
+		void seed(number value)
+		{
+			cov::seed_rand(static_cast<std::uint64_t>(static_cast<long long>(value)));
+		}
+
+		// Fills the array with one distribution, instead of a call into the script per number
+		template<typename T>
+		array make_rand_array(number count, T dist)
+		{
+			if (count < 0)
+				throw lang_error("Count of numbers can not be negative.");
+			auto &engine = cov::random::random_engine();
+			array arr;
+			for (std::size_t i = 0, n = count; i < n; ++i)
+				arr.push_back(var::make<number>(dist(engine)));
+			return std::move(arr);
+		}
+
+		array rand_array(number count, number b, number e)
+		{
+			return make_rand_array(count, std::uniform_real_distribution<number>(b, e));
+		}
+
+		array randint_array(number count, number b, number e)
+		{
+			return make_rand_array(count, std::uniform_int_distribution<long>(b, e));
+		}
+
+// Array kernels
+		/*
+		* Arrays are unboxed into a contiguous buffer, so that the loops can be vectorized by the compiler.
+		* Large inputs are split into blocks of a fixed size and the blocks are shared by several threads,
+		* the partial results are combined in the order of blocks, so the result does not depend on the number of cores.
+		*/
+		constexpr std::size_t block_size = 64 * 1024;
+
+		std::vector<number> unbox(const array &arr)
+		{
+			std::vector<number> data;
+			data.reserve(arr.size());
+			for (auto &it:arr) {
+				if (it.type() != typeid(number))
+					throw lang_error("Array must only contain numbers.");
+				data.push_back(it.const_val<number>());
+			}
+			return std::move(data);
+		}
+
+		array box(const std::vector<number> &data)
+		{
+			array arr;
+			for (auto &it:data)
+				arr.push_back(var::make<number>(it));
+			return std::move(arr);
+		}
+
+		template<typename T>
+		void for_each_block(std::size_t size, T &&func)
+		{
+			std::size_t blocks = (size + block_size - 1) / block_size;
+			std::size_t count = (std::min)(static_cast<std::size_t>((std::min)((std::max)(std::thread::hardware_concurrency(), 1u), 8u)), blocks);
+			std::atomic<std::size_t> next{0};
+			auto work = [&]() {
+				for (std::size_t idx; (idx = next++) < blocks;)
+					func(idx, idx * block_size, (std::min)(size, (idx + 1) * block_size));
+			};
+			std::vector<std::thread> workers;
+			try {
+				for (std::size_t i = 1; i < count; ++i)
+					workers.emplace_back(work);
+			}
+			catch (const std::system_error &) {
+				// The blocks left are run by the calling thread
+			}
+			work();
+			for (auto &it:workers)
+				it.join();
+		}
+
+		template<typename T>
+		array transform(const array &arr, T &&func)
+		{
+			std::vector<number> data = unbox(arr);
+			for_each_block(data.size(), [&data, &func](std::size_t, std::size_t begin, std::size_t end) {
+				for (std::size_t i = begin; i < end; ++i)
+					data[i] = func(data[i]);
+			});
+			return box(data);
+		}
+
+		// Sums func(i) over all indexes
+		template<typename T>
+		number accumulate(std::size_t size, T &&func)
+		{
+			std::vector<number> partial((size + block_size - 1) / block_size, 0);
+			for_each_block(size, [&partial, &func](std::size_t idx, std::size_t begin, std::size_t end) {
+				number sum = 0;
+				for (std::size_t i = begin; i < end; ++i)
+					sum += func(i);
+				partial[idx] = sum;
+			});
+			number sum = 0;
+			for (auto &it:partial)
+				sum += it;
+			return sum;
+		}
+
+		// Index of the first element preferred by func, it must be a strict ordering
+		template<typename T>
+		std::size_t select(const std::vector<number> &data, T &&func)
+		{
+			if (data.empty())
+				throw lang_error("Array is empty.");
+			std::vector<std::size_t> partial((data.size() + block_size - 1) / block_size);
+			for_each_block(data.size(), [&](std::size_t idx, std::size_t begin, std::size_t end) {
+				std::size_t pos = begin;
+				for (std::size_t i = begin + 1; i < end; ++i)
+					if (func(data[i], data[pos]))
+						pos = i;
+				partial[idx] = pos;
+			});
+			std::size_t pos = partial.front();
+			for (auto &it:partial)
+				if (func(data[it], data[pos]))
+					pos = it;
+			return pos;
+		}
+
+		namespace vec {
+			array abs(const array &arr)
+			{
+				return transform(arr, [](number n) {
+					return std::abs(n);
+				});
+			}
+
+			array sin(const array &arr)
+			{
+				return transform(arr, [](number n) {
+					return std::sin(n);
+				});
+			}
+
+			array cos(const array &arr)
+			{
+				return transform(arr, [](number n) {
+					return std::cos(n);
+				});
+			}
+
+			array exp(const array &arr)
+			{
+				return transform(arr, [](number n) {
+					return std::exp(n);
+				});
+			}
+
+			array ln(const array &arr)
+			{
+				return transform(arr, [](number n) {
+					return std::log(n);
+				});
+			}
+
+			array sqrt(const array &arr)
+			{
+				return transform(arr, [](number n) {
+					return std::sqrt(n);
+				});
+			}
+
+			array pow(const array &arr, number e)
+			{
+				return transform(arr, [e](number n) {
+					return std::pow(n, e);
+				});
+			}
+
+			number sum(const array &arr)
+			{
+				std::vector<number> data = unbox(arr);
+				return accumulate(data.size(), [&data](std::size_t i) {
+					return data[i];
+				});
+			}
+
+			number mean(const array &arr)
+			{
+				if (arr.empty())
+					throw lang_error("Array is empty.");
+				return sum(arr) / arr.size();
+			}
+
+			// Population variance, computed in two passes for the accuracy
+			number variance(const array &arr)
+			{
+				if (arr.empty())
+					throw lang_error("Array is empty.");
+				std::vector<number> data = unbox(arr);
+				number avg = accumulate(data.size(), [&data](std::size_t i) {
+					return data[i];
+				}) / data.size();
+				return accumulate(data.size(), [&data, avg](std::size_t i) {
+					return (data[i] - avg) * (data[i] - avg);
+				}) / data.size();
+			}
+
+			number argmin(const array &arr)
+			{
+				return select(unbox(arr), [](number a, number b) {
+					return a < b;
+				});
+			}
+
+			number argmax(const array &arr)
+			{
+				return select(unbox(arr), [](number a, number b) {
+					return a > b;
+				});
+			}
+
+			number min(const array &arr)
+			{
+				return arr[argmin(arr)].const_val<number>();
+			}
+
+			number max(const array &arr)
+			{
+				return arr[argmax(arr)].const_val<number>();
+			}
+
+			number dot(const array &a, const array &b)
+			{
+				if (a.size() != b.size())
+					throw lang_error("Arrays must have the same size.");
+				std::vector<number> x = unbox(a), y = unbox(b);
+				return accumulate(x.size(), [&x, &y](std::size_t i) {
+					return x[i] * y[i];
+				});
+			}
+		}
+
+		void init()
+		{
+			(*math_vector_ext)
+			.add_var("abs", make_cni(vec::abs, true))
+			.add_var("sin", make_cni(vec::sin, true))
+			.add_var("cos", make_cni(vec::cos, true))
+			.add_var("exp", make_cni(vec::exp, true))
+			.add_var("ln", make_cni(vec::ln, true))
+			.add_var("sqrt", make_cni(vec::sqrt, true))
+			.add_var("pow", make_cni(vec::pow, true))
+			.add_var("sum", make_cni(vec::sum, true))
+			.add_var("mean", make_cni(vec::mean, true))
+			.add_var("variance", make_cni(vec::variance, true))
+			.add_var("min", make_cni(vec::min, true))
+			.add_var("max", make_cni(vec::max, true))
+			.add_var("argmin", make_cni(vec::argmin, true))
+			.add_var("argmax", make_cni(vec::argmax, true))
+			.add_var("dot", make_cni(vec::dot, true));
+			(*math_const_ext)
+			.add_var("max", var::make_constant<number>((std::numeric_limits<number>::max)()))
+			.add_var("min", var::make_constant<number>((std::numeric_limits<number>::min)()))
+			.add_var("inf", var::make_constant<number>(std::numeric_limits<number>::infinity()))
+			.add_var("nan", var::make_constant<number>(std::numeric_limits<number>::quiet_NaN()))
+			.add_var("pi", var::make_constant<number>(std::asin(number(1)) * 2))
+			.add_var("e", var::make_constant<number>(std::exp(number(1))));
+			(*math_ext)
+			.add_var("constants", make_namespace(math_const_ext))
+			.add_var("vector", make_namespace(math_vector_ext))
+			.add_var("abs", make_cni(abs, true))
+			.add_var("ln", make_cni(ln, true))
+			.add_var("log10", make_cni(log10, true))
+			.add_var("log", make_cni(log, true))
+			.add_var("sin", make_cni(sin, true))
+			.add_var("cos", make_cni(cos, true))
+			.add_var("tan", make_cni(tan, true))
+			.add_var("asin", make_cni(asin, true))
+			.add_var("acos", make_cni(acos, true))
+			.add_var("atan", make_cni(atan, true))
+			.add_var("sqrt", make_cni(sqrt, true))
+			.add_var("root", make_cni(root, true))
+			.add_var("pow", make_cni(pow, true))
+			.add_var("min", make_cni(_min, true))
+			.add_var("max", make_cni(_max, true))
+			.add_var("rand", make_cni(rand))
+			.add_var("randint", make_cni(randint))
+			.add_var("seed", make_cni(seed))
+			.add_var("rand_array", make_cni(rand_array))
+			.add_var("randint_array", make_cni(randint_array));
+		}
+	}
+	namespace pair_cs_ext {
+		using namespace cs;
+
+		var first(const pair &p)
+		{
+			return p.first;
+		}
+
+		var second(const pair &p)
+		{
+			return p.second;
+		}
+
+		void init()
+		{
+			(*pair_ext)
+			.add_var("first", make_cni(first, true))
+			.add_var("second", make_cni(second, true));
+		}
+	}
+	namespace runtime_cs_ext {
+		using namespace cs;
+
+		string get_import_path()
+		{
+			return current_process->import_path;
+		}
+
+		void info()
+		{
+			std::cout << "Covariant Script Programming Language Interpreter\nVersion: " << current_process->version
+			          << "\n"
+			          "Copyright (C) 2019 Michael Lee. All rights reserved.\n"
+			          "Licensed under the Covariant Innovation General Public License,\n"
+			          "Version 1.0 (the \"License\");\n"
+			          "you may not use this file except in compliance with the License.\n"
+			          "You may obtain a copy of the License at\n"
+			          "\nhttps://covariant.cn/licenses/LICENSE-1.0\n"
+			          "Unless required by applicable law or agreed to in writing, software\n"
+			          "distributed under the License is distributed on an \"AS IS\" BASIS,\n"
+			          "WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.\n"
+			          "See the License for the specific language governing permissions and\n"
+			          "limitations under the License.\n"
+			          "Please visit http://covscript.org for more information."
+			          << std::endl;
+		}
+
+		number time()
+		{
+			return cov::timer::time(cov::timer::time_unit::milli_sec);
+		}
+
+		void delay(number time)
+		{
+			cov::timer::delay(cov::timer::time_unit::milli_sec, time);
+		}
+
+		var exception(const string &str)
+		{
+			return var::make<lang_error>(str);
+		}
+
+		std::size_t hash(const var &val)
+		{
+			return val.hash();
+		}
+
+		var build(const context_t &context, const string &expr)
+		{
+			std::deque<char> buff;
+			expression_t tree;
+			for (auto &ch:expr)
+				buff.push_back(ch);
+			context->compiler->build_expr(buff, tree);
+			return var::make<expression_t>(tree);
+		}
+
+		var solve(const context_t &context, expression_t &tree)
+		{
+			return context->instance->parse_expr(tree.root());
+		}
+
+		var cmd_args(const context_t &context)
+		{
+			return context->cmd_args;
+		}
+
+		var import(const context_t &context, const string &dir, const string &name)
+		{
+			return make_namespace(context->instance->import(dir, name));
+		}
+
+		var source_import(const context_t &context, const string &path)
+		{
+			return make_namespace(context->instance->source_import(path));
+		}
+
+		number argument_count(const var &func)
+		{
+			if (func.type() == typeid(object_method)) {
+				const callable::function_type &target = func.const_val<object_method>().callable.const_val<callable>().get_raw_data();
+				if (target.target_type() == typeid(function))
+					return target.target<function>()->argument_count() - 1;
+				else
+					return target.target<cni>()->argument_count() - 1;
+			}
+			else if (func.type() == typeid(callable)) {
+				const callable::function_type &target = func.const_val<callable>().get_raw_data();
+				if (target.target_type() == typeid(function))
+					return target.target<function>()->argument_count();
+				else
+					return target.target<cni>()->argument_count();
+			}
+			else
+				throw lang_error("Not a function.");
+		}
+
+		void init()
+		{
+			(*runtime_ext)
+			.add_var("std_version", var::make_constant<number>(current_process->std_version))
+			.add_var("event", make_namespace(event_ext))
+			.add_var("get_import_path", make_cni(get_import_path, true))
+			.add_var("info", make_cni(info))
+			.add_var("time", make_cni(time))
+			.add_var("delay", make_cni(delay))
+			.add_var("exception", make_cni(exception))
+			.add_var("hash", make_cni(hash, true))
+			.add_var("build", make_cni(build))
+			.add_var("solve", make_cni(solve))
+			.add_var("cmd_args", make_cni(cmd_args, true))
+			.add_var("import", make_cni(import, true))
+			.add_var("source_import", make_cni(source_import, true))
+			.add_var("argument_count", make_cni(argument_count, true));
+			(*context_ext)
+			.add_var("build", make_cni(build))
+			.add_var("solve", make_cni(solve))
+			.add_var("cmd_args", make_cni(cmd_args, true))
+			.add_var("import", make_cni(import, true))
+			.add_var("source_import", make_cni(source_import, true));
+		}
+	}
+	namespace string_cs_ext {
+		using namespace cs;
+		using namespace cs_impl;
+
+		string append(string &str, const var &val)
+		{
+			str.append(val.to_string());
+			return str;
+		}
+
+		string insert(string &str, number posit, const var &val)
+		{
+			str.insert(posit, val.to_string());
+			return str;
+		}
+
+		string erase(string &str, number b, number e)
+		{
+			str.erase(b, e);
+			return str;
+		}
+
+		string replace(string &str, number posit, number count, const var &val)
+		{
+			str.replace(posit, count, val.to_string());
+			return str;
+		}
+
+		string substr(string &str, number b, number e)
+		{
+			return str.substr(b, e);
+		}
+
+		number find(string &str, const string &s, number posit)
+		{
+			std::size_t begin = posit;
+			if (begin > str.size())
+				return -1;
+			std::size_t pos = text::find(str.data() + begin, str.size() - begin, s.data(), s.size());
+			if (pos == text::npos)
+				return -1;
+			else
+				return begin + pos;
+		}
+
+		number rfind(string &str, const string &s, number posit)
+		{
+			std::size_t pos = 0;
+			if (posit == -1)
+				pos = str.rfind(s, std::string::npos);
+			else
+				pos = str.rfind(s, posit);
+			if (pos == std::string::npos)
+				return -1;
+			else
+				return pos;
+		}
+
+		string cut(string &str, number n)
+		{
+			for (std::size_t i = 0; i < n; ++i)
+				str.pop_back();
+			return str;
+		}
+
+		bool empty(const string &str)
+		{
+			return str.empty();
+		}
+
+		void clear(string &str)
+		{
+			str.clear();
+		}
+
+		number size(const string &str)
+		{
+			return str.size();
+		}
+
+		string tolower(const string &str)
+		{
+			string s(str);
+			text::to_lower(&s[0], s.size());
+			return std::move(s);
+		}
+
+		string toupper(const string &str)
+		{
+			string s(str);
+			text::to_upper(&s[0], s.size());
+			return std::move(s);
+		}
+
+		number to_number(const string &str)
+		{
+			return parse_number(str);
+		}
+
+		number capacity(const string &str)
+		{
+			return str.capacity();
+		}
+
+		void reserve(string &str, number count)
+		{
+			if (count < 0)
+				throw lang_error("Reserve a negative size.");
+			str.reserve(count);
+		}
+
+		void shrink_to_fit(string &str)
+		{
+			str.shrink_to_fit();
+		}
+
+		var with_capacity(number count)
+		{
+			var str = var::make<string>();
+			reserve(str.val<string>(), count);
+			// A copy would lose the capacity, so the result is an rvalue and the function is never folded as a constant
+			return rvalue(str);
+		}
+
+		array split(const string &str, const array &signals)
+		{
+			text::char_set delims;
+			for (auto &sig:signals)
+				delims.add(sig.const_val<char>());
+			array arr;
+			const char *data = str.data();
+			std::size_t begin = 0;
+			text::for_each_of(data, str.size(), delims, [&](std::size_t end) {
+				// Adjacent delimiters do not produce empty parts
+				if (end > begin)
+					arr.push_back(var::make<string>(data + begin, end - begin));
+				begin = end + 1;
+			});
+			if (begin < str.size())
+				arr.push_back(var::make<string>(data + begin, str.size() - begin));
+			return std::move(arr);
+		}
+
+		string replace_all(string &str, const string &from, const var &val)
+		{
+			if (from.empty())
+				throw lang_error("Replace an empty string.");
+			string to = val.to_string();
+			string result;
+			std::size_t begin = 0;
+			for (std::size_t pos; (pos = text::find(str.data() + begin, str.size() - begin, from.data(), from.size())) !=
+			        text::npos; begin += pos + from.size()) {
+				// Sized for the common case that the result is about as long as the source
+				if (begin == 0)
+					result.reserve(str.size());
+				result.append(str, begin, pos);
+				result.append(to);
+			}
+			if (begin == 0)
+				return str;
+			result.append(str, begin, string::npos);
+			str.swap(result);
+			return str;
+		}
+
+		void init()
+		{
+			(*string_ext)
+			.add_var("append", make_cni(append, true))
+			.add_var("insert", make_cni(insert, true))
+			.add_var("erase", make_cni(erase, true))
+			.add_var("replace", make_cni(replace, true))
+			.add_var("replace_all", make_cni(replace_all, true))
+			.add_var("substr", make_cni(substr, true))
+			.add_var("find", make_cni(find, true))
+			.add_var("rfind", make_cni(rfind, true))
+			.add_var("cut", make_cni(cut, true))
+			.add_var("empty", make_cni(empty, true))
+			.add_var("clear", make_cni(clear, true))
+			.add_var("size", make_cni(size, true))
+			.add_var("tolower", make_cni(tolower, true))
+			.add_var("toupper", make_cni(toupper, true))
+			.add_var("to_number", make_cni(to_number, true))
+			.add_var("split", make_cni(split, true))
+			.add_var("capacity", make_cni(capacity, true))
+			.add_var("reserve", make_cni(reserve, true))
+			.add_var("shrink_to_fit", make_cni(shrink_to_fit, true))
+			.add_var("with_capacity", make_cni(with_capacity))
+			.add_var("iterate", make_cni(iterator_cs_ext::iterate));
+		}
+	}
+	namespace console_cs_ext {
+		using namespace cs;
+		using namespace cs_impl;
+
+		number terminal_width()
+		{
+			return conio::terminal_width();
+		}
+
+		number terminal_height()
+		{
+			return conio::terminal_height();
+		}
+
+		void gotoxy(number x, number y)
+		{
+			conio::gotoxy(x, y);
+		}
+
+		void echo(bool v)
+		{
+			conio::echo(v);
+		}
+
+		void clrscr()
+		{
+			conio::clrscr();
+		}
+
+		char getch()
+		{
+			return conio::getch();
+		}
+
+		bool kbhit()
+		{
+			return conio::kbhit();
+		}
+
+		void init()
+		{
+			(*console_ext)
+			.add_var("terminal_width", make_cni(terminal_width))
+			.add_var("terminal_height", make_cni(terminal_height))
+			.add_var("gotoxy", make_cni(gotoxy))
+			.add_var("echo", make_cni(echo))
+			.add_var("clrscr", make_cni(clrscr))
+			.add_var("getch", make_cni(getch))
+			.add_var("kbhit", make_cni(kbhit));
+		}
+	}
+
+	namespace file_cs_ext {
+		using namespace cs;
+		using namespace cs_impl;
+
+		bool copy(const string &source, const string &dest)
+		{
+			return fileio::copy(source, dest);
+		}
+
+		bool remove(const string &path)
+		{
+			return std::remove(path.c_str()) == 0;
+		}
+
+		bool exists(const string &path)
+		{
+			return fileio::exists(path);
+		}
+
+		fileio::file_stat stat(const string &path)
+		{
+			fileio::file_stat info;
+			if (!fileio::stat(path, info))
+				throw lang_error("File \"" + path + "\" does not exist.");
+			return info;
+		}
+
+		number size(const string &path)
+		{
+			return stat(path).size;
+		}
+
+		number mtime(const string &path)
+		{
+			return stat(path).mtime;
+		}
+
+		string read_all(const string &path)
+		{
+			std::ifstream in(path, std::ios_base::in | std::ios_base::binary);
+			if (!in)
+				throw lang_error("Can not open file \"" + path + "\".");
+			string str;
+			if (in.seekg(0, std::ios_base::end)) {
+				std::streampos size = in.tellg();
+				in.seekg(0, std::ios_base::beg);
+				if (size > 0)
+					str.resize(static_cast<std::size_t>(size));
+				in.read(&str[0], str.size());
+				str.resize(in.gcount());
+			}
+			// Files without a known size, such as the ones under /proc
+			if (in.clear(), in.peek() != std::char_traits<char>::eof()) {
+				std::ostringstream buff;
+				buff << in.rdbuf();
+				str += buff.str();
+			}
+			return std::move(str);
+		}
+
+		bool write_all(const string &path, const string &str)
+		{
+			return fileio::write_atomic(path, str.data(), str.size());
+		}
+
+		bool rename(const string &source, const string &dest)
+		{
+			return std::rename(source.c_str(), dest.c_str()) == 0;
+		}
+
+		var map(const string &path)
+		{
+			auto mapping = std::make_shared<file_mapping>();
+			if (!mapping->open(path))
+				throw lang_error("Can not map file \"" + path + "\".");
+			const std::uint8_t *data = mapping->data();
+			std::size_t size = mapping->size();
+			return var::make<mapped_file>(std::move(mapping), data, size);
+		}
+
+		void init()
+		{
+			(*file_ext)
+			.add_var("copy", make_cni(copy))
+			.add_var("remove", make_cni(remove))
+			.add_var("exists", make_cni(exists))
+			.add_var("rename", make_cni(rename))
+			.add_var("size", make_cni(size))
+			.add_var("mtime", make_cni(mtime))
+			.add_var("read_all", make_cni(read_all))
+			.add_var("write_all", make_cni(write_all))
+			.add_var("map", make_cni(map));
+		}
+	}
+
+	namespace mapped_file_cs_ext {
+		using namespace cs;
+		using namespace byte_buffer_cs_ext;
+		using file_cs_ext::mapped_file;
+
+// Element access
+		number at(const mapped_file &file, number posit)
+		{
+			check_range(file.size, posit, 1);
+			return file.data[static_cast<std::size_t>(posit)];
+		}
+
+		number get_uint(const mapped_file &file, number posit, number width, byte_order order)
+		{
+			return load_uint(file.data, file.size, posit, width, order);
+		}
+
+		number get_int(const mapped_file &file, number posit, number width, byte_order order)
+		{
+			return load_int(file.data, file.size, posit, width, order);
+		}
+
+		number get_float(const mapped_file &file, number posit, byte_order order)
+		{
+			return load_float(file.data, file.size, posit, order);
+		}
+
+		number get_double(const mapped_file &file, number posit, byte_order order)
+		{
+			return load_double(file.data, file.size, posit, order);
+		}
+
+		number size(const mapped_file &file)
+		{
+			return file.size;
+		}
+
+// Conversions
+		var slice(const mapped_file &file, number posit, number count)
+		{
+			if (count < 0)
+				throw lang_error("Out of range.");
+			check_range(file.size, posit, count);
+			return var::make<mapped_file>(file.mapping, file.data + static_cast<std::size_t>(posit), count);
+		}
+
+		byte_buffer to_buffer(const mapped_file &file)
+		{
+			return byte_buffer(file.data, file.data + file.size);
+		}
+
+		string to_string(const mapped_file &file)
+		{
+			return string(reinterpret_cast<const char *>(file.data), file.size);
+		}
+
+		void init()
+		{
+			(*mapped_file_ext)
+			.add_var("at", make_cni(at, true))
+			.add_var("get_uint", make_cni(get_uint, true))
+			.add_var("get_int", make_cni(get_int, true))
+			.add_var("get_float", make_cni(get_float, true))
+			.add_var("get_double", make_cni(get_double, true))
+			.add_var("size", make_cni(size, true))
+			.add_var("slice", make_cni(slice, true))
+			.add_var("to_buffer", make_cni(to_buffer, true))
+			.add_var("to_string", make_cni(to_string, true));
+		}
+	}
+
+	namespace path_cs_ext {
+		using namespace cs;
+		using namespace cs_impl;
+
+		string name(const path_info &info)
+		{
+			return info.name;
+		}
+
+		int type(const path_info &info)
+		{
+			return info.type;
+		}
+
+		array scan(const string &path)
+		{
+			DIR *dir = ::opendir(path.c_str());
+			if (dir == nullptr)
+				throw cs::lang_error("Path does not exist.");
+			array
+			entries;
+			for (dirent *dp = ::readdir(dir); dp != nullptr; dp = ::readdir(dir))
+				entries.push_back(var::make<path_info>(dp->d_name, dp->d_type));
+			::closedir(dir);
+			return std::move(entries);
+		}
+
+// Walker
+		string entry_path(const path_entry &entry)
+		{
+			return entry.path;
+		}
+
+		string entry_name(const path_entry &entry)
+		{
+			return entry.name;
+		}
+
+		int entry_type(const path_entry &entry)
+		{
+			return entry.type;
+		}
+
+		number entry_size(const path_entry &entry)
+		{
+			return entry.size;
+		}
+
+		number entry_mtime(const path_entry &entry)
+		{
+			return entry.mtime;
+		}
+
+		// Supports "*", "?" and character classes like "[a-z]" or "[!0-9]"
+		bool glob_match(const char *pattern, const char *str)
+		{
+			const char *star = nullptr, *retry = nullptr;
+			while (*str != '\0') {
+				if (*pattern == '*') {
+					star = ++pattern;
+					retry = str;
+					continue;
+				}
+				bool matched = false;
+				const char *next = pattern + 1;
+				if (*pattern == '?')
+					matched = true;
+				else if (*pattern == '[') {
+					const char *it = pattern + 1;
+					bool negate = *it == '!';
+					if (negate)
+						++it;
+					bool found = false;
+					for (const char *begin = it; *it != '\0' && (*it != ']' || it == begin); ++it) {
+						if (it[1] == '-' && it[2] != ']' && it[2] != '\0') {
+							found = found || (*it <= *str && *str <= it[2]);
+							it += 2;
+						}
+						else
+							found = found || *it == *str;
+					}
+					// Unterminated class is compared literally
+					if (*it == ']') {
+						matched = found != negate;
+						next = it + 1;
+					}
+					else
+						matched = *pattern == *str;
+				}
+				else
+					matched = *pattern != '\0' && *pattern == *str;
+				if (matched) {
+					pattern = next;
+					++str;
+				}
+				else if (star != nullptr) {
+					pattern = star;
+					str = ++retry;
+				}
+				else
+					return false;
+			}
+			while (*pattern == '*')
+				++pattern;
+			return *pattern == '\0';
+		}
+
+		class path_filter final {
+			string m_glob;
+			std::vector<string> m_exts;
+		public:
+			explicit path_filter(const var &filter)
+			{
+				if (filter.type() == typeid(string))
+					m_glob = filter.const_val<string>();
+				else if (filter.type() == typeid(array)) {
+					for (auto &it:filter.const_val<array>()) {
+						if (it.type() != typeid(string))
+							throw lang_error("Extension must be a string.");
+						const string &ext = it.const_val<string>();
+						m_exts.push_back(!ext.empty() && ext[0] == '.' ? ext : '.' + ext);
+					}
+				}
+				else
+					throw lang_error("Filter must be a glob pattern or an array of extensions.");
+			}
+
+			bool match(const string &name) const
+			{
+				if (!m_exts.empty()) {
+					for (auto &ext:m_exts)
+						if (name.size() > ext.size() && name.compare(name.size() - ext.size(), ext.size(), ext) == 0)
+							return true;
+					return false;
+				}
+				return m_glob.empty() || glob_match(m_glob.c_str(), name.c_str());
+			}
+		};
+
+		/*
+		* Walks the directory tree with a pool of worker threads.
+		* The workers share a queue of directories and stop when the entry queue is full,
+		* so the memory used is bounded no matter how large the tree is.
+		* Entries are yielded in no particular order and symbolic links are not followed.
+		*/
+		class path_walker final : public iterator_base {
+			static constexpr std::size_t queue_limit = 4096;
+			static constexpr std::size_t batch_size = 64;
+			path_filter m_filter;
+			std::mutex m_lock;
+			std::condition_variable m_has_dir, m_has_entry, m_has_room;
+			std::deque<string> m_dirs;
+			std::deque<path_entry> m_entries;
+			std::size_t m_busy = 0;
+			std::atomic<bool> m_stop{false};
+			std::vector<std::thread> m_workers;
+
+			bool finished() const
+			{
+				return m_dirs.empty() && m_busy == 0;
+			}
+
+			void flush(std::vector<path_entry> &batch)
+			{
+				std::unique_lock<std::mutex> lock(m_lock);
+				m_has_room.wait(lock, [this] { return m_stop || m_entries.size() < queue_limit; });
+				for (auto &it:batch)
+					m_entries.push_back(std::move(it));
+				batch.clear();
+				m_has_entry.notify_one();
+			}
+
+			void scan(const string &path)
+			{
+				DIR *dir = ::opendir(path.c_str());
+				// Directories can not be opened are skipped
+				if (dir == nullptr)
+					return;
+				std::vector<path_entry> batch;
+				std::vector<string> subdirs;
+				string prefix = path;
+				if (prefix.empty() || prefix.back() != path_separator)
+					prefix += path_separator;
+				for (dirent *dp = ::readdir(dir); dp != nullptr && !m_stop; dp = ::readdir(dir)) {
+					if (std::strcmp(dp->d_name, ".") == 0 || std::strcmp(dp->d_name, "..") == 0)
+						continue;
+					path_entry entry;
+					entry.name = dp->d_name;
+					entry.path = prefix + entry.name;
+					entry.type = dp->d_type;
+					fileio::file_stat info;
+					if (fileio::stat(entry.path, info, false)) {
+						if (entry.type == DT_UNKNOWN)
+							entry.type = info.symlink ? DT_LNK : (info.directory ? DT_DIR : DT_REG);
+						// Symbolic links report the size and time of their targets
+						if (!info.symlink || fileio::stat(entry.path, info)) {
+							entry.size = info.size;
+							entry.mtime = info.mtime;
+						}
+					}
+					if (entry.type == DT_DIR)
+						subdirs.push_back(entry.path);
+					if (m_filter.match(entry.name)) {
+						batch.push_back(std::move(entry));
+						if (batch.size() >= batch_size)
+							flush(batch);
+					}
+				}
+				::closedir(dir);
+				if (!batch.empty())
+					flush(batch);
+				if (!subdirs.empty()) {
+					std::lock_guard<std::mutex> lock(m_lock);
+					for (auto &it:subdirs)
+						m_dirs.push_back(std::move(it));
+					m_has_dir.notify_all();
+				}
+			}
+
+			void work()
+			{
+				std::unique_lock<std::mutex> lock(m_lock);
+				while (true) {
+					m_has_dir.wait(lock, [this] { return m_stop || !m_dirs.empty() || m_busy == 0; });
+					if (m_stop || m_dirs.empty())
+						return;
+					string path = std::move(m_dirs.front());
+					m_dirs.pop_front();
+					++m_busy;
+					lock.unlock();
+					scan(path);
+					lock.lock();
+					--m_busy;
+					if (finished()) {
+						m_has_dir.notify_all();
+						m_has_entry.notify_all();
+					}
+				}
+			}
+
+			void stop()
+			{
+				{
+					std::lock_guard<std::mutex> lock(m_lock);
+					m_stop = true;
+				}
+				m_has_dir.notify_all();
+				m_has_room.notify_all();
+				for (auto &it:m_workers)
+					it.join();
+			}
+
+		public:
+			path_walker(const string &root, const var &filter) : m_filter(filter)
+			{
+				fileio::file_stat info;
+				if (!fileio::stat(root, info) || !info.directory)
+					throw lang_error("Path does not exist.");
+				m_dirs.push_back(root);
+				std::size_t count = (std::min)((std::max)(std::thread::hardware_concurrency(), 1u), 8u);
+				try {
+					for (std::size_t i = 0; i < count; ++i)
+						m_workers.emplace_back(&path_walker::work, this);
+				}
+				catch (...) {
+					stop();
+					throw;
+				}
+			}
+
+			~path_walker() override
+			{
+				stop();
+			}
+
+			bool next(var &val) override
+			{
+				std::unique_lock<std::mutex> lock(m_lock);
+				m_has_entry.wait(lock, [this] { return !m_entries.empty() || finished(); });
+				if (m_entries.empty())
+					return false;
+				path_entry entry = std::move(m_entries.front());
+				m_entries.pop_front();
+				lock.unlock();
+				m_has_room.notify_one();
+				val = var::make<path_entry>(std::move(entry));
+				return true;
+			}
+		};
+
+		iterator_t walk(const string &root, const var &filter)
+		{
+			return std::make_shared<path_walker>(root, filter);
+		}
+
+		void init()
+		{
+			(*path_type_ext)
+			.add_var("unknown", var::make_constant<int>(DT_UNKNOWN))
+			.add_var("fifo", var::make_constant<int>(DT_FIFO))
+			.add_var("sock", var::make_constant<int>(DT_SOCK))
+			.add_var("chr", var::make_constant<int>(DT_CHR))
+			.add_var("dir", var::make_constant<int>(DT_DIR))
+			.add_var("blk", var::make_constant<int>(DT_BLK))
+			.add_var("reg", var::make_constant<int>(DT_REG))
+			.add_var("lnk", var::make_constant<int>(DT_LNK));
+			(*path_info_ext)
+			.add_var("name", make_cni(name))
+			.add_var("type", make_cni(type));
+			(*path_entry_ext)
+			.add_var("path", make_cni(entry_path))
+			.add_var("name", make_cni(entry_name))
+			.add_var("type", make_cni(entry_type))
+			.add_var("size", make_cni(entry_size))
+			.add_var("mtime", make_cni(entry_mtime));
+			(*path_ext)
+			.add_var("type", make_namespace(path_type_ext))
+			.add_var("info", make_namespace(path_info_ext))
+			.add_var("entry", make_namespace(path_entry_ext))
+			.add_var("separator", var::make_constant<char>(path_separator))
+			.add_var("delimiter", var::make_constant<char>(path_delimiter))
+			.add_var("scan", make_cni(scan))
+			.add_var("walk", make_cni(walk));
+		}
+	}
+	namespace process_cs_ext {
+		using namespace cs;
+		using subprocess::child_process;
+
+		std::vector<std::string> make_args(const array &arr)
+		{
+			std::vector<std::string> args;
+			for (auto &it:arr)
+				args.push_back(it.to_string());
+			return args;
+		}
+
+		process_t spawn(const array &args)
+		{
+			process_t process = std::make_shared<child_process>();
+			try {
+				process->spawn(make_args(args));
+			}
+			catch (const std::runtime_error &e) {
+				throw lang_error(std::string("Can not spawn process: ") + e.what());
+			}
+			return process;
+		}
+
+		array run_all(const array &commands, number limit)
+		{
+			if (limit < 1)
+				throw lang_error("Limit of concurrency must be positive.");
+			std::vector<std::vector<std::string>> args;
+			for (auto &it:commands) {
+				if (it.type() != typeid(array))
+					throw lang_error("Command must be an array of arguments.");
+				args.push_back(make_args(it.const_val<array>()));
+			}
+			array results;
+			for (auto &it:subprocess::run_all(args, limit)) {
+				hash_map result;
+				result.emplace(var::make<string>("exit_code"), var::make<number>(it.exit_code));
+				result.emplace(var::make<string>("output"), var::make<string>(std::move(it.output)));
+				result.emplace(var::make<string>("error"), var::make<string>(std::move(it.error)));
+				results.push_back(var::make<hash_map>(std::move(result)));
+			}
+			return std::move(results);
+		}
+
+		number id(const process_t &process)
+		{
+			return process->id();
+		}
+
+// Pipes
+		ostream input(const process_t &process)
+		{
+			return process->input();
+		}
+
+		istream output(const process_t &process)
+		{
+			return process->output();
+		}
+
+		istream error(const process_t &process)
+		{
+			return process->error();
+		}
+
+		void close_input(const process_t &process)
+		{
+			process->close_input();
+		}
+
+// State
+		bool poll(const process_t &process)
+		{
+			return process->poll();
+		}
+
+		number wait(const process_t &process)
+		{
+			return process->wait();
+		}
+
+		var exit_code(const process_t &process)
+		{
+			if (process->poll())
+				return var::make<number>(process->exit_code());
+			else
+				return null_pointer;
+		}
+
+		void terminate(const process_t &process)
+		{
+			process->terminate();
+		}
+
+		void kill(const process_t &process)
+		{
+			process->kill();
+		}
+
+		void init()
+		{
+			(*process_ext)
+			.add_var("id", make_cni(id))
+			.add_var("input", make_cni(input))
+			.add_var("output", make_cni(output))
+			.add_var("error", make_cni(error))
+			.add_var("close_input", make_cni(close_input))
+			.add_var("poll", make_cni(poll))
+			.add_var("wait", make_cni(wait))
+			.add_var("exit_code", make_cni(exit_code))
+			.add_var("terminate", make_cni(terminate))
+			.add_var("kill", make_cni(kill));
+		}
+	}
+
+	namespace event_cs_ext {
+		using namespace cs;
+		using event::socket_t;
+
+		class connection final {
+			friend class event_loop;
+
+			enum class kinds {
+				listener, stream, pipe
+			};
+
+			std::weak_ptr<event_loop> m_loop;
+			socket_t m_handle;
+			kinds m_kind;
+			int m_events = event::readable;
+			bool m_connecting = false, m_closing = false, m_closed = false;
+			std::string m_buff, m_error;
+			std::size_t m_buff_pos = 0;
+			var m_on_accept, m_on_connect, m_on_data, m_on_close;
+		public:
+			connection(std::weak_ptr<event_loop> loop, socket_t handle, kinds kind) : m_loop(std::move(loop)),
+				m_handle(handle), m_kind(kind) {}
+
+			connection(const connection &) = delete;
+
+			~connection()
+			{
+				if (!m_closed)
+					event::close_socket(m_handle);
+			}
+
+			void on_data(const var &func)
+			{
+				m_on_data = func;
+			}
+
+			void on_close(const var &func)
+			{
+				m_on_close = func;
+			}
+
+			bool is_open() const
+			{
+				return !m_closed && !m_closing;
+			}
+
+			const std::string &error() const
+			{
+				return m_error;
+			}
+
+			int port() const
+			{
+				return m_kind == kinds::pipe ? -1 : event::local_port(m_handle);
+			}
+
+			void write(const std::string &str);
+
+			void close();
+		};
+
+		/*
+		* Single threaded event loop, all of the callbacks are invoked in run().
+		* Sockets are level triggered, so a callback only has to handle the data it gets.
+		* Writes are buffered and sent when the socket becomes writable.
+		*/
+		class event_loop final : public std::enable_shared_from_this<event_loop> {
+			friend class connection;
+
+			using clock_type = std::chrono::steady_clock;
+			using timer_queue = std::priority_queue<std::pair<clock_type::time_point, std::size_t>,
+			      std::vector<std::pair<clock_type::time_point, std::size_t>>,
+			      std::greater<std::pair<clock_type::time_point, std::size_t>>>;
+
+			struct timer_type final {
+				var func;
+				clock_type::duration interval;
+				bool repeat;
+			};
+
+			event::poller m_poller;
+			std::unordered_map<socket_t, connection_t> m_conns;
+			std::unordered_map<std::size_t, timer_type> m_timers;
+			timer_queue m_queue;
+			std::size_t m_timer_id = 0;
+			std::vector<event::ready_event> m_ready;
+			// Listeners failed to accept, they are watched again after the time
+			std::vector<std::pair<clock_type::time_point, connection_t>> m_paused;
+			bool m_stop = false;
+
+			connection_t attach(socket_t handle, connection::kinds kind, int events)
+			{
+				connection_t conn = std::make_shared<connection>(shared_from_this(), handle, kind);
+				conn->m_events = events;
+				if (!m_poller.add(handle, events)) {
+					std::string error = event::last_error();
+					event::close_socket(handle);
+					conn->m_closed = true;
+					throw lang_error(error);
+				}
+				m_conns.emplace(handle, conn);
+				return conn;
+			}
+
+			void update(connection &conn, int events)
+			{
+				if (conn.m_events != events) {
+					conn.m_events = events;
+					m_poller.modify(conn.m_handle, events);
+				}
+			}
+
+			void close(connection &conn)
+			{
+				if (conn.m_closed)
+					return;
+				conn.m_closed = true;
+				m_poller.remove(conn.m_handle);
+				event::close_socket(conn.m_handle);
+				auto it = m_conns.find(conn.m_handle);
+				if (it == m_conns.end())
+					return;
+				// The connection must outlive the callback
+				connection_t holder = it->second;
+				m_conns.erase(it);
+				if (conn.m_on_close.usable())
+					invoke(conn.m_on_close, var::make<connection_t>(holder));
+			}
+
+			void flush(connection &conn)
+			{
+				while (conn.m_buff_pos < conn.m_buff.size()) {
+					long count = event::write_some(conn.m_handle, conn.m_buff.data() + conn.m_buff_pos,
+					                               conn.m_buff.size() - conn.m_buff_pos);
+					if (count < 0) {
+						if (!event::would_block()) {
+							conn.m_error = event::last_error();
+							close(conn);
+							return;
+						}
+						break;
+					}
+					conn.m_buff_pos += count;
+				}
+				if (conn.m_buff_pos == conn.m_buff.size()) {
+					conn.m_buff.clear();
+					conn.m_buff_pos = 0;
+					if (conn.m_closing)
+						close(conn);
+					else
+						update(conn, event::readable);
+				}
+				else
+					update(conn, event::readable | event::writable);
+			}
+
+			void accept(const connection_t &listener)
+			{
+				// Paused, but errors are still reported
+				if (listener->m_events == 0)
+					return;
+				while (!listener->m_closed) {
+					socket_t handle = event::tcp_accept(listener->m_handle);
+					if (handle == event::invalid_socket) {
+						// Such as running out of descriptors, the listener stays readable so it is paused instead of spinning
+						if (!event::would_block()) {
+							listener->m_error = event::last_error();
+							update(*listener, 0);
+							m_paused.emplace_back(clock_type::now() + std::chrono::milliseconds(100), listener);
+						}
+						return;
+					}
+					connection_t conn = attach(handle, connection::kinds::stream, event::readable);
+					invoke(listener->m_on_accept, var::make<connection_t>(conn));
+				}
+			}
+
+			void resume_listeners()
+			{
+				clock_type::time_point now = clock_type::now();
+				for (auto it = m_paused.begin(); it != m_paused.end();) {
+					if (it->first <= now) {
+						if (!it->second->m_closed)
+							update(*it->second, event::readable);
+						it = m_paused.erase(it);
+					}
+					else
+						++it;
+				}
+			}
+
+			void receive(const connection_t &conn)
+			{
+				char buff[64 * 1024];
+				long count = event::read_some(conn->m_handle, buff, sizeof(buff));
+				if (count > 0) {
+					if (conn->m_on_data.usable())
+						invoke(conn->m_on_data, var::make<connection_t>(conn), var::make<string>(buff, count));
+				}
+				else if (count == 0 || !event::would_block()) {
+					if (count < 0)
+						conn->m_error = event::last_error();
+					close(*conn);
+				}
+			}
+
+			void dispatch(const event::ready_event &ev)
+			{
+				auto it = m_conns.find(ev.handle);
+				if (it == m_conns.end())
+					return;
+				connection_t conn = it->second;
+				if (conn->m_kind == connection::kinds::listener) {
+					accept(conn);
+					return;
+				}
+				if (conn->m_connecting) {
+					conn->m_connecting = false;
+					conn->m_error = event::connect_error(conn->m_handle);
+					bool success = conn->m_error.empty();
+					if (success)
+						flush(*conn);
+					if (conn->m_on_connect.usable())
+						invoke(conn->m_on_connect, var::make<connection_t>(conn), success);
+					if (!success)
+						close(*conn);
+					return;
+				}
+				if ((ev.events & event::writable) && !conn->m_closed)
+					flush(*conn);
+				if ((ev.events & event::readable) && !conn->m_closed)
+					receive(conn);
+			}
+
+			static unsigned short to_port(number port)
+			{
+				if (!std::isfinite(port) || port != std::floor(port) || port < 0 || port > 65535)
+					throw lang_error("Port must be an integer between 0 and 65535.");
+				return static_cast<unsigned short>(port);
+			}
+
+			// Waits no longer than the time point, -1 means infinite
+			static void shorten_wait(clock_type::time_point time, int &wait_time)
+			{
+				auto rest = std::chrono::duration_cast<std::chrono::milliseconds>(time - clock_type::now()).count() + 1;
+				rest = rest < 0 ? 0 : rest;
+				if (wait_time < 0 || rest < wait_time)
+					wait_time = static_cast<int>(rest);
+			}
+
+			void fire_timers()
+			{
+				clock_type::time_point now = clock_type::now();
+				// The repeating timers fire at most once in a round
+				std::vector<std::size_t> due;
+				for (; !m_queue.empty() && m_queue.top().first <= now; m_queue.pop())
+					due.push_back(m_queue.top().second);
+				for (auto id:due) {
+					auto it = m_timers.find(id);
+					// Cancelled
+					if (it == m_timers.end())
+						continue;
+					var func = it->second.func;
+					if (it->second.repeat)
+						m_queue.emplace(now + it->second.interval, id);
+					else
+						m_timers.erase(it);
+					invoke(func);
+				}
+			}
+
+		public:
+			event_loop() = default;
+
+			event_loop(const event_loop &) = delete;
+
+			~event_loop()
+			{
+				for (auto &it:m_conns) {
+					it.second->m_closed = true;
+					event::close_socket(it.first);
+				}
+			}
+
+			std::size_t set_timer(number time, const var &func, bool repeat)
+			{
+				auto interval = std::chrono::duration_cast<clock_type::duration>(
+				                    std::chrono::duration<double, std::milli>(time < 0 ? 0 : time));
+				m_timers.emplace(++m_timer_id, timer_type{func, interval, repeat});
+				m_queue.emplace(clock_type::now() + interval, m_timer_id);
+				return m_timer_id;
+			}
+
+			bool cancel(std::size_t id)
+			{
+				return m_timers.erase(id) > 0;
+			}
+
+			connection_t listen(const string &host, number port, const var &func)
+			{
+				unsigned short native_port = to_port(port);
+				std::string error;
+				socket_t handle = event::tcp_listen(host, native_port, error);
+				if (handle == event::invalid_socket)
+					throw lang_error("Can not listen on " + host + ":" + std::to_string(native_port) + ", " + error);
+				connection_t conn = attach(handle, connection::kinds::listener, event::readable);
+				conn->m_on_accept = func;
+				return conn;
+			}
+
+			connection_t connect(const string &host, number port, const var &func)
+			{
+				unsigned short native_port = to_port(port);
+				std::string error;
+				socket_t handle = event::tcp_connect(host, native_port, error);
+				if (handle == event::invalid_socket)
+					throw lang_error("Can not connect to " + host + ":" + std::to_string(native_port) + ", " + error);
+				connection_t conn = attach(handle, connection::kinds::stream, event::writable);
+				conn->m_connecting = true;
+				conn->m_on_connect = func;
+				return conn;
+			}
+
+			connection_t attach_pipe(socket_t handle)
+			{
+				if (handle == event::invalid_socket || !event::set_nonblocking(handle))
+					throw lang_error("Can not watch the pipe, " + event::last_error());
+				return attach(handle, connection::kinds::pipe, event::readable);
+			}
+
+			// Returns false when there is nothing to wait for
+			bool run_once(number timeout)
+			{
+				if (m_conns.empty() && m_timers.empty())
+					return false;
+				int wait_time = -1;
+				if (timeout >= 0)
+					wait_time = timeout < (std::numeric_limits<int>::max)() ? static_cast<int>(timeout)
+					            : (std::numeric_limits<int>::max)();
+				if (!m_queue.empty())
+					shorten_wait(m_queue.top().first, wait_time);
+				for (auto &it:m_paused)
+					shorten_wait(it.first, wait_time);
+				m_ready.clear();
+				if (!m_poller.wait(wait_time, m_ready))
+					throw lang_error("Waiting for events failed, " + event::last_error());
+				// Callbacks may wait again, the events are consumed from a copy
+				std::vector<event::ready_event> ready;
+				ready.swap(m_ready);
+				for (auto &ev:ready)
+					dispatch(ev);
+				resume_listeners();
+				fire_timers();
+				return true;
+			}
+
+			void run()
+			{
+				m_stop = false;
+				while (!m_stop && run_once(-1));
+			}
+
+			void stop()
+			{
+				m_stop = true;
+			}
+		};
+
+		void connection::write(const std::string &str)
+		{
+			if (m_kind != kinds::stream)
+				throw lang_error("Only the streams can be written.");
+			if (m_closed || m_closing)
+				throw lang_error("Connection is closed.");
+			event_loop_t loop = m_loop.lock();
+			if (!loop)
+				throw lang_error("Event loop is destroyed.");
+			m_buff.append(str);
+			if (!m_connecting)
+				loop->flush(*this);
+		}
+
+		void connection::close()
+		{
+			event_loop_t loop = m_loop.lock();
+			if (m_closed || !loop)
+				return;
+			// Pending data is sent before closing
+			if (m_buff_pos < m_buff.size() || m_connecting)
+				m_closing = true;
+			else
+				loop->close(*this);
+		}
+
+		event_loop_t loop()
+		{
+			return std::make_shared<event_loop>();
+		}
+
+// Event loop
+		number set_timeout(const event_loop_t &loop, number time, const var &func)
+		{
+			return loop->set_timer(time, func, false);
+		}
+
+		number set_interval(const event_loop_t &loop, number time, const var &func)
+		{
+			return loop->set_timer(time, func, true);
+		}
+
+		bool cancel(const event_loop_t &loop, number id)
+		{
+			return loop->cancel(id);
+		}
+
+		connection_t listen(const event_loop_t &loop, const string &host, number port, const var &func)
+		{
+			return loop->listen(host, port, func);
+		}
+
+		connection_t connect(const event_loop_t &loop, const string &host, number port, const var &func)
+		{
+			return loop->connect(host, port, func);
+		}
+
+#ifndef COVSCRIPT_PLATFORM_WIN32
+
+		connection_t attach_output(const event_loop_t &loop, const process_cs_ext::process_t &process)
+		{
+			return loop->attach_pipe(::dup(process->output_handle()));
+		}
+
+		connection_t attach_error(const event_loop_t &loop, const process_cs_ext::process_t &process)
+		{
+			return loop->attach_pipe(::dup(process->error_handle()));
+		}
+
+#else
+
+		connection_t attach_output(const event_loop_t &, const process_cs_ext::process_t &)
+		{
+			throw lang_error("Pipes can not be watched on this platform.");
+		}
+
+		connection_t attach_error(const event_loop_t &, const process_cs_ext::process_t &)
+		{
+			throw lang_error("Pipes can not be watched on this platform.");
+		}
+
+#endif
+
+		bool run_once(const event_loop_t &loop, number timeout)
+		{
+			return loop->run_once(timeout);
+		}
+
+		void run(const event_loop_t &loop)
+		{
+			loop->run();
+		}
+
+		void stop(const event_loop_t &loop)
+		{
+			loop->stop();
+		}
+
+// Connection
+		void on_data(const connection_t &conn, const var &func)
+		{
+			conn->on_data(func);
+		}
+
+		void on_close(const connection_t &conn, const var &func)
+		{
+			conn->on_close(func);
+		}
+
+		void write(const connection_t &conn, const string &str)
+		{
+			conn->write(str);
+		}
+
+		void close(const connection_t &conn)
+		{
+			conn->close();
+		}
+
+		bool is_open(const connection_t &conn)
+		{
+			return conn->is_open();
+		}
+
+		string error(const connection_t &conn)
+		{
+			return conn->error();
+		}
+
+		number port(const connection_t &conn)
+		{
+			return conn->port();
+		}
+
+		void init()
+		{
+			(*event_ext)
+			.add_var("event_loop", make_namespace(event_loop_ext))
+			.add_var("connection", make_namespace(connection_ext))
+			.add_var("loop", make_cni(loop));
+			(*event_loop_ext)
+			.add_var("set_timeout", make_cni(set_timeout))
+			.add_var("set_interval", make_cni(set_interval))
+			.add_var("cancel", make_cni(cancel))
+			.add_var("listen", make_cni(listen))
+			.add_var("connect", make_cni(connect))
+			.add_var("attach_output", make_cni(attach_output))
+			.add_var("attach_error", make_cni(attach_error))
+			.add_var("run_once", make_cni(run_once))
+			.add_var("run", make_cni(run))
+			.add_var("stop", make_cni(stop));
+			(*connection_ext)
+			.add_var("on_data", make_cni(on_data))
+			.add_var("on_close", make_cni(on_close))
+			.add_var("write", make_cni(write))
+			.add_var("close", make_cni(close))
+			.add_var("is_open", make_cni(is_open))
+			.add_var("error", make_cni(error))
+			.add_var("port", make_cni(port));
+		}
+	}
+
 	namespace system_cs_ext {
 		using namespace cs;
 
@@ -1232,14 +4443,19 @@ namespace cs_impl {
 		{
 			console_cs_ext::init();
 			file_cs_ext::init();
+			mapped_file_cs_ext::init();
 			path_cs_ext::init();
+			process_cs_ext::init();
 			(*system_ext)
 			.add_var("console", make_namespace(console_ext))
 			.add_var("file", make_namespace(file_ext))
 			.add_var("path", make_namespace(path_ext))
 			.add_var("in", var::make_protect<istream>(&std::cin, [](std::istream *) {}))
 			.add_var("out", var::make_protect<ostream>(&std::cout, [](std::ostream *) {}))
+			.add_var("process", make_namespace(process_ext))
 			.add_var("run", make_cni(run))
+			.add_var("spawn", make_cni(process_cs_ext::spawn))
+			.add_var("run_all", make_cni(process_cs_ext::run_all))
 			.add_var("getenv", make_cni(getenv))
 			.add_var("exit", make_cni(exit));
 		}
@@ -1257,15 +4473,25 @@ namespace cs_impl {
 			ostream_cs_ext::init();
 			system_cs_ext::init();
 			runtime_cs_ext::init();
+			event_cs_ext::init();
 			math_cs_ext::init();
 #endif
 			except_cs_ext::init();
+			iterator_cs_ext::init();
 			char_cs_ext::init();
 			string_cs_ext::init();
 			list_cs_ext::init();
 			array_cs_ext::init();
 			pair_cs_ext::init();
 			hash_map_cs_ext::init();
+			byte_buffer_cs_ext::init();
+			concurrent_hash_map_cs_ext::init();
+			priority_queue_cs_ext::init();
+			ordered_map_cs_ext::init();
+			ordered_set_cs_ext::init();
+			bitset_cs_ext::init();
+			persistent_vector_cs_ext::init();
+			persistent_map_cs_ext::init();
 		}
 	}
 }
\ No newline at end of file
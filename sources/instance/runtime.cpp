@@ -397,10 +397,16 @@ namespace cs {
 			return carr[posit];
 		}
 		else if (a.type() == typeid(hash_map)) {
-			const auto &cmap = a.const_val<hash_map>();
-			if (cmap.count(b) == 0)
-				a.val<hash_map>().emplace(copy(b), number(0));
-			return cmap.at(b);
+			// Constant maps can only be read, missing keys are inserted with zero in the others
+			if (a.is_constant()) {
+				const auto &cmap = a.const_val<hash_map>();
+				auto it = cmap.find(b);
+				if (it != cmap.end())
+					return it->second;
+			}
+			return a.val<hash_map>().find_or_emplace(b, [] {
+				return var::make<number>(0);
+			}).first->second;
 		}
 		else if (a.type() == typeid(string)) {
 			if (b.type() != typeid(number))
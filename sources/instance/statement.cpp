@@ -18,6 +18,7 @@
 * Email: mikecovlee@163.com
 * Github: https://github.com/mikecovlee
 */
+#include <covscript_impl/coroutine/coroutine.hpp>
 #include <covscript/impl/statement.hpp>
 #include <iostream>
 
@@ -29,13 +30,6 @@ namespace cs {
 			    "Wrong size of arguments.Expected " + std::to_string(this->mArgs.size()) + ",provided " +
 			    std::to_string(args.size()));
 		scope_guard scope(mContext);
-#ifdef CS_DEBUGGER
-		fcall_guard fcall(mContext, mDecl);
-		if(mMatch)
-			cs_debugger_func_callback(mDecl, mStmt);
-#else
-		fcall_guard fcall(mContext);
-#endif
 		if (mIsVargs) {
 			var arg_list = var::make<cs::array>();
 			auto &arr = arg_list.val<cs::array>();
@@ -50,6 +44,16 @@ namespace cs {
 			for (std::size_t i = 0; i < args.size(); ++i)
 				mContext->instance->storage.add_var(this->mArgs[i], args[i]);
 		}
+		// The body of a generator runs later, the arguments are carried by the generator
+		if (mIsGenerator)
+			return var::make<iterator_t>(std::make_shared<generator>(mContext, mBody));
+#ifdef CS_DEBUGGER
+		fcall_guard fcall(mContext, mDecl);
+		if(mMatch)
+			cs_debugger_func_callback(mDecl, mStmt);
+#else
+		fcall_guard fcall(mContext);
+#endif
 		for (auto &ptr:this->mBody) {
 			try {
 				ptr->run();
@@ -71,6 +75,8 @@ namespace cs {
 	var struct_builder::operator()()
 	{
 		scope_guard scope(mContext);
+		std::size_t parent_size = 0;
+		std::shared_ptr<struct_layout> parent_layout;
 		if (mParent.root().usable()) {
 			var builder = mContext->instance->parse_expr(mParent.root());
 			if (builder.type() == typeid(type_t)) {
@@ -80,7 +86,11 @@ namespace cs {
 				var parent = t.constructor();
 				if (parent.type() == typeid(structure)) {
 					parent.protect();
-					mContext->instance->storage.involve_domain(parent.const_val<structure>().get_domain());
+					const structure &s = parent.const_val<structure>();
+					parent_layout = s.get_shared_layout();
+					parent_size = parent_layout->size();
+					for (std::size_t i = 0; i < parent_size; ++i)
+						mContext->instance->storage.add_var(s.get_layout().get_name(i), s.get_var_by_offset(i));
 					mContext->instance->storage.add_var("parent", parent, true);
 				}
 				else
@@ -100,7 +110,17 @@ namespace cs {
 				throw exception(ptr->get_line_num(), ptr->get_file_path(), ptr->get_raw_code(), e.what());
 			}
 		}
-		return var::make<structure>(this->mTypeId, this->mName, scope.get());
+		const domain_type &domain = scope.get();
+		// The members are defined in the same order every time, so the layout is only built again for another parent
+		if (!mLayout || mParentLayout != parent_layout || mLayout->size() != domain.size()) {
+			mLayout = std::make_shared<struct_layout>(mTypeId, typeid(structure).name() + mName, domain, parent_size);
+			mParentLayout = std::move(parent_layout);
+		}
+		std::vector<var> data;
+		data.reserve(domain.size());
+		for (std::size_t i = 0; i < domain.size(); ++i)
+			data.push_back(domain.get_var_by_id(i));
+		return var::make<structure>(mLayout, std::move(data));
 	}
 
 	void statement_expression::run()
@@ -576,6 +596,34 @@ namespace cs {
 		o << "< EndFor >\n";
 	}
 
+	// Returns false if the loop should stop
+	bool foreach_step(const context_t &context, std::deque<statement_base *> &body)
+	{
+		for (auto &ptr:body) {
+			try {
+				ptr->run();
+			}
+			catch (const cs::exception &e) {
+				throw e;
+			}
+			catch (const std::exception &e) {
+				throw exception(ptr->get_line_num(), ptr->get_file_path(), ptr->get_raw_code(), e.what());
+			}
+			if (context->instance->return_fcall) {
+				return false;
+			}
+			if (context->instance->break_block) {
+				context->instance->break_block = false;
+				return false;
+			}
+			if (context->instance->continue_block) {
+				context->instance->continue_block = false;
+				break;
+			}
+		}
+		return true;
+	}
+
 	template<typename T, typename X>
 	void foreach_helper(const context_t &context, const string &iterator, const var &obj,
 	                    std::deque<statement_base *> &body)
@@ -590,28 +638,25 @@ namespace cs {
 		for (const X &it:obj.const_val<T>()) {
 			scope.clear();
 			context->instance->storage.add_var(iterator, it);
-			for (auto &ptr:body) {
-				try {
-					ptr->run();
-				}
-				catch (const cs::exception &e) {
-					throw e;
-				}
-				catch (const std::exception &e) {
-					throw exception(ptr->get_line_num(), ptr->get_file_path(), ptr->get_raw_code(), e.what());
-				}
-				if (context->instance->return_fcall) {
-					return;
-				}
-				if (context->instance->break_block) {
-					context->instance->break_block = false;
-					return;
-				}
-				if (context->instance->continue_block) {
-					context->instance->continue_block = false;
-					break;
-				}
-			}
+			if (!foreach_step(context, body))
+				return;
+		}
+	}
+
+	void foreach_iterator(const context_t &context, const string &iterator, iterator_base &it,
+	                      std::deque<statement_base *> &body)
+	{
+		if (context->instance->break_block)
+			context->instance->break_block = false;
+		if (context->instance->continue_block)
+			context->instance->continue_block = false;
+		scope_guard scope(context);
+		var val;
+		// Release the last element before asking for the next one, so it can be reused in place
+		for (scope.clear(); it.next(val); scope.clear()) {
+			context->instance->storage.add_var(iterator, val);
+			if (!foreach_step(context, body))
+				return;
 		}
 	}
 
@@ -627,8 +672,12 @@ namespace cs {
 			foreach_helper<array, var>(context, this->mIt, obj, this->mBlock);
 		else if (obj.type() == typeid(hash_map))
 			foreach_helper<hash_map, pair>(context, this->mIt, obj, this->mBlock);
-		else if (obj.type() == typeid(range_type))
-			foreach_helper<range_type, number>(context, this->mIt, obj, this->mBlock);
+		else if (obj.type() == typeid(range_type)) {
+			range_generator it(obj.const_val<range_type>());
+			foreach_iterator(context, this->mIt, it, this->mBlock);
+		}
+		else if (obj.type() == typeid(iterator_t))
+			foreach_iterator(context, this->mIt, *obj.const_val<iterator_t>(), this->mBlock);
 		else
 			throw runtime_error("Unsupported type(foreach)");
 	}
@@ -712,32 +761,178 @@ namespace cs {
 		o << " >\n";
 	}
 
+	void statement_yield::run()
+	{
+		CS_DEBUGGER_STEP(this);
+		generator::yield(context->instance->parse_expr(this->mTree.root()));
+	}
+
+	void statement_yield::dump(std::ostream &o) const
+	{
+		o << "< Yield: ";
+		compiler_type::dump_expr(mTree.root(), o);
+		o << " >\n";
+	}
+
+	generator *generator::current = nullptr;
+
+	generator::generator(context_t c, std::deque<statement_base *> body) : m_context(std::move(c)),
+		m_body(std::move(body)), m_domains(1)
+	{
+		// Take over the arguments, which are bound in the current domain
+		m_context->instance->storage.swap_domain(m_domains.front());
+		// Slot of the return value, which is written by the return statement
+		m_frames.push_back(null_pointer);
+	}
+
+	generator::~generator()
+	{
+		// Unwind the suspended body, so the objects living on its stack are destroyed
+		if (m_fiber && !m_finished && !m_running && m_context->instance) {
+			m_cancel = true;
+			try {
+				resume();
+			}
+			catch (...) {
+			}
+		}
+	}
+
+	void generator::run_body()
+	{
+		try {
+			for (auto &ptr:m_body) {
+				try {
+					ptr->run();
+				}
+				catch (const cs::exception &e) {
+					throw e;
+				}
+				catch (const std::exception &e) {
+					throw exception(ptr->get_line_num(), ptr->get_file_path(), ptr->get_raw_code(), e.what());
+				}
+				if (m_context->instance->return_fcall) {
+					m_context->instance->return_fcall = false;
+					return;
+				}
+			}
+		}
+		catch (const generator_exit &) {
+		}
+	}
+
+	void generator::resume()
+	{
+		domain_manager &storage = m_context->instance->storage;
+		std::size_t domain_base = storage.domain_depth();
+		std::size_t frame_base = current_process->stack.size();
+		for (auto &domain:m_domains) {
+			storage.add_domain();
+			storage.swap_domain(domain);
+		}
+		for (auto &frame:m_frames)
+			current_process->stack.push(frame);
+		m_frames.clear();
+		generator *caller = current;
+		current = this;
+		m_running = true;
+		std::exception_ptr error;
+		try {
+			m_fiber->resume();
+		}
+		catch (...) {
+			error = std::current_exception();
+		}
+		current = caller;
+		m_running = false;
+		m_finished = m_fiber->finished();
+		if (m_finished)
+			m_domains.clear();
+		else
+			m_domains.resize(storage.domain_depth() - domain_base);
+		for (std::size_t i = m_domains.size(); i > 0; --i) {
+			storage.swap_domain(m_domains[i - 1]);
+			storage.remove_domain();
+		}
+		while (storage.domain_depth() > domain_base)
+			storage.remove_domain();
+		while (current_process->stack.size() > frame_base) {
+			if (!m_finished)
+				m_frames.push_front(current_process->stack.top());
+			current_process->stack.pop_no_return();
+		}
+		if (error)
+			std::rethrow_exception(error);
+	}
+
+	bool generator::next(var &val)
+	{
+		if (m_running)
+			throw runtime_error("Generator is already running.");
+		if (m_finished)
+			return false;
+		if (!m_fiber)
+			m_fiber.reset(new cs_impl::coroutine::fiber([this]() { run_body(); }));
+		try {
+			resume();
+		}
+		catch (...) {
+			m_fiber.reset();
+			throw;
+		}
+		if (m_finished) {
+			// Release the stack as soon as the body returns
+			m_fiber.reset();
+			return false;
+		}
+		val = std::move(m_value);
+		m_value = var();
+		return true;
+	}
+
+	void generator::yield(const var &val)
+	{
+		generator *self = current;
+		if (self == nullptr)
+			throw runtime_error("Yield outside generator.");
+		self->m_value = val;
+		self->m_fiber->suspend();
+		if (self->m_cancel)
+			throw generator_exit();
+	}
+
 	void statement_try::run()
 	{
 		CS_DEBUGGER_STEP(this);
 		scope_guard scope(context);
+		// The catch body runs after the handler has exited, so a generator may yield inside it
+		bool caught = false;
+		lang_error error;
 		for (auto &ptr:mTryBody) {
 			try {
 				ptr->run();
 			}
 			catch (const lang_error &le) {
-				scope.clear();
-				context->instance->storage.add_var(mName, le);
-				for (auto &ptr:mCatchBody) {
-					try {
-						ptr->run();
-					}
-					catch (const cs::exception &e) {
-						throw e;
-					}
-					catch (const std::exception &e) {
-						throw exception(ptr->get_line_num(), ptr->get_file_path(), ptr->get_raw_code(), e.what());
-					}
-					if (context->instance->return_fcall || context->instance->break_block ||
-					        context->instance->continue_block)
-						break;
-				}
-				return;
+				error = le;
+				caught = true;
+				break;
+			}
+			catch (const cs::exception &e) {
+				throw e;
+			}
+			catch (const std::exception &e) {
+				throw exception(ptr->get_line_num(), ptr->get_file_path(), ptr->get_raw_code(), e.what());
+			}
+			if (context->instance->return_fcall || context->instance->break_block || context->instance->continue_block)
+				break;
+		}
+		if (!caught)
+			return;
+		scope.clear();
+		context->instance->storage.add_var(mName, error);
+		for (auto &ptr:mCatchBody) {
+			try {
+				ptr->run();
 			}
 			catch (const cs::exception &e) {
 				throw e;
@@ -176,6 +176,7 @@ int main(int args_size, const char *args[])
 		errorcode = cs::current_process->exit_code;
 	}
 	catch (const std::exception &e) {
+		std::cout.flush();
 		if (!log_path.empty()) {
 			std::ofstream out(::log_path);
 			if (out) {
@@ -189,6 +190,7 @@ int main(int args_size, const char *args[])
 		errorcode = -1;
 	}
 	catch (...) {
+		std::cout.flush();
 		if (!log_path.empty()) {
 			std::ofstream out(::log_path);
 			if (out) {
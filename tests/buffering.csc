@@ -0,0 +1,16 @@
+var path="./buffering_test.txt"
+var out=iostream.fstream(path,iostream.openmode.out)
+system.out.println(out.get_buffering()==iostream.buffering.full)
+out.println("first")
+out.write_all({1,2.5,"three"})
+out.set_buffering(iostream.buffering.line)
+out.print("last")
+out.flush()
+var in=iostream.fstream(path,iostream.openmode.in)
+while !in.eof()
+    var line=in.getline()
+    if !line.empty()
+        system.out.println(line)
+    end
+end
+system.file.remove(path)
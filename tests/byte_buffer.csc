@@ -0,0 +1,47 @@
+var path="./byte_buffer_test.bin"
+var buff=new byte_buffer
+buff.append_uint(258,2,iostream.endian.big)
+buff.append_uint(258,2,iostream.endian.little)
+buff.append_int(-2,4,iostream.endian.little)
+buff.append_float(1.5,iostream.endian.big)
+buff.append_double(-0.25,iostream.endian.little)
+buff.append_string("CovScript")
+system.out.println(buff.size())
+system.out.println(buff.at(0))
+system.out.println(buff.at(1))
+system.out.println(buff.get_uint(0,2,iostream.endian.big))
+system.out.println(buff.get_uint(2,2,iostream.endian.little))
+system.out.println(buff.get_int(4,4,iostream.endian.little))
+system.out.println(buff.get_uint(4,4,iostream.endian.little))
+system.out.println(buff.get_float(8,iostream.endian.big))
+system.out.println(buff.get_double(12,iostream.endian.little))
+system.out.println(buff.slice(20,3).to_string())
+var out=iostream.fstream(path,iostream.openmode.bin_out)
+out.write(buff)
+out.flush()
+var in=iostream.fstream(path,iostream.openmode.bin_in)
+var head=in.read(4)
+system.out.println(head.size())
+var rest=in.read_all()
+system.out.println(rest.size())
+system.out.println(rest.get_int(0,4,iostream.endian.little))
+var again=iostream.fstream(path,iostream.openmode.bin_in)
+system.out.println(again.read(1000000000000).size())
+var file=system.file.map(path)
+system.out.println(file.size())
+system.out.println(file.get_double(12,iostream.endian.little))
+var name=file.slice(20,9)
+system.out.println(name.to_string())
+system.out.println(name.slice(3,6).to_buffer().to_string())
+try
+    file.at(29)
+catch e
+    system.out.println(e.what())
+end
+# Open files and mappings can not be removed on Windows
+in=null
+again=null
+out=null
+file=null
+name=null
+system.file.remove(path)
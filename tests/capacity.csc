@@ -0,0 +1,28 @@
+var map=hash_map.with_capacity(10000)
+var cap=map.capacity()
+for i=0,i<10000,++i
+    map.insert(i,i)
+end
+system.out.println(to_string(cap>=10000)+" "+to_string(map.capacity()==cap))
+var words=new hash_map
+words.reserve(1000)
+words.insert(1,1)
+words.insert("a",2)
+system.out.println(to_string(words.capacity()>=1000)+" "+to_string(words.get("a",0)))
+words.clear()
+words.shrink_to_fit()
+system.out.println(words.size())
+var str=string.with_capacity(4096)
+system.out.println(to_string(str.capacity()>=4096)+" "+to_string(str.size()))
+var buf=""
+buf.reserve(100)
+for i=0,i<10,++i
+    buf.append(i)
+end
+buf.shrink_to_fit()
+system.out.println(buf+" "+to_string(buf.capacity()>=buf.size()))
+var arr={1,2,3}
+arr.pop_back()
+arr.shrink_to_fit()
+system.out.println(arr.size())
+system.out.println("a-b-c".replace_all("-","--"))
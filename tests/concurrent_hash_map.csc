@@ -0,0 +1,21 @@
+var a=new concurrent_hash_map
+foreach it in {"a","b","a","c","a","b"}
+    a.insert_or_update(it,1,[](x,y)->x+y)
+end
+system.out.println("Size="+to_string(a.size()))
+system.out.println("a="+to_string(a.get_or_default("a",0)))
+system.out.println("d="+to_string(a.get_or_default("d",0)))
+a.erase_if("a",[](x)->x>5)
+a.erase_if("b",[](x)->x==2)
+system.out.println(a.exist("a"))
+system.out.println(a.exist("b"))
+var b=a.to_hash_map()
+system.out.println("Size="+to_string(b.size()))
+a.insert("list",{1})
+var shared=a.get_or_default("list",null)
+shared.push_back(2)
+system.out.println(a.get_or_default("list",null).size())
+a.insert("n",1)
+a.insert_or_update("n",1,[](x,y)->a.get_or_default("n",0)+x+y)
+system.out.println("n="+to_string(a.get_or_default("n",0)))
+system.out.println(a.erase_if("n",[](x)->a.exist("n")))
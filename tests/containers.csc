@@ -0,0 +1,80 @@
+var queue=new priority_queue
+foreach it in {5,1,4,2,3}
+    queue.push(it)
+end
+system.out.println(to_string(queue.top())+" "+to_string(queue.size()))
+queue.pop()
+system.out.println(queue.top())
+var tasks=new priority_queue
+tasks.push(3:"write")
+tasks.push(1:"read")
+tasks.push(2:"parse")
+while !tasks.empty()
+    system.out.print(tasks.top().second()+" ")
+    tasks.pop()
+end
+system.out.println("")
+var map=new ordered_map
+for i=0,i<5000,++i
+    map.insert((i*7919)%5000, i)
+end
+system.out.println(map.size())
+system.out.println(to_string(map.first().first())+" "+to_string(map.last().first()))
+map.insert(10,"ten")
+system.out.println(map.get(10))
+system.out.println(map.get_or_default(-1,"none"))
+for i=0,i<5000,i+=2
+    map.erase(i)
+end
+system.out.println(map.size())
+system.out.println(map.exist(10))
+system.out.println(map.lower_bound(10).first())
+system.out.println(map.upper_bound(4999)==null)
+foreach it in map.range(100,110)
+    system.out.print(to_string(it.first())+" ")
+end
+system.out.println("")
+var sum=0
+foreach it in map.iterate()
+    sum+=it.first()
+end
+system.out.println(sum)
+var set=new ordered_set
+foreach it in {"pear","apple","fig","apple"}
+    set.insert(it)
+end
+system.out.println(set.size())
+foreach it in set.iterate()
+    system.out.print(it+" ")
+end
+system.out.println("")
+system.out.println(set.range("b","g").size())
+system.out.println(set.iterate().take(2).to_array().back())
+var keys=set.range("a","z")
+keys[0]="zzz"
+foreach it in set.iterate()
+    it="zzz"
+end
+system.out.println(set.first()+" "+to_string(set.exist("apple")))
+try
+    set.insert(1)
+catch e
+    system.out.println(e.what())
+end
+var bits=new bitset
+bits.resize(130)
+bits.set(3)
+bits.set(64)
+bits.set(129)
+system.out.println(to_string(bits.count())+" "+to_string(bits.find_first())+" "+to_string(bits.find_next(4))+" "+to_string(bits.find_next(65)))
+var mask=new bitset
+mask.resize(130)
+mask.set_all()
+mask.reset(64)
+bits.and_with(mask)
+system.out.println(to_string(bits.count())+" "+to_string(bits.test(64)))
+var small=new bitset
+small.resize(5)
+small.flip(1)
+small.flip(4)
+system.out.println(to_string(small))
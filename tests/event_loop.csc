@@ -0,0 +1,64 @@
+var loop=runtime.event.loop()
+var received=new hash_map
+var closed=0
+var server=loop.listen("127.0.0.1",0,[](conn)->conn.on_data([](conn,data)->conn.write("echo:"+data)))
+var port=server.port()
+system.out.println(port>0)
+var sent=0
+function client()
+    var conn=loop.connect("127.0.0.1",port,[](conn,ok)->ok?conn.write("client "+to_string(++sent)):null)
+    conn.on_data([](conn,data)->finish(conn,data))
+    return conn
+end
+function finish(conn,data)
+    received.insert(data,true)
+    conn.close()
+end
+for i=0,i<20,++i
+    client().on_close([](conn)->++closed)
+end
+var ticks=0
+var interval=loop.set_interval(1,[]()->++ticks)
+loop.set_timeout(5,[]()->loop.cancel(interval))
+loop.set_timeout(50,[]()->server.close())
+var cancelled=loop.set_timeout(10,[]()->system.out.println("never"))
+system.out.println(loop.cancel(cancelled))
+loop.run()
+system.out.println(received.size())
+system.out.println(received.exist("echo:client 7"))
+system.out.println(closed)
+system.out.println(ticks>0)
+system.out.println(server.is_open())
+var output=""
+function collect(conn,data)
+    output+=data
+end
+var p=system.spawn({"sh","-c","echo from the pipe"})
+loop.attach_output(p).on_data(collect)
+loop.run()
+system.out.println(output)
+system.out.println(p.wait())
+var refused=null
+function on_refused(conn,ok)
+    refused=conn.error()
+end
+loop.connect("127.0.0.1",port,on_refused)
+loop.run()
+system.out.println(refused)
+var late=system.spawn({"sh","-c","sleep 0.2; echo late >&2"})
+loop.attach_error(late).close()
+system.out.println(late.error().getline())
+late.wait()
+try
+    loop.listen("127.0.0.1",70000,[](conn)->null)
+catch e
+    system.out.println(e.what())
+end
+try
+    loop.connect("127.0.0.1",80.5,[](conn,ok)->null)
+catch e
+    system.out.println(e.what())
+end
+var idle=runtime.event.loop()
+idle.set_timeout(1,[]()->system.out.println("after a long timeout"))
+idle.run_once(10000000000000)
@@ -0,0 +1,23 @@
+var path="./file_io_test.txt"
+var copy_path="./file_io_copy.txt"
+var text=new string
+for i=0,i<1000,++i
+    text.append("line " + to_string(i) + "\n")
+end
+system.out.println(system.file.write_all(path,text))
+system.out.println(system.file.exists(path))
+system.out.println(system.file.size(path)==text.size())
+system.out.println(system.file.mtime(path)>0)
+system.out.println(system.file.copy(path,copy_path))
+system.out.println(system.file.read_all(copy_path)==text)
+system.out.println(system.file.write_all(path,"replaced"))
+system.out.println(system.file.read_all(path))
+system.out.println(system.file.copy("./file_io_not_exist.txt",copy_path))
+try
+    system.file.size("./file_io_not_exist.txt")
+catch e
+    system.out.println(e.what())
+end
+system.file.remove(path)
+system.file.remove(copy_path)
+system.out.println(system.file.exists(path))
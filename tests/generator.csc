@@ -0,0 +1,92 @@
+function show(arr)
+    var str=""
+    foreach it in arr
+        str+=to_string(it)+" "
+    end
+    system.out.println(str)
+end
+function count_up(begin, end_)
+    for i=begin,i<end_,++i
+        yield i
+    end
+end
+foreach i in count_up(0, 5)
+    system.out.println(i)
+end
+function fib()
+    var a=0
+    var b=1
+    loop
+        yield a
+        var t=a+b
+        a=b
+        b=t
+    end
+end
+show(fib().take(10).to_array())
+function evens(src)
+    foreach n in src
+        if n%2==0
+            yield n
+        end
+    end
+end
+show(evens(count_up(0, 10)).to_array())
+function first_only()
+    yield "first"
+    return
+    yield "never"
+end
+show(first_only().to_array())
+function nothing()
+    if false
+        yield 0
+    end
+end
+system.out.println(nothing().to_array().size())
+function failing()
+    yield 1
+    throw runtime.exception("failed inside generator")
+end
+try
+    foreach v in failing()
+        system.out.println(v)
+    end
+catch e
+    system.out.println(e.what())
+end
+function guarded()
+    try
+        yield 1
+        throw runtime.exception("caught inside")
+    catch e
+        yield e.what()
+    end
+    yield 3
+end
+show(guarded().to_array())
+# Leaving the loop early destroys the suspended generator
+var total=0
+foreach i in count_up(0, 1000000)
+    if i==3
+        break
+    end
+    total+=i
+end
+system.out.println(total)
+# Constant memory over a long stream
+var sum=0
+foreach i in count_up(0, 100000)
+    sum+=i
+end
+system.out.println(sum)
+struct counter
+    var step=2
+    function range(n)
+        for i=0,i<n,++i
+            yield i*this.step
+        end
+    end
+end
+var c=new counter
+show(c.range(4).to_array())
@@ -0,0 +1,26 @@
+var words=new hash_map
+foreach it in "the cat and the dog and the bird".split({' '})
+    ++words[it]
+end
+system.out.println(to_string(words.size())+" "+to_string(words["the"])+" "+to_string(words.exist(1)))
+words.insert(1,"one")
+words.insert('c',"char")
+system.out.println(to_string(words.size())+" "+words[1]+" "+words['c']+" "+to_string(words["and"]))
+words.erase("the")
+system.out.println(to_string(words.size())+" "+to_string(words.exist("the")))
+var nums=new hash_map
+for i=0,i<1000,++i
+    nums[i%100]=i
+end
+system.out.println(to_string(nums.size())+" "+to_string(nums[7]))
+nums.clear()
+nums.insert("a",1)
+system.out.println(nums.at("a"))
+var copied=words
+copied.insert("extra",0)
+system.out.println(to_string(copied.size()-words.size()))
+var total=0
+foreach it in nums
+    total+=it.second()
+end
+system.out.println(total)
@@ -0,0 +1,11 @@
+var counts=new hash_map
+foreach it in "a b a c a b".split({' '})
+    counts.update(it,[](n)->n+1)
+end
+system.out.println(to_string(counts["a"])+" "+to_string(counts["b"])+" "+to_string(counts["c"]))
+system.out.println(to_string(counts.get("a",-1))+" "+to_string(counts.get("z",-1))+" "+to_string(counts.exist("z")))
+counts.insert("a",10)
+system.out.println(counts.update("a",[](n)->n*2))
+var names=new hash_map
+names.update(1,[](n)->"one")
+system.out.println(names.get(1,"none")+" "+names.get(2,"none")+" "+to_string(names.size()))
@@ -0,0 +1,34 @@
+var squares=range(10).iterate().map([](x)->x*x).filter([](x)->x%2==0)
+foreach it in squares
+    system.out.print(to_string(it)+" ")
+end
+system.out.println("")
+foreach it in {"a","b","c"}.iterate().enumerate()
+    system.out.print(to_string(it.first())+":"+it.second()+" ")
+end
+system.out.println("")
+foreach it in "abc".iterate().zip(range(1,10))
+    system.out.print(to_string(it.first())+to_string(it.second())+" ")
+end
+system.out.println("")
+var lst={1,2}.to_list()
+var arr=lst.iterate().chain({3,4}).chain(range(5,100)).take(6).to_array()
+foreach it in arr
+    system.out.print(to_string(it)+" ")
+end
+system.out.println("")
+var kept={}
+foreach i in range(3)
+    kept.push_back(i)
+end
+system.out.println(to_string(kept[0])+to_string(kept[1])+to_string(kept[2]))
+var changing={1,2,3}.to_list()
+var pending=changing.iterate()
+changing.clear()
+try
+    foreach it in pending
+        system.out.println(it)
+    end
+catch e
+    system.out.println(e.what())
+end
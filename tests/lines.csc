@@ -0,0 +1,31 @@
+var path="./lines_test.txt"
+var out=iostream.fstream(path,iostream.openmode.out)
+out.println("first")
+out.println("")
+var long=new string
+for i=0,i<20000,++i
+    long.append("0123456789")
+end
+out.println(long)
+out.print("last")
+out.flush()
+var count=0
+foreach line in iostream.lines(path)
+    ++count
+    if line.size()>100
+        system.out.println(line.size())
+    else
+        system.out.println("[" + line + "]")
+    end
+end
+system.out.println(count)
+var in=iostream.fstream(path,iostream.openmode.in)
+var sizes=in.lines().map([](line)->line.size()).to_array()
+system.out.println(sizes.size())
+system.out.println(sizes.back())
+try
+    iostream.lines("./lines_not_exist.txt")
+catch e
+    system.out.println(e.what())
+end
+system.file.remove(path)
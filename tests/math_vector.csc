@@ -0,0 +1,23 @@
+var data={3,-1,4,-1,5,9,-2,6}
+system.out.println(math.vector.sum(data))
+system.out.println(math.vector.mean(data))
+system.out.println(math.vector.variance({2,4,4,4,5,5,7,9}))
+system.out.println(to_string(math.vector.min(data))+" "+to_string(math.vector.max(data)))
+system.out.println(to_string(math.vector.argmin(data))+" "+to_string(math.vector.argmax(data)))
+system.out.println(math.vector.dot({1,2,3},{4,5,6}))
+system.out.println(math.vector.abs(data)[1])
+system.out.println(math.vector.pow({1,2,3},2)[2])
+system.out.println(math.vector.sqrt({16})[0])
+system.out.println(math.vector.exp({0})[0]+math.vector.sin({0})[0]+math.vector.cos({0})[0]+math.vector.ln({1})[0])
+var big=math.rand_array(300000,0,1)
+var total=0
+foreach it in big
+    total+=it
+end
+system.out.println(math.abs(math.vector.sum(big)-total)<0.000001)
+system.out.println(math.vector.max(big)==big[math.vector.argmax(big)])
+try
+    math.vector.sum({1,"a"})
+catch e
+    system.out.println(e.what())
+end
@@ -0,0 +1,44 @@
+var root="./path_walk_fixture"
+system.run("rm -rf " + root)
+system.run("mkdir -p " + root + "/sub/deep")
+system.file.write_all(root + "/alpha.hpp","alpha")
+system.file.write_all(root + "/beta.h","beta")
+system.file.write_all(root + "/sub/gamma.hpp","gamma")
+system.file.write_all(root + "/sub/deep/delta_conio.hpp","delta")
+system.file.write_all(root + "/sub/deep/epsilon.txt","epsilon")
+system.run("ln -s alpha.hpp " + root + "/link.hpp")
+var names=new hash_map
+var count=0
+foreach entry in system.path.walk(root,"*")
+    ++count
+    names.insert(entry.name(),entry)
+end
+system.out.println(count)
+system.out.println(count==names.size())
+system.out.println(names.at("sub").type()==system.path.type.dir)
+system.out.println(names.at("deep").type()==system.path.type.dir)
+system.out.println(names.at("alpha.hpp").type()==system.path.type.reg)
+system.out.println(names.at("link.hpp").type()==system.path.type.lnk)
+system.out.println(names.at("link.hpp").size()==names.at("alpha.hpp").size())
+system.out.println(names.at("epsilon.txt").size()==system.file.size(names.at("epsilon.txt").path()))
+system.out.println(names.at("epsilon.txt").mtime()==system.file.mtime(names.at("epsilon.txt").path()))
+var headers=new hash_map
+foreach entry in system.path.walk(root,{"h","hpp"})
+    headers.insert(entry.name(),entry)
+end
+system.out.println(headers.size())
+system.out.println(headers.exist("beta.h") && headers.exist("gamma.hpp") && !headers.exist("epsilon.txt"))
+foreach entry in system.path.walk(root,"[a-c]*.h?p")
+    if entry.name()!="alpha.hpp"
+        system.out.println("Unexpected " + entry.name())
+    end
+end
+system.out.println(system.path.walk(root,"*_conio.hpp").to_array().size())
+var first=system.path.walk(root,"").take(1).to_array()
+system.out.println(first.size())
+system.run("rm -rf " + root)
+try
+    system.path.walk("./path_walk_not_exist","*")
+catch e
+    system.out.println(e.what())
+end
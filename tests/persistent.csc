@@ -0,0 +1,65 @@
+var v0=new persistent_vector
+var v=v0
+for i=0,i<2000,++i
+    v=v.push_back(i)
+end
+system.out.println(to_string(v0.size())+" "+to_string(v.size())+" "+to_string(v.at(1234))+" "+to_string(v.back()))
+var w=v.set(7,"seven")
+system.out.println(to_string(v.at(7))+" "+w.at(7))
+var u=v
+for i=0,i<1990,++i
+    u=u.pop_back()
+end
+system.out.println(to_string(u.size())+" "+to_string(u.back())+" "+to_string(v.size()))
+var sum=0
+foreach it in u.iterate()
+    sum+=it
+end
+system.out.println(sum)
+var f=persistent_vector.from_array({1,2,3,{4,5}})
+system.out.println(to_string(f.size())+" "+to_string(f==f.set(0,1))+" "+to_string(f==f.set(0,9)))
+var arr=f.to_array()
+arr[3].push_back(6)
+system.out.println(to_string(arr[3].size())+" "+to_string(f.at(3).size()))
+var m0=new persistent_map
+var m=m0
+for i=0,i<1000,++i
+    m=m.insert(i,i*i)
+end
+var m2=m.insert("name","map").erase(10)
+system.out.println(to_string(m.size())+" "+to_string(m2.size())+" "+to_string(m.get(10))+" "+to_string(m2.exist(10))+" "+m2.get("name"))
+system.out.println(m2.get_or_default(10,-1))
+var m3=m2
+for i=0,i<1000,++i
+    m3=m3.erase(i)
+end
+system.out.println(to_string(m3.size())+" "+to_string(m3.exist("name"))+" "+to_string(m2.size()))
+var total=0
+foreach it in m.iterate()
+    total+=it.second()
+end
+system.out.println(total)
+var h=m3.to_hash_map()
+system.out.println(h["name"])
+math.seed(7)
+var pm=new persistent_map
+var hm=new hash_map
+var snapshot=null
+for i=0,i<20000,++i
+    var k=math.randint(0,3000)
+    if math.randint(0,2)==0
+        pm=pm.erase(k)
+        hm.erase(k)
+    else
+        pm=pm.insert(k,i)
+        hm.insert(k,i)
+    end
+    if i==10000
+        snapshot=pm
+    end
+end
+var same=pm.size()==hm.size()
+foreach it in hm
+    same=same&&pm.get(it.first())==it.second()
+end
+system.out.println(to_string(same)+" "+to_string(snapshot.size()!=pm.size()||snapshot!=pm))
@@ -0,0 +1,44 @@
+var p=system.spawn({"sh","-c","echo hello; echo oops 1>&2; exit 3"})
+system.out.println(p.output().getline())
+system.out.println(p.error().getline())
+system.out.println(p.wait())
+system.out.println(p.poll())
+system.out.println(p.exit_code())
+var cat=system.spawn({"cat"})
+cat.input().println("through the pipe")
+cat.close_input()
+system.out.println(cat.output().read_all().to_string())
+system.out.println(cat.wait())
+var sleeper=system.spawn({"sleep","10"})
+system.out.println(sleeper.poll())
+sleeper.kill()
+system.out.println(sleeper.wait())
+var commands=new array
+for i=0,i<8,++i
+    commands.push_back({"sh","-c","echo task " + to_string(i) + "; exit " + to_string(i)})
+end
+commands.push_back({"covscript_command_not_exist"})
+var results=system.run_all(commands,3)
+for i=0,i<8,++i
+    system.out.println(to_string(results[i]["exit_code"]) + " " + results[i]["output"].cut(1))
+end
+system.out.println(results[8]["exit_code"])
+system.out.println(results[8]["error"])
+try
+    system.spawn({"covscript_command_not_exist"})
+catch e
+    system.out.println(e.what())
+end
+var noisy=system.spawn({"sh","-c","head -c 200000 /dev/zero 1>&2; echo done"})
+system.out.println(noisy.output().getline())
+system.out.println(noisy.error().read_all().size())
+noisy.wait()
+var quiet=system.spawn({"sh","-c","sleep 0.2; echo later"})
+system.out.println(quiet.output().read_some(16).size())
+system.out.println(quiet.output().getline())
+quiet.wait()
+var reader=system.spawn({"sh","-c","exit 0"})
+reader.wait()
+reader.input().println("nobody reads this")
+reader.close_input()
+system.out.println(reader.input().good())
@@ -0,0 +1,19 @@
+math.seed(42)
+var a=math.rand_array(5,0,1)
+var b=math.randint(0,1000)
+math.seed(42)
+var c=math.rand_array(5,0,1)
+system.out.println(a[0]==c[0]&&a[4]==c[4]&&b==math.randint(0,1000))
+var ok=true
+foreach it in math.randint_array(1000,-3,3)
+    if it<-3||it>3||it!=to_integer(it)
+        ok=false
+    end
+end
+foreach it in math.rand_array(1000,2,5)
+    if it<2||it>5
+        ok=false
+    end
+end
+system.out.println(ok)
+system.out.println(math.rand_array(0,0,1).size())
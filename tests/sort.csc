@@ -0,0 +1,58 @@
+function print_all(c)
+    foreach it in c
+        system.out.print(to_string(it)+" ")
+    end
+    system.out.println("")
+end
+var arr={5,3,9,1,7,3}
+arr.sort()
+print_all(arr)
+system.out.println(to_string(arr.lower_bound(3))+" "+to_string(arr.upper_bound(3))+" "+to_string(arr.binary_search(4)))
+arr.sort_with([](a,b)->a>b)
+print_all(arr)
+arr.reverse()
+print_all(arr)
+var words={"pear","fig","apple","kiwi"}
+words.stable_sort_by([](s)->s.size())
+print_all(words)
+words.sort()
+print_all(words)
+var nums={9,8,7,6,5,4,3,2,1}
+nums.partial_sort(3)
+system.out.println(to_string(nums[0])+to_string(nums[1])+to_string(nums[2]))
+nums.nth_element(4)
+system.out.println(nums[4])
+struct record
+    var name=""
+    var age=0
+end
+var people={}
+foreach it in {"Tom":30, "Amy":25, "Bob":30, "Eve":20}
+    var r=new record
+    r.name=it.first()
+    r.age=it.second()
+    people.push_back(r)
+end
+people.stable_sort_by([](r)->r.name)
+people.stable_sort_by([](r)->r.age)
+foreach it in people
+    system.out.print(it.name+" ")
+end
+system.out.println("")
+var lst={'c','a','b'}.to_list()
+lst.sort()
+print_all(lst)
+lst.sort_by([](c)->0-to_integer(c))
+print_all(lst)
+var mixed={1,"a"}
+try
+    mixed.sort()
+catch e
+    system.out.println(e.what())
+end
+var same={}
+for i=1, i<=3000, ++i
+    same.push_back(1)
+end
+same.sort_with([](x,y)->x<=y)
+system.out.println(same.size())
@@ -6,3 +6,23 @@ system.out.println(str.substr(str.rfind("Hello",-1),5))
 system.out.println(str.replace(str.find("Hello",0),5,"FUCK"))
 system.out.println(str.erase(str.find("FUCK",0),4))
 system.out.println(str.insert(str.find("d",0)+1,"Hello"))
+var text="The Quick, brown fox; jumps over the lazy dog. "
+var long=new string
+for i=0,i<200,++i
+    long+=text
+end
+var words=long.split({' ', ',', ';', '.'})
+system.out.println(words.size())
+system.out.println(words.front()+" "+words.back())
+system.out.println(",,a,,b,".split({','}).size())
+system.out.println(long.toupper().substr(0,20))
+system.out.println(long.tolower().substr(0,20))
+system.out.println(long.find("lazy dog",0))
+system.out.println(long.find("lazy dog",100))
+system.out.println(long.find("lazy cat",0))
+system.out.println(long.find("",5))
+var copy=long
+copy.replace_all("fox", "cat")
+system.out.println(copy.find("fox",0))
+system.out.println(copy.size()==long.size())
+system.out.println("a-b-c".replace_all("-", "::"))
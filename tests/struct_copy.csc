@@ -0,0 +1,58 @@
+struct grand
+    var x=1
+    function get_x()
+        return x
+    end
+end
+struct base extends grand
+    var y=2
+end
+struct child extends base
+    var z=3
+    function get_x() override
+        return this.x*100
+    end
+end
+var a=new child
+var b=a
+b.z=30
+b.y=20
+b.x=10
+system.out.println(to_string(a.x)+" "+to_string(a.y)+" "+to_string(a.z))
+system.out.println(to_string(b.x)+" "+to_string(b.y)+" "+to_string(b.z))
+# Inherited members are shared with the parent object
+system.out.println(b.parent.y)
+system.out.println(b.parent.parent.x)
+b.parent.parent.x=5
+system.out.println(b.x)
+system.out.println(b.get_x())
+system.out.println(b.parent.get_x())
+system.out.println(a==b)
+var c=b
+system.out.println(c==b)
+var objs={}
+foreach i in range(1000)
+    objs.push_back(new child)
+end
+objs[10].z=-1
+system.out.println(objs[10].z+objs[11].z)
+struct first_parent
+    var x=1
+end
+struct second_parent
+    var y=2
+end
+var use_second=false
+function pick()
+    if use_second
+        return second_parent
+    else
+        return first_parent
+    end
+end
+struct picked extends pick()
+    var z=3
+end
+system.out.println((new picked).x)
+use_second=true
+system.out.println((new picked).y)
@@ -0,0 +1,19 @@
+struct node
+    var name="node"
+    var next=null
+    function rename(n)
+        name=n
+    end
+end
+var a=new node
+var b=new node
+a.rename("first")
+system.out.println(a.name+" "+b.name)
+var s="node"
+s+="s"
+var t="node"
+system.out.println(s+" "+t+" "+to_string("node"=="node"))
+namespace shapes
+    var name="shapes"
+end
+system.out.println(shapes.name+" "+to_string(typeid a==typeid b))
@@ -0,0 +1,66 @@
+var map={"a":1,"b":2,"c":3}.to_hash_map()
+var keys=""
+var sum=0
+foreach k in map.keys()
+    keys+=k
+end
+foreach v in map.values()
+    sum+=v
+end
+system.out.println(to_string(keys.size())+" "+to_string(sum))
+var swapped={}.to_hash_map()
+for i=0,i<8,++i
+    swapped.insert(i,i)
+end
+var steps=0
+try
+    foreach k in swapped.keys()
+        ++steps
+        swapped.erase(k)
+        swapped.insert(k+100,k)
+    end
+catch e
+    system.out.println(to_string(steps)+" "+e.what())
+end
+try
+    foreach k in map.keys()
+        map.erase(k)
+    end
+catch e
+    system.out.println(e.what())
+end
+var lst={1,2,3,4,5,6}.to_list()
+var part=""
+foreach it in lst.view(2,3)
+    part+=to_string(it)
+end
+foreach it in lst.view(4,100)
+    part+=to_string(it)
+end
+system.out.println(part)
+var stale=lst.view(1,3)
+lst.clear()
+try
+    stale.to_array()
+catch e
+    system.out.println(e.what())
+end
+try
+    {1,2,3}.view(1.5,2)
+catch e
+    system.out.println(e.what())
+end
+var arr={1,2,3,4,5,6}
+var picked=arr.view(1,2).to_array()
+system.out.println(to_string(picked.size())+" "+to_string(picked[0]+picked[1]))
+var src={1:"one",2:"two"}
+var moved=move(src).to_hash_map()
+system.out.println(to_string(moved.size())+" "+moved[2]+" "+to_string(src.size()))
+var data={1,2,3}
+var copied=data.to_list()
+copied.push_back(4)
+system.out.println(to_string(data.size())+" "+to_string(copied.size()))
+var back=move(copied).to_array()
+system.out.println(to_string(back.size())+" "+to_string(copied.size()))
+var dup={1:"a",1:"b"}.to_hash_map()
+system.out.println(dup[1])